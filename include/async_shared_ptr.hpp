@@ -0,0 +1,276 @@
+/*
+    异步析构：最后一个引用释放时，对象的收尾工作（刷盘、排空队列等）被调度到执行器上，
+    释放引用的线程不被阻塞。托管类型提供 void async_dispose(my_ptr::async_done done)，
+    完成收尾后调用 done()（可以在任意线程、任意时刻）；随后对象被析构、内存被释放，
+    因此调用 done() 之后不能再访问对象。
+    C++17 没有协程，这里用一次性回调表达"异步完成"
+*/
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include "shared_ptr.hpp"
+#include "detail/control_block.hpp"
+#include "detail/futex.hpp"
+
+namespace my_ptr {
+
+namespace detail {
+
+// 异步控制块的公共部分：收尾完成标志与等待。
+// 控制块在收尾完成时才标记为已销毁，weak_ptr::wait_until_expired 因而也等到对象真正析构
+class async_control_block_base : public control_block_base {
+protected:
+    std::atomic<std::uint32_t> finished_;
+
+    // 析构托管对象（收尾完成后调用）
+    virtual void destroy_object() noexcept = 0;
+
+    // 隐含的弱引用保活控制块，直到 finish() 调用 finish_dispose()
+    bool deferred_dispose() const noexcept override { return true; }
+
+public:
+    async_control_block_base() noexcept : control_block_base(), finished_(0) {}
+
+    // 收尾完成：析构对象，唤醒 teardown_handle 的等待者，
+    // 最后标记已销毁（唤醒 wait_until_expired）并归还隐含的弱引用，在此之前控制块一直有效
+    void finish() noexcept {
+        destroy_object();
+        finished_.store(1, std::memory_order_release);
+        futex_wake_all(finished_);
+        finish_dispose();
+    }
+
+    bool finished() const noexcept {
+        return finished_.load(std::memory_order_acquire) != 0;
+    }
+
+    bool wait_finished(const std::chrono::nanoseconds *timeout = nullptr) noexcept {
+        auto deadline = std::chrono::steady_clock::now() + (timeout ? *timeout : std::chrono::nanoseconds(0));
+        while (!finished()) {
+            if (timeout) {
+                auto remaining = deadline - std::chrono::steady_clock::now();
+                if (remaining <= std::chrono::nanoseconds(0)) {
+                    return false;
+                }
+                std::chrono::nanoseconds rel = std::chrono::duration_cast<std::chrono::nanoseconds>(remaining);
+                futex_wait(finished_, 0, &rel);
+            } else {
+                futex_wait(finished_, 0);
+            }
+        }
+        return true;
+    }
+};
+
+} // namespace detail
+
+// 一次性完成回调：调用 operator() 表示收尾结束。未调用就被销毁时视为已完成
+class async_done {
+private:
+    detail::async_control_block_base *cb_;
+
+public:
+    explicit async_done(detail::async_control_block_base *cb) noexcept : cb_(cb) {}
+
+    async_done(async_done&& other) noexcept : cb_(other.cb_) {
+        other.cb_ = nullptr;
+    }
+
+    async_done& operator=(async_done&& other) noexcept {
+        if (this != &other) {
+            (*this)();
+            cb_ = other.cb_;
+            other.cb_ = nullptr;
+        }
+        return *this;
+    }
+
+    async_done(const async_done&) = delete;
+    async_done& operator=(const async_done&) = delete;
+
+    ~async_done() {
+        (*this)();
+    }
+
+    void operator()() noexcept {
+        if (cb_) {
+            std::exchange(cb_, nullptr)->finish();
+        }
+    }
+};
+
+namespace detail {
+
+template <typename T, typename = void>
+struct has_async_dispose : std::false_type {};
+
+template <typename T>
+struct has_async_dispose<T, std::void_t<decltype(std::declval<T&>().async_dispose(std::declval<async_done>()))>>
+    : std::true_type {};
+
+// 对象与控制块一起分配；最终释放时 dispose() 只把收尾任务投递到执行器
+template <typename T, typename Executor>
+class async_control_block : public async_control_block_base {
+private:
+    Executor *executor_;
+    alignas(alignof(T)) unsigned char storage_[sizeof(T)];
+
+    void start() noexcept {
+        try {
+            get()->async_dispose(async_done(this));
+        } catch (...) {
+            // async_dispose 同步抛出：async_done 已随栈展开完成收尾
+        }
+    }
+
+protected:
+    void destroy_object() noexcept override {
+        get()->~T();
+    }
+
+public:
+    template <typename... Args>
+    explicit async_control_block(Executor& executor, Args&&... args)
+        : async_control_block_base(), executor_(&executor) {
+        new (storage_) T(std::forward<Args>(args)...);
+    }
+
+    // 隐含的弱引用在 finish() 之前一直保活控制块
+    void dispose() noexcept override {
+        try {
+            executor_->post([this]() { start(); });
+        } catch (...) {
+            start(); // 投递失败时就地执行
+        }
+    }
+
+    void destroy() noexcept override {
+        delete this;
+    }
+
+    T *get() noexcept {
+        return reinterpret_cast<T*>(storage_);
+    }
+};
+
+} // namespace detail
+
+// 观察对象异步收尾的句柄：持有控制块的弱引用，可等待收尾完成
+class teardown_handle {
+private:
+    detail::async_control_block_base *cb_;
+
+public:
+    teardown_handle() noexcept : cb_(nullptr) {}
+
+    explicit teardown_handle(detail::async_control_block_base *cb) noexcept : cb_(cb) {
+        if (cb_) {
+            cb_->add_weak_ref();
+        }
+    }
+
+    teardown_handle(const teardown_handle& other) noexcept : teardown_handle(other.cb_) {}
+
+    teardown_handle(teardown_handle&& other) noexcept : cb_(std::exchange(other.cb_, nullptr)) {}
+
+    teardown_handle& operator=(teardown_handle other) noexcept {
+        std::swap(cb_, other.cb_);
+        return *this;
+    }
+
+    ~teardown_handle() {
+        if (cb_) {
+            cb_->release_weak();
+        }
+    }
+
+    // 对象已被析构（收尾已完成）
+    bool done() const noexcept {
+        return !cb_ || cb_->finished();
+    }
+
+    // 阻塞直到收尾完成。对象仍有其它强引用时，会一直等到它们也被释放
+    void wait() const noexcept {
+        if (cb_) {
+            cb_->wait_finished();
+        }
+    }
+
+    template <typename Rep, typename Period>
+    bool wait_for(const std::chrono::duration<Rep, Period>& timeout) const noexcept {
+        if (!cb_) {
+            return true;
+        }
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout);
+        return cb_->wait_finished(&ns);
+    }
+};
+
+// 析构经执行器异步完成的共享指针。与普通 shared_ptr 共用控制块，释放语义完全相同，
+// 区别只在最后一个引用释放之后：收尾在执行器上进行，调用者可用 release_async() 拿到句柄等待
+template <typename T>
+class async_shared_ptr {
+public:
+    using element_type = T;
+
+private:
+    shared_ptr<T> ptr_;
+
+    detail::async_control_block_base *control_block() const noexcept {
+        return static_cast<detail::async_control_block_base*>(detail::shared_ptr_access::control_block(ptr_));
+    }
+
+    explicit async_shared_ptr(shared_ptr<T>&& ptr) noexcept : ptr_(std::move(ptr)) {}
+
+    template <typename U, typename Executor, typename... Args>
+    friend async_shared_ptr<U> make_async_shared(Executor& executor, Args&&... args);
+
+public:
+    async_shared_ptr() noexcept = default;
+    async_shared_ptr(std::nullptr_t) noexcept {}
+
+    // 放弃本引用，返回可等待对象收尾的句柄
+    teardown_handle release_async() noexcept {
+        teardown_handle handle(control_block());
+        ptr_.reset();
+        return handle;
+    }
+
+    // 观察收尾但不放弃引用
+    teardown_handle teardown() const noexcept {
+        return teardown_handle(control_block());
+    }
+
+    void reset() noexcept { ptr_.reset(); }
+
+    void swap(async_shared_ptr& other) noexcept { ptr_.swap(other.ptr_); }
+
+    // 以普通 shared_ptr 传递给不关心异步析构的代码
+    const shared_ptr<T>& shared() const noexcept { return ptr_; }
+
+    T *get() const noexcept { return ptr_.get(); }
+    T& operator*() const noexcept { return *ptr_; }
+    T *operator->() const noexcept { return ptr_.get(); }
+    explicit operator bool() const noexcept { return static_cast<bool>(ptr_); }
+    long use_count() const noexcept { return ptr_.use_count(); }
+};
+
+// 在一次分配中创建对象与异步控制块。Executor 需提供 post(F)（例如 my_ptr::thread_pool），
+// 并且要活得比对象的收尾更久
+template <typename T, typename Executor, typename... Args>
+async_shared_ptr<T> make_async_shared(Executor& executor, Args&&... args) {
+    static_assert(detail::has_async_dispose<T>::value, "T must provide void async_dispose(my_ptr::async_done)");
+    auto *cb = new detail::async_control_block<T, Executor>(executor, std::forward<Args>(args)...);
+    return async_shared_ptr<T>(detail::shared_ptr_access::adopt<shared_ptr<T>>(cb, cb->get()));
+}
+
+template <typename T>
+void swap(async_shared_ptr<T>& lhs, async_shared_ptr<T>& rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+} // namespace my_ptr
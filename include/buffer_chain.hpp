@@ -0,0 +1,330 @@
+#pragma once
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include "shared_buffer.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MY_PTR_HAS_WRITEV 1
+#include <climits>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace my_ptr {
+
+namespace detail {
+
+// 链中的段头：一个切片加前后指针
+struct chain_segment {
+    buffer_slice data;
+    chain_segment *prev;
+    chain_segment *next;
+};
+
+// 线程局部的段头池：频繁的 append/split 不再为每个段头调用分配器
+class segment_pool {
+private:
+    static constexpr std::size_t max_free = 1024;
+
+    chain_segment *free_ = nullptr; // 空闲链表经 next 串联
+    std::size_t free_count_ = 0;
+
+public:
+    // 线程退出后仍可能有静态对象释放段头：之后的 release 直接交还分配器
+    ~segment_pool() {
+        while (free_) {
+            chain_segment *s = free_;
+            free_ = s->next;
+            ::operator delete(s);
+        }
+        free_count_ = max_free;
+    }
+
+    static segment_pool& local() noexcept {
+        thread_local segment_pool pool;
+        return pool;
+    }
+
+    chain_segment *acquire(buffer_slice data) {
+        void *mem;
+        if (free_) {
+            mem = free_;
+            free_ = free_->next;
+            --free_count_;
+        } else {
+            mem = ::operator new(sizeof(chain_segment));
+        }
+        return new (mem) chain_segment{std::move(data), nullptr, nullptr};
+    }
+
+    void release(chain_segment *s) noexcept {
+        s->~chain_segment();
+        if (free_count_ >= max_free) {
+            ::operator delete(s);
+            return;
+        }
+        s->next = free_;
+        free_ = s;
+        ++free_count_;
+    }
+};
+
+} // namespace detail
+
+// 由引用计数切片组成的分散缓冲链（IOBuf 风格）。
+// append/prepend/split 只移动段头，不拷贝字节；coalesce 在需要连续内存时才拷贝一次；
+// 可导出 iovec 数组直接交给 writev
+class buffer_chain {
+private:
+    detail::chain_segment *head_;
+    detail::chain_segment *tail_;
+    std::size_t bytes_;
+    std::size_t segments_;
+
+    // append_copy 的尾部缓冲：小片数据拷贝进同一块缓冲，相邻写入合并为一个段
+    shared_buffer scratch_;
+    std::size_t scratch_used_;
+
+    static constexpr std::size_t scratch_size = 4096;
+
+    void link_back(detail::chain_segment *s) noexcept {
+        s->prev = tail_;
+        s->next = nullptr;
+        if (tail_) {
+            tail_->next = s;
+        } else {
+            head_ = s;
+        }
+        tail_ = s;
+        bytes_ += s->data.size();
+        ++segments_;
+    }
+
+    void link_front(detail::chain_segment *s) noexcept {
+        s->prev = nullptr;
+        s->next = head_;
+        if (head_) {
+            head_->prev = s;
+        } else {
+            tail_ = s;
+        }
+        head_ = s;
+        bytes_ += s->data.size();
+        ++segments_;
+    }
+
+    void unlink(detail::chain_segment *s) noexcept {
+        (s->prev ? s->prev->next : head_) = s->next;
+        (s->next ? s->next->prev : tail_) = s->prev;
+        bytes_ -= s->data.size();
+        --segments_;
+    }
+
+public:
+    buffer_chain() noexcept
+        : head_(nullptr), tail_(nullptr), bytes_(0), segments_(0), scratch_(), scratch_used_(0) {}
+
+    ~buffer_chain() {
+        clear();
+    }
+
+    buffer_chain(buffer_chain&& other) noexcept : buffer_chain() {
+        swap(other);
+    }
+
+    buffer_chain& operator=(buffer_chain&& other) noexcept {
+        buffer_chain(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    buffer_chain(const buffer_chain&) = delete;
+    buffer_chain& operator=(const buffer_chain&) = delete;
+
+    void swap(buffer_chain& other) noexcept {
+        std::swap(head_, other.head_);
+        std::swap(tail_, other.tail_);
+        std::swap(bytes_, other.bytes_);
+        std::swap(segments_, other.segments_);
+        std::swap(scratch_, other.scratch_);
+        std::swap(scratch_used_, other.scratch_used_);
+    }
+
+    // ---- 构建 ----
+    void append(buffer_slice slice) {
+        if (!slice.empty()) {
+            link_back(detail::segment_pool::local().acquire(std::move(slice)));
+        }
+    }
+
+    void prepend(buffer_slice slice) {
+        if (!slice.empty()) {
+            link_front(detail::segment_pool::local().acquire(std::move(slice)));
+        }
+    }
+
+    // 把 other 的全部段接到末尾，other 变为空
+    void append(buffer_chain&& other) noexcept {
+        if (!other.head_) {
+            return;
+        }
+        if (tail_) {
+            tail_->next = other.head_;
+            other.head_->prev = tail_;
+        } else {
+            head_ = other.head_;
+        }
+        tail_ = other.tail_;
+        bytes_ += other.bytes_;
+        segments_ += other.segments_;
+        other.head_ = other.tail_ = nullptr;
+        other.bytes_ = other.segments_ = 0;
+    }
+
+    // 拷贝小片数据（帧头、分隔符等）；写入尾部缓冲，与上一次拷贝相邻时扩展同一个段
+    void append_copy(const void *src, std::size_t n) {
+        if (n == 0) {
+            return;
+        }
+        if (n > scratch_size / 4) {
+            append(shared_buffer(src, n).slice());
+            return;
+        }
+        if (scratch_.empty() || scratch_used_ + n > scratch_.size()) {
+            scratch_ = shared_buffer(scratch_size);
+            scratch_used_ = 0;
+        }
+        char *dst = scratch_.data() + scratch_used_;
+        std::memcpy(dst, src, n);
+        if (tail_ && tail_->data.end() == dst) {
+            // 扩展尾段：尾段从尾部缓冲的某处开始、到 dst 结束
+            std::size_t start = static_cast<std::size_t>(tail_->data.data() - scratch_.data());
+            bytes_ += n;
+            tail_->data = scratch_.slice(start, scratch_used_ + n - start);
+        } else {
+            append(scratch_.slice(scratch_used_, n));
+        }
+        scratch_used_ += n;
+    }
+
+    // ---- 拆分与合并 ----
+    // 切下前 n 个字节作为新链返回；跨越边界的段被拆成两个切片，不拷贝字节
+    buffer_chain split(std::size_t n) {
+        if (n > bytes_) {
+            throw std::out_of_range("buffer_chain::split");
+        }
+        buffer_chain front;
+        while (n > 0) {
+            detail::chain_segment *s = head_;
+            if (s->data.size() <= n) {
+                n -= s->data.size();
+                unlink(s);
+                front.link_back(s);
+            } else {
+                front.append(s->data.slice(0, n));
+                bytes_ -= n;
+                s->data = std::move(s->data).slice(n);
+                n = 0;
+            }
+        }
+        return front;
+    }
+
+    // 合并为一个连续切片；已是单段时零拷贝
+    buffer_slice coalesce() {
+        if (segments_ == 0) {
+            return buffer_slice();
+        }
+        if (segments_ > 1) {
+            shared_buffer merged(bytes_);
+            char *dst = merged.data();
+            for (detail::chain_segment *s = head_; s; s = s->next) {
+                std::memcpy(dst, s->data.data(), s->data.size());
+                dst += s->data.size();
+            }
+            clear();
+            append(merged.slice());
+        }
+        return head_->data;
+    }
+
+    void clear() noexcept {
+        auto& pool = detail::segment_pool::local();
+        while (head_) {
+            detail::chain_segment *s = head_;
+            head_ = s->next;
+            pool.release(s);
+        }
+        tail_ = nullptr;
+        bytes_ = 0;
+        segments_ = 0;
+    }
+
+    // ---- 访问 ----
+    std::size_t size() const noexcept { return bytes_; }
+    std::size_t segment_count() const noexcept { return segments_; }
+    bool empty() const noexcept { return bytes_ == 0; }
+
+    template <typename F>
+    void for_each_segment(F&& f) const {
+        for (detail::chain_segment *s = head_; s; s = s->next) {
+            f(s->data);
+        }
+    }
+
+#if defined(MY_PTR_HAS_WRITEV)
+    // 从第 skip 个段开始填充至多 max 个 iovec，返回填充的个数
+    std::size_t fill_iovec(iovec *iov, std::size_t max, std::size_t skip = 0) const noexcept {
+        detail::chain_segment *s = head_;
+        for (; s && skip; --skip) {
+            s = s->next;
+        }
+        std::size_t n = 0;
+        for (; s && n < max; s = s->next, ++n) {
+            iov[n].iov_base = const_cast<char*>(s->data.data());
+            iov[n].iov_len = s->data.size();
+        }
+        return n;
+    }
+
+    // 用 writev 把整条链写入 fd（处理部分写入和 IOV_MAX），链内容不变；出错抛出 std::system_error
+    void write_to(int fd) const {
+        constexpr std::size_t batch = IOV_MAX < 64 ? IOV_MAX : 64;
+        iovec iov[batch];
+        detail::chain_segment *s = head_;
+        while (s) {
+            std::size_t n = 0;
+            for (; s && n < batch; s = s->next, ++n) {
+                iov[n].iov_base = const_cast<char*>(s->data.data());
+                iov[n].iov_len = s->data.size();
+            }
+            iovec *cur = iov;
+            while (n > 0) {
+                ssize_t w = ::writev(fd, cur, static_cast<int>(n));
+                if (w < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    throw std::system_error(errno, std::generic_category(), "buffer_chain::write_to");
+                }
+                std::size_t left = static_cast<std::size_t>(w);
+                while (n > 0 && left >= cur->iov_len) {
+                    left -= cur->iov_len;
+                    ++cur;
+                    --n;
+                }
+                if (n > 0) {
+                    cur->iov_base = static_cast<char*>(cur->iov_base) + left;
+                    cur->iov_len -= left;
+                }
+            }
+        }
+    }
+#endif
+};
+
+} // namespace my_ptr
@@ -0,0 +1,298 @@
+/*
+    weak_ptr 数组的批量 expired()/lock()。
+    逐个调用 expired() 是一串互相独立、却被循环顺序串起来的缓存缺失；批量版本按组提前预取控制块，
+    并在 x86-64 上用 AVX2 / AVX-512 的 gather 一次读取 4 / 8 个强计数，运行时按 CPU 能力选择，
+    其它平台与不支持的 CPU 走带预取的标量实现。
+    与逐个 expired() 一样，结果只是调用时刻的快照
+*/
+#pragma once
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "shared_ptr.hpp"
+#include "weak_ptr.hpp"
+#include "detail/control_block.hpp"
+#include "detail/traits.hpp"
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+#include <span>
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define MY_PTR_BULK_X86 1
+#include <immintrin.h>
+#endif
+
+namespace my_ptr {
+
+// 定长位图：批量操作的结果，第 i 位对应输入的第 i 个元素
+class bitmap {
+private:
+    std::vector<std::uint64_t> words_;
+    std::size_t size_;
+
+public:
+    bitmap() noexcept : size_(0) {}
+    explicit bitmap(std::size_t n) : words_((n + 63) / 64, 0), size_(n) {}
+
+    // 重设为 n 位并全部清零
+    void assign(std::size_t n) {
+        words_.assign((n + 63) / 64, 0);
+        size_ = n;
+    }
+
+    std::size_t size() const noexcept { return size_; }
+
+    bool test(std::size_t i) const noexcept { return (words_[i / 64] >> (i % 64)) & 1; }
+    void set(std::size_t i) noexcept { words_[i / 64] |= std::uint64_t(1) << (i % 64); }
+    void reset(std::size_t i) noexcept { words_[i / 64] &= ~(std::uint64_t(1) << (i % 64)); }
+
+    std::size_t count() const noexcept {
+        std::size_t n = 0;
+        for (std::uint64_t w : words_) {
+            n += std::bitset<64>(w).count();
+        }
+        return n;
+    }
+
+    std::uint64_t *words() noexcept { return words_.data(); }
+    const std::uint64_t *words() const noexcept { return words_.data(); }
+};
+
+namespace detail {
+
+// 批量扫描的输入：base 处起每 stride 字节一个智能指针，控制块指针位于其中 cb_offset 处
+struct bulk_input {
+    const unsigned char *base;
+    std::size_t stride;
+    std::size_t cb_offset;
+    std::size_t n;
+
+    const control_block_base *cb(std::size_t i) const noexcept {
+        return *reinterpret_cast<const control_block_base* const*>(base + i * stride + cb_offset);
+    }
+};
+
+// 强计数字相对控制块基类地址的偏移（对所有控制块相同）
+inline std::ptrdiff_t shared_count_offset() noexcept {
+    static const std::ptrdiff_t offset = [] {
+        const control_block_base& cb = static_control_block::instance();
+        return reinterpret_cast<const char*>(cb.shared_count_word()) - reinterpret_cast<const char*>(&cb);
+    }();
+    return offset;
+}
+
+constexpr std::size_t bulk_prefetch_distance = 64; // 元素个数
+constexpr std::size_t bulk_prefetch_group = 16;
+
+inline void bulk_prefetch_group_at(const bulk_input& in, std::size_t first) noexcept {
+    std::size_t last = first + bulk_prefetch_group < in.n ? first + bulk_prefetch_group : in.n;
+    for (std::size_t j = first; j < last; ++j) {
+        if (const control_block_base *cb = in.cb(j)) {
+            prefetch(cb->shared_count_word());
+        }
+    }
+}
+
+inline bool bulk_is_expired(const control_block_base *cb) noexcept {
+    return !cb ||
+           (cb->shared_count_word()->load(std::memory_order_relaxed) & control_block_base::shared_count_mask()) == 0;
+}
+
+// 标量实现：按组预取，逐个读取计数。from 起处理到末尾，from 必须是 64 的倍数
+inline std::size_t bulk_expired_scalar(const bulk_input& in, std::size_t from, std::uint64_t *out) noexcept {
+    std::size_t expired = 0;
+    std::uint64_t word = 0;
+    for (std::size_t i = from; i < in.n; ++i) {
+        if (i % bulk_prefetch_group == 0 && i + bulk_prefetch_distance < in.n) {
+            bulk_prefetch_group_at(in, i + bulk_prefetch_distance);
+        }
+        // 无分支地累积：存活比例居中时，按结果分支会频繁预测失败
+        std::uint64_t dead = bulk_is_expired(in.cb(i)) ? 1 : 0;
+        word |= dead << (i % 64);
+        expired += static_cast<std::size_t>(dead);
+        if (i % 64 == 63) {
+            out[i / 64] = word;
+            word = 0;
+        }
+    }
+    if (in.n % 64 != 0 && in.n > from) {
+        out[in.n / 64] = word;
+    }
+    return expired;
+}
+
+#if defined(MY_PTR_BULK_X86)
+
+// 以下向量实现要求 stride == 16、cb_offset == 8（weak_ptr 为 {元素指针, 控制块指针}）；
+// 处理完整的 64 元素块，返回处理到的位置，余下部分交给标量实现
+
+__attribute__((target("avx2"))) inline std::size_t bulk_expired_avx2(const bulk_input& in, std::uint64_t *out,
+                                                                      std::size_t& expired) noexcept {
+    const __m256i offset = _mm256_set1_epi64x(shared_count_offset());
+    const __m256i mask = _mm256_set1_epi64x(static_cast<long long>(control_block_base::shared_count_mask()));
+    const __m256i zero = _mm256_setzero_si256();
+    std::size_t full = in.n / 64 * 64;
+    for (std::size_t block = 0; block < full; block += 64) {
+        std::uint64_t word = 0;
+        for (std::size_t k = 0; k < 64; k += 4) {
+            std::size_t i = block + k;
+            if (i % bulk_prefetch_group == 0 && i + bulk_prefetch_distance < in.n) {
+                bulk_prefetch_group_at(in, i + bulk_prefetch_distance);
+            }
+            const __m256i *p = reinterpret_cast<const __m256i*>(in.base + i * 16);
+            __m256i a = _mm256_loadu_si256(p);     // e0 c0 e1 c1
+            __m256i b = _mm256_loadu_si256(p + 1); // e2 c2 e3 c3
+            __m256i cbs = _mm256_permute4x64_epi64(_mm256_unpackhi_epi64(a, b), 0xD8); // c0 c1 c2 c3
+            __m256i present = _mm256_xor_si256(_mm256_cmpeq_epi64(cbs, zero), _mm256_set1_epi64x(-1));
+            __m256i counts = _mm256_mask_i64gather_epi64(zero, static_cast<const long long*>(nullptr),
+                                                         _mm256_add_epi64(cbs, offset), present, 1);
+            __m256i dead = _mm256_cmpeq_epi64(_mm256_and_si256(counts, mask), zero);
+            std::uint64_t bits = static_cast<std::uint64_t>(_mm256_movemask_pd(_mm256_castsi256_pd(dead)));
+            word |= bits << k;
+        }
+        out[block / 64] = word;
+        expired += static_cast<std::size_t>(__builtin_popcountll(word));
+    }
+    return full;
+}
+
+__attribute__((target("avx512f"))) inline std::size_t bulk_expired_avx512(const bulk_input& in, std::uint64_t *out,
+                                                                           std::size_t& expired) noexcept {
+    const __m512i offset = _mm512_set1_epi64(shared_count_offset());
+    const __m512i mask = _mm512_set1_epi64(static_cast<long long>(control_block_base::shared_count_mask()));
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i odd = _mm512_set_epi64(15, 13, 11, 9, 7, 5, 3, 1);
+    std::size_t full = in.n / 64 * 64;
+    for (std::size_t block = 0; block < full; block += 64) {
+        std::uint64_t word = 0;
+        for (std::size_t k = 0; k < 64; k += 8) {
+            std::size_t i = block + k;
+            if (i % bulk_prefetch_group == 0 && i + bulk_prefetch_distance < in.n) {
+                bulk_prefetch_group_at(in, i + bulk_prefetch_distance);
+            }
+            const unsigned char *p = in.base + i * 16;
+            __m512i a = _mm512_loadu_si512(p);
+            __m512i b = _mm512_loadu_si512(p + 64);
+            __m512i cbs = _mm512_permutex2var_epi64(a, odd, b); // 8 个控制块指针
+            __mmask8 present = _mm512_test_epi64_mask(cbs, cbs);
+            __m512i counts = _mm512_mask_i64gather_epi64(zero, present, _mm512_add_epi64(cbs, offset),
+                                                         static_cast<const void*>(nullptr), 1);
+            __mmask8 live = _mm512_test_epi64_mask(counts, mask);
+            word |= static_cast<std::uint64_t>(static_cast<std::uint8_t>(~live)) << k;
+        }
+        out[block / 64] = word;
+        expired += static_cast<std::size_t>(__builtin_popcountll(word));
+    }
+    return full;
+}
+
+#endif
+
+enum class bulk_isa { scalar, avx2, avx512 };
+
+inline bulk_isa detect_bulk_isa() noexcept {
+#if defined(MY_PTR_BULK_X86)
+    static const bulk_isa isa = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) return bulk_isa::avx512;
+        if (__builtin_cpu_supports("avx2")) return bulk_isa::avx2;
+        return bulk_isa::scalar;
+    }();
+    return isa;
+#else
+    return bulk_isa::scalar;
+#endif
+}
+
+inline const char *bulk_isa_name(bulk_isa isa) noexcept {
+    switch (isa) {
+    case bulk_isa::avx512: return "avx512";
+    case bulk_isa::avx2: return "avx2";
+    default: return "scalar";
+    }
+}
+
+// 按 isa 选择实现；布局不符合向量实现的要求或 CPU 不支持时退回标量实现
+inline std::size_t bulk_expired_dispatch(const bulk_input& in, std::uint64_t *out, bulk_isa isa) noexcept {
+    std::size_t done = 0;
+    std::size_t expired = 0;
+#if defined(MY_PTR_BULK_X86)
+    if (in.stride == 16 && in.cb_offset == 8 && isa != bulk_isa::scalar && detect_bulk_isa() != bulk_isa::scalar) {
+        if (isa == bulk_isa::avx512 && detect_bulk_isa() == bulk_isa::avx512) {
+            done = bulk_expired_avx512(in, out, expired);
+        } else {
+            done = bulk_expired_avx2(in, out, expired);
+        }
+    }
+#else
+    (void)isa;
+#endif
+    return expired + bulk_expired_scalar(in, done, out);
+}
+
+template <typename T>
+bulk_input make_bulk_input(const weak_ptr<T> *p, std::size_t n) noexcept {
+    return bulk_input{reinterpret_cast<const unsigned char*>(p), sizeof(weak_ptr<T>),
+                      shared_ptr_access::control_block_offset<weak_ptr<T>>(), n};
+}
+
+} // namespace detail
+
+// 对 [p, p + n) 中已失效（或为空）的 weak_ptr 在 out 中置位，返回失效个数。
+// isa 参数用于比较各实现，默认取 CPU 支持的最快实现
+template <typename T>
+std::size_t bulk_expired(const weak_ptr<T> *p, std::size_t n, bitmap& out,
+                         detail::bulk_isa isa = detail::detect_bulk_isa()) {
+    out.assign(n);
+    return detail::bulk_expired_dispatch(detail::make_bulk_input(p, n), out.words(), isa);
+}
+
+template <typename T>
+std::size_t bulk_expired(const std::vector<weak_ptr<T>>& v, bitmap& out,
+                         detail::bulk_isa isa = detail::detect_bulk_isa()) {
+    return bulk_expired(v.data(), v.size(), out, isa);
+}
+
+// 逐个尝试提升为 shared_ptr，结果写入 out[0, n)（失效的为空），返回成功个数。
+// 提升需要逐个 CAS，无法向量化；批量版本的收益来自成组预取
+template <typename T>
+std::size_t bulk_lock(const weak_ptr<T> *p, std::size_t n, shared_ptr<T> *out) {
+    detail::bulk_input in = detail::make_bulk_input(p, n);
+    std::size_t locked = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (i % detail::bulk_prefetch_group == 0 && i + detail::bulk_prefetch_distance < n) {
+            detail::bulk_prefetch_group_at(in, i + detail::bulk_prefetch_distance);
+        }
+        detail::control_block_base *cb = detail::shared_ptr_access::control_block(p[i]);
+        if (cb && cb->try_add_shared_ref()) {
+            out[i] = detail::shared_ptr_access::adopt<shared_ptr<T>>(cb, detail::shared_ptr_access::pointer(p[i]));
+            ++locked;
+        } else {
+            out[i].reset();
+        }
+    }
+    return locked;
+}
+
+template <typename T>
+std::size_t bulk_lock(const std::vector<weak_ptr<T>>& v, std::vector<shared_ptr<T>>& out) {
+    out.resize(v.size());
+    return bulk_lock(v.data(), v.size(), out.data());
+}
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+template <typename T>
+std::size_t bulk_expired(std::span<const weak_ptr<T>> s, bitmap& out,
+                         detail::bulk_isa isa = detail::detect_bulk_isa()) {
+    return bulk_expired(s.data(), s.size(), out, isa);
+}
+
+template <typename T>
+std::size_t bulk_lock(std::span<const weak_ptr<T>> s, std::span<shared_ptr<T>> out) {
+    return bulk_lock(s.data(), s.size() < out.size() ? s.size() : out.size(), out.data());
+}
+#endif
+
+} // namespace my_ptr
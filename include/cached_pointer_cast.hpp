@@ -0,0 +1,88 @@
+/*
+    带缓存的 dynamic_pointer_cast：热点路径上反复对同几种动态类型做向下转换时，
+    dynamic_cast 每次都要遍历 RTTI 的继承图。这里以源子对象的虚表指针为键，
+    在线程局部的直接映射表中记住"转换是否成功、成功时的指针偏移"，命中时只需一次加法。
+    在 Itanium C++ ABI（GCC/Clang）下，多态子对象的首个字是虚表指针，且同一个虚表指针唯一对应
+    （动态类型，子对象位置），因此偏移只取决于它；其它 ABI 直接退回 dynamic_cast
+*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include "shared_ptr.hpp"
+
+#if defined(__GXX_ABI_VERSION)
+#define MY_PTR_VPTR_CAST_CACHE 1
+#endif
+
+namespace my_ptr {
+
+namespace detail {
+
+// 每个 (From, To) 组合一张线程局部的表，无需任何同步
+template <typename To, typename From>
+struct dynamic_cast_cache {
+    static constexpr std::size_t slots = 64;
+
+    struct entry {
+        const void *vptr;
+        std::ptrdiff_t delta;
+        bool ok;
+    };
+
+    static entry *table() noexcept {
+        static thread_local entry entries[slots] = {};
+        return entries;
+    }
+
+    static To *cast(From *p) noexcept {
+#if defined(MY_PTR_VPTR_CAST_CACHE)
+        const void *vptr = *reinterpret_cast<const void* const*>(p);
+        entry& e = table()[(reinterpret_cast<std::uintptr_t>(vptr) >> 4) % slots];
+        if (e.vptr != vptr) {
+            To *q = dynamic_cast<To*>(p);
+            e.vptr = vptr;
+            e.ok = q != nullptr;
+            e.delta = q ? reinterpret_cast<const char*>(q) - reinterpret_cast<const char*>(p) : 0;
+            return q;
+        }
+        if (!e.ok) {
+            return nullptr;
+        }
+        using byte_type = std::conditional_t<std::is_const_v<From>, const char, char>;
+        return reinterpret_cast<To*>(reinterpret_cast<byte_type*>(p) + e.delta);
+#else
+        return dynamic_cast<To*>(p);
+#endif
+    }
+};
+
+} // namespace detail
+
+// 原始指针版本：p 为空时返回空
+template <typename To, typename From>
+To *cached_dynamic_cast(From *p) noexcept {
+    static_assert(std::is_polymorphic_v<From>, "cached_dynamic_cast needs a polymorphic source type");
+    static_assert(std::is_class_v<To>, "cached_dynamic_cast casts to class pointers only");
+    return p ? detail::dynamic_cast_cache<To, From>::cast(p) : nullptr;
+}
+
+template <typename To, typename From>
+shared_ptr<To> cached_dynamic_pointer_cast(const shared_ptr<From>& p) noexcept {
+    if (To *q = cached_dynamic_cast<To>(p.get())) {
+        return shared_ptr<To>(p, q);
+    }
+    return shared_ptr<To>();
+}
+
+// 右值版本接管源的控制块引用，没有计数操作；失败时源保持不变
+template <typename To, typename From>
+shared_ptr<To> cached_dynamic_pointer_cast(shared_ptr<From>&& p) noexcept {
+    if (To *q = cached_dynamic_cast<To>(p.get())) {
+        return shared_ptr<To>(std::move(p), q);
+    }
+    return shared_ptr<To>();
+}
+
+} // namespace my_ptr
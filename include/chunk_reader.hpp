@@ -0,0 +1,298 @@
+#pragma once
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "shared_ptr.hpp"
+#include "shared_buffer.hpp"
+#include "detail/control_block.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MY_PTR_HAS_PREAD 1
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#endif
+
+namespace my_ptr {
+
+namespace detail {
+
+class chunk_pool;
+
+// 可回收的块控制块：头部与字节区一次分配；最后一个引用释放时不归还内存，而是回到池中
+class pooled_chunk_block : public control_block_base {
+private:
+    shared_ptr<chunk_pool> pool_; // 只在借出期间持有，空闲链表中的块不延长池的寿命
+    pooled_chunk_block *next_free_;
+
+    pooled_chunk_block() noexcept : control_block_base(), pool_(), next_free_(nullptr) {}
+
+    friend class chunk_pool;
+
+public:
+    void dispose() noexcept override {} // 字节无需析构
+
+    void destroy() noexcept override;
+
+    char *data() noexcept {
+        return reinterpret_cast<char*>(this + 1);
+    }
+};
+
+// 固定大小块的池：空闲块串成链表，超过 max_free 的块直接释放
+class chunk_pool {
+private:
+    std::mutex mutex_;
+    pooled_chunk_block *free_;
+    std::size_t free_count_;
+    const std::size_t chunk_size_;
+    const std::size_t max_free_;
+
+    static void free_block(pooled_chunk_block *b) noexcept {
+        b->~pooled_chunk_block();
+        ::operator delete(b);
+    }
+
+public:
+    chunk_pool(std::size_t chunk_size, std::size_t max_free) noexcept
+        : free_(nullptr), free_count_(0), chunk_size_(chunk_size), max_free_(max_free) {}
+
+    ~chunk_pool() {
+        while (free_) {
+            pooled_chunk_block *b = free_;
+            free_ = b->next_free_;
+            free_block(b);
+        }
+    }
+
+    chunk_pool(const chunk_pool&) = delete;
+    chunk_pool& operator=(const chunk_pool&) = delete;
+
+    // 借出一个块，返回的控制块已持有一个强引用
+    static pooled_chunk_block *acquire(const shared_ptr<chunk_pool>& self) {
+        chunk_pool& pool = *self;
+        pooled_chunk_block *b = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(pool.mutex_);
+            if (pool.free_) {
+                b = pool.free_;
+                pool.free_ = b->next_free_;
+                --pool.free_count_;
+            }
+        }
+        if (!b) {
+            void *mem = ::operator new(sizeof(pooled_chunk_block) + pool.chunk_size_);
+            b = new (mem) pooled_chunk_block();
+        }
+        b->pool_ = self;
+        return b;
+    }
+
+    void recycle(pooled_chunk_block *b) noexcept {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (free_count_ < max_free_) {
+                b->next_free_ = free_;
+                free_ = b;
+                ++free_count_;
+                return;
+            }
+        }
+        free_block(b);
+    }
+
+    std::size_t chunk_size() const noexcept { return chunk_size_; }
+
+    std::size_t free_count() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return free_count_;
+    }
+};
+
+inline void pooled_chunk_block::destroy() noexcept {
+    reset_counts();
+    shared_ptr<chunk_pool> pool = std::move(pool_);
+    pool->recycle(this);
+    // pool 析构时可能连同空闲链表（包括本块）一起释放，此后不再访问 this
+}
+
+} // namespace detail
+
+// 流式分块读取文件。后台线程用 pread 预读至多 read_ahead 个块；
+// 每个块是池化缓冲上的 buffer_slice，下游可任意保留，最后一个引用释放时块回到池中
+class chunk_reader {
+private:
+    std::size_t read_ahead_; // 先于 pool_ 初始化：池的空闲上限按规整后的值计算
+    shared_ptr<detail::chunk_pool> pool_;
+
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::deque<buffer_slice> ready_;
+    bool eof_;
+    bool stop_;
+    int error_;
+
+#if defined(MY_PTR_HAS_PREAD)
+    int fd_;
+#else
+    std::ifstream in_;
+#endif
+    std::thread worker_;
+
+    // 读取一个块，返回读到的字节数；0 表示文件结束，-1 表示出错（errno 已设置）
+    long read_chunk(char *dst, std::uint64_t offset) {
+        std::size_t want = pool_->chunk_size();
+        std::size_t got = 0;
+#if defined(MY_PTR_HAS_PREAD)
+        while (got < want) {
+            ssize_t n = ::pread(fd_, dst + got, want - got, static_cast<off_t>(offset + got));
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return -1;
+            }
+            if (n == 0) {
+                break;
+            }
+            got += static_cast<std::size_t>(n);
+        }
+#else
+        (void)offset;
+        in_.read(dst, static_cast<std::streamsize>(want));
+        got = static_cast<std::size_t>(in_.gcount());
+        if (in_.bad()) {
+            errno = EIO;
+            return -1;
+        }
+#endif
+        return static_cast<long>(got);
+    }
+
+    void run() {
+        std::uint64_t offset = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                not_full_.wait(lock, [this]() { return stop_ || ready_.size() < read_ahead_; });
+                if (stop_) {
+                    return;
+                }
+            }
+            detail::pooled_chunk_block *cb;
+            try {
+                cb = detail::chunk_pool::acquire(pool_);
+            } catch (...) {
+                finish(ENOMEM);
+                return;
+            }
+            auto data = detail::shared_ptr_access::adopt<shared_ptr<const char>>(cb, cb->data());
+            long n = read_chunk(cb->data(), offset);
+            if (n <= 0) {
+                finish(n < 0 ? errno : 0);
+                return;
+            }
+            offset += static_cast<std::uint64_t>(n);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                ready_.emplace_back(std::move(data), static_cast<std::size_t>(n));
+            }
+            not_empty_.notify_one();
+        }
+    }
+
+    void finish(int error) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            eof_ = true;
+            error_ = error;
+        }
+        not_empty_.notify_all();
+    }
+
+public:
+    // chunk_size：每块字节数；read_ahead：已读未取的块数上限；
+    // 池中最多缓存 read_ahead * 2 个空闲块
+    explicit chunk_reader(const std::string& path, std::size_t chunk_size = std::size_t(1) << 20,
+                          std::size_t read_ahead = 4)
+        : read_ahead_(read_ahead ? read_ahead : 1), pool_(new detail::chunk_pool(chunk_size, read_ahead_ * 2)),
+          eof_(false), stop_(false), error_(0) {
+#if defined(MY_PTR_HAS_PREAD)
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "chunk_reader: open " + path);
+        }
+#if defined(POSIX_FADV_SEQUENTIAL)
+        ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+        // 构造函数抛出时不会调用析构函数：线程启动成功之前由 guard 负责关闭 fd
+        struct fd_guard {
+            int fd;
+            ~fd_guard() {
+                if (fd >= 0) {
+                    ::close(fd);
+                }
+            }
+        } guard{fd_};
+        worker_ = std::thread([this]() { run(); });
+        guard.fd = -1;
+#else
+        in_.open(path, std::ios::binary);
+        if (!in_) {
+            throw std::system_error(std::make_error_code(std::errc::no_such_file_or_directory),
+                                    "chunk_reader: open " + path);
+        }
+        worker_ = std::thread([this]() { run(); });
+#endif
+    }
+
+    ~chunk_reader() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        not_full_.notify_all();
+        worker_.join();
+#if defined(MY_PTR_HAS_PREAD)
+        ::close(fd_);
+#endif
+    }
+
+    chunk_reader(const chunk_reader&) = delete;
+    chunk_reader& operator=(const chunk_reader&) = delete;
+
+    // 取下一个块；文件结束返回 false，读取出错抛出 std::system_error
+    bool next(buffer_slice& out) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this]() { return !ready_.empty() || eof_; });
+        if (ready_.empty()) {
+            if (error_) {
+                throw std::system_error(error_, std::generic_category(), "chunk_reader: read");
+            }
+            return false;
+        }
+        out = std::move(ready_.front());
+        ready_.pop_front();
+        lock.unlock();
+        not_full_.notify_one();
+        return true;
+    }
+
+    std::size_t chunk_size() const noexcept { return pool_->chunk_size(); }
+
+    // 池中当前空闲的块数
+    std::size_t pooled_chunks() const { return pool_->free_count(); }
+};
+
+} // namespace my_ptr
@@ -0,0 +1,485 @@
+/*
+    可整理的句柄竞技场：对象经句柄表间接访问，因而可以在内存中搬移。
+    对象放在按页映射的块中；compact_step() 每次搬移有限个对象，把稀疏块中的对象挪进稠密块，
+    腾空的块立即归还给操作系统，长期运行、反复分配释放的服务的常驻内存因此不会持续上涨。
+    访问对象需要先 pin：pin 存在期间对象不会被搬移
+*/
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "slot_map.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#ifndef MY_PTR_HAS_MMAP
+#define MY_PTR_HAS_MMAP 1
+#endif
+#include <sys/mman.h>
+#endif
+
+namespace my_ptr {
+
+// 可按字节搬移的类型（搬移后无需调整）；其它类型需要不抛异常的移动构造。
+// 不可平凡拷贝但可按字节搬移的类型可以特化此模板
+template <typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+namespace detail {
+
+template <typename T, typename = void>
+struct has_after_relocate : std::false_type {};
+
+template <typename T>
+struct has_after_relocate<T, std::void_t<decltype(std::declval<T&>().after_relocate())>> : std::true_type {};
+
+// 把对象从 from 搬到 to；类型提供 after_relocate() 时在新位置调用（例如修正自引用、重新登记）
+template <typename T>
+void relocate_object(T *from, void *to) noexcept {
+    if constexpr (is_trivially_relocatable<T>::value) {
+        std::memcpy(to, static_cast<void*>(from), sizeof(T));
+    } else {
+        static_assert(std::is_nothrow_move_constructible_v<T>,
+                      "compacting_arena needs trivially relocatable or nothrow-movable types");
+        new (to) T(std::move(*from));
+        from->~T();
+    }
+    if constexpr (has_after_relocate<T>::value) {
+        std::launder(static_cast<T*>(to))->after_relocate();
+    }
+}
+
+inline void *arena_map_pages(std::size_t bytes) {
+#if defined(MY_PTR_HAS_MMAP)
+    void *p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    return p;
+#else
+    return ::operator new(bytes);
+#endif
+}
+
+inline void arena_unmap_pages(void *p, std::size_t bytes) noexcept {
+#if defined(MY_PTR_HAS_MMAP)
+    ::munmap(p, bytes);
+#else
+    (void)bytes;
+    ::operator delete(p);
+#endif
+}
+
+// 句柄表项。ptr 与 state 可被 pin 无锁读取，其余字段只在竞技场的锁内访问
+struct arena_entry {
+    static constexpr std::uint32_t moving_bit = std::uint32_t(1) << 31;
+
+    std::atomic<void*> ptr{nullptr};
+    std::atomic<std::uint32_t> state{0};      // 低位是 pin 计数，最高位表示正在搬移
+    std::atomic<std::uint32_t> generation{0}; // 奇数表示存活
+    std::uint32_t next_free = 0;
+    std::uint32_t slot = 0;
+    void *home = nullptr; // 所在块
+};
+
+} // namespace detail
+
+// 访问期间阻止搬移的 RAII 钉
+template <typename T>
+class arena_pin {
+private:
+    detail::arena_entry *entry_;
+    T *ptr_;
+
+public:
+    arena_pin() noexcept : entry_(nullptr), ptr_(nullptr) {}
+    arena_pin(detail::arena_entry *entry, T *ptr) noexcept : entry_(entry), ptr_(ptr) {}
+
+    arena_pin(arena_pin&& other) noexcept
+        : entry_(std::exchange(other.entry_, nullptr)), ptr_(std::exchange(other.ptr_, nullptr)) {}
+
+    arena_pin& operator=(arena_pin&& other) noexcept {
+        arena_pin(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    arena_pin(const arena_pin&) = delete;
+    arena_pin& operator=(const arena_pin&) = delete;
+
+    ~arena_pin() {
+        if (entry_) {
+            entry_->state.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    void swap(arena_pin& other) noexcept {
+        std::swap(entry_, other.entry_);
+        std::swap(ptr_, other.ptr_);
+    }
+
+    T *get() const noexcept { return ptr_; }
+    T& operator*() const noexcept { return *ptr_; }
+    T *operator->() const noexcept { return ptr_; }
+    explicit operator bool() const noexcept { return ptr_ != nullptr; }
+};
+
+// 创建、销毁与整理互斥执行；pin 不加锁，可与整理并发。
+// 销毁对象时不能有其它线程持有它的 pin
+template <typename T>
+class compacting_arena {
+public:
+    using handle_type = slot_handle64;
+
+private:
+    static constexpr std::size_t slot_size = (sizeof(T) + alignof(T) - 1) / alignof(T) * alignof(T);
+    static constexpr std::size_t table_shift = 12;
+    static constexpr std::size_t table_chunk = std::size_t(1) << table_shift;
+    static constexpr std::size_t max_table_chunks = 16384; // 最多 6400 万个句柄
+    static constexpr std::uint32_t no_owner = ~std::uint32_t(0);
+    static constexpr int buckets = 8; // 按占用率分桶，分配取最满的块，整理取最空的块
+
+    struct chunk {
+        unsigned char *base;
+        std::uint32_t live = 0;
+        std::vector<std::uint32_t> owner; // 槽 → 句柄下标
+        std::vector<std::uint32_t> free_slots;
+        int bucket = -1;
+        std::size_t bucket_pos = 0;
+        bool draining = false;
+        std::size_t skipped_pass = 0; // 本轮因对象被钉住而放弃腾空
+    };
+
+    std::size_t chunk_bytes_;
+    std::size_t slots_per_chunk_;
+    std::unique_ptr<std::atomic<detail::arena_entry*>[]> table_;
+    std::size_t table_chunks_;
+    std::uint32_t entry_count_;
+    std::uint32_t free_entry_;
+    std::vector<std::unique_ptr<chunk>> chunks_;
+    std::vector<chunk*> bucket_[buckets];
+    chunk *alloc_chunk_;
+    chunk *source_;
+    std::uint32_t source_cursor_;
+    std::size_t pass_;
+    std::size_t live_;
+    std::mutex mutex_;
+
+    detail::arena_entry *entry_at(std::size_t index) const noexcept {
+        std::size_t c = index >> table_shift;
+        if (c >= max_table_chunks) {
+            return nullptr;
+        }
+        detail::arena_entry *block = table_[c].load(std::memory_order_acquire);
+        return block ? &block[index & (table_chunk - 1)] : nullptr;
+    }
+
+    std::uint32_t acquire_entry() {
+        if (free_entry_ != no_owner) {
+            std::uint32_t index = free_entry_;
+            free_entry_ = entry_at(index)->next_free;
+            return index;
+        }
+        if ((entry_count_ & (table_chunk - 1)) == 0) {
+            if (table_chunks_ == max_table_chunks) {
+                throw std::length_error("compacting_arena: handle table exhausted");
+            }
+            table_[table_chunks_].store(new detail::arena_entry[table_chunk], std::memory_order_release);
+            ++table_chunks_;
+        }
+        return entry_count_++;
+    }
+
+    T *slot_ptr(chunk *c, std::uint32_t slot) const noexcept {
+        return reinterpret_cast<T*>(c->base + slot * slot_size);
+    }
+
+    void unbucket(chunk *c) noexcept {
+        if (c->bucket < 0) {
+            return;
+        }
+        auto& b = bucket_[c->bucket];
+        b[c->bucket_pos] = b.back();
+        b[c->bucket_pos]->bucket_pos = c->bucket_pos;
+        b.pop_back();
+        c->bucket = -1;
+    }
+
+    // 按占用率重新归桶；满块与正在腾空的块不在任何桶中
+    void rebucket(chunk *c) {
+        int want = (c->draining || c->free_slots.empty())
+            ? -1
+            : static_cast<int>(std::size_t(c->live) * buckets / slots_per_chunk_);
+        if (want == c->bucket) {
+            return;
+        }
+        unbucket(c);
+        if (want >= 0) {
+            bucket_[want].push_back(c);
+            c->bucket = want;
+            c->bucket_pos = bucket_[want].size() - 1;
+        }
+    }
+
+    chunk *new_chunk() {
+        auto c = std::make_unique<chunk>();
+        c->owner.assign(slots_per_chunk_, no_owner);
+        c->free_slots.reserve(slots_per_chunk_);
+        for (std::size_t i = slots_per_chunk_; i-- > 0;) {
+            c->free_slots.push_back(static_cast<std::uint32_t>(i));
+        }
+        chunks_.reserve(chunks_.size() + 1);
+        c->base = static_cast<unsigned char*>(detail::arena_map_pages(chunk_bytes_));
+        chunks_.push_back(std::move(c));
+        chunk *raw = chunks_.back().get();
+        rebucket(raw);
+        return raw;
+    }
+
+    void release_chunk(chunk *c) noexcept {
+        unbucket(c);
+        if (alloc_chunk_ == c) {
+            alloc_chunk_ = nullptr;
+        }
+        detail::arena_unmap_pages(c->base, chunk_bytes_);
+        for (std::size_t i = 0; i < chunks_.size(); ++i) {
+            if (chunks_[i].get() == c) {
+                chunks_[i] = std::move(chunks_.back());
+                chunks_.pop_back();
+                break;
+            }
+        }
+    }
+
+    // 取一个空槽：优先当前块，其次最满的未满块，最后新映射一块
+    std::pair<chunk*, std::uint32_t> allocate_slot() {
+        if (!alloc_chunk_ || alloc_chunk_->free_slots.empty()) {
+            alloc_chunk_ = nullptr;
+            for (int b = buckets - 1; b >= 0 && !alloc_chunk_; --b) {
+                if (!bucket_[b].empty()) {
+                    alloc_chunk_ = bucket_[b].back();
+                }
+            }
+            if (!alloc_chunk_) {
+                alloc_chunk_ = new_chunk();
+            }
+        }
+        chunk *c = alloc_chunk_;
+        std::uint32_t slot = c->free_slots.back();
+        c->free_slots.pop_back();
+        ++c->live;
+        rebucket(c);
+        return {c, slot};
+    }
+
+    void free_slot(chunk *c, std::uint32_t slot) {
+        c->owner[slot] = no_owner;
+        c->free_slots.push_back(slot);
+        --c->live;
+        if (c->live == 0 && c != alloc_chunk_ && c != source_) {
+            release_chunk(c);
+            return;
+        }
+        rebucket(c);
+    }
+
+    // 选择最空的块作为腾空对象；整体已足够紧凑时返回 nullptr。本轮放弃过的块不再选
+    chunk *pick_source() noexcept {
+        std::size_t capacity = chunks_.size() * slots_per_chunk_;
+        for (int b = 0; b < buckets / 2; ++b) {
+            for (chunk *c : bucket_[b]) {
+                if (c == alloc_chunk_ || c->skipped_pass == pass_) {
+                    continue;
+                }
+                // 其余块的空位必须装得下它的对象，否则搬移只会映射新块
+                std::size_t other_free = capacity - live_ - (slots_per_chunk_ - c->live);
+                if (other_free >= c->live) {
+                    return c;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    void finish_source() {
+        chunk *c = source_;
+        source_ = nullptr;
+        c->draining = false;
+        if (c->live == 0) {
+            release_chunk(c);
+        } else {
+            rebucket(c);
+        }
+    }
+
+public:
+    explicit compacting_arena(std::size_t chunk_bytes = 256 * 1024)
+        : chunk_bytes_(chunk_bytes < slot_size ? slot_size : chunk_bytes),
+          slots_per_chunk_(chunk_bytes_ / slot_size),
+          table_(new std::atomic<detail::arena_entry*>[max_table_chunks]),
+          table_chunks_(0), entry_count_(0), free_entry_(no_owner),
+          alloc_chunk_(nullptr), source_(nullptr), source_cursor_(0), pass_(1), live_(0) {
+        static_assert(alignof(T) <= 4096, "over-aligned types are not supported");
+        for (std::size_t i = 0; i < max_table_chunks; ++i) {
+            table_[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    // 析构所有仍存活的对象并归还全部内存
+    ~compacting_arena() {
+        for (auto& c : chunks_) {
+            for (std::size_t s = 0; s < slots_per_chunk_; ++s) {
+                if (c->owner[s] != no_owner) {
+                    slot_ptr(c.get(), static_cast<std::uint32_t>(s))->~T();
+                }
+            }
+            detail::arena_unmap_pages(c->base, chunk_bytes_);
+        }
+        for (std::size_t i = 0; i < table_chunks_; ++i) {
+            delete[] table_[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    compacting_arena(const compacting_arena&) = delete;
+    compacting_arena& operator=(const compacting_arena&) = delete;
+
+    template <typename... Args>
+    handle_type create(Args&&... args) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::uint32_t index = acquire_entry();
+        auto place = allocate_slot();
+        T *p = slot_ptr(place.first, place.second);
+        try {
+            new (p) T(std::forward<Args>(args)...);
+        } catch (...) {
+            free_slot(place.first, place.second);
+            detail::arena_entry *e = entry_at(index);
+            e->next_free = free_entry_;
+            free_entry_ = index;
+            throw;
+        }
+        place.first->owner[place.second] = index;
+        detail::arena_entry *e = entry_at(index);
+        e->home = place.first;
+        e->slot = place.second;
+        e->ptr.store(p, std::memory_order_relaxed);
+        std::uint32_t gen = e->generation.load(std::memory_order_relaxed) + 1; // 偶数 → 奇数
+        e->generation.store(gen, std::memory_order_release);
+        ++live_;
+        return handle_type::make(index, gen);
+    }
+
+    // 销毁对象并使句柄失效
+    bool destroy(handle_type h) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        detail::arena_entry *e = entry_at(h.index());
+        if (!e || e->generation.load(std::memory_order_relaxed) != h.generation() || !(h.generation() & 1)) {
+            return false;
+        }
+        static_cast<T*>(e->ptr.load(std::memory_order_relaxed))->~T();
+        e->generation.store(static_cast<std::uint32_t>(h.generation() + 1), std::memory_order_release);
+        e->ptr.store(nullptr, std::memory_order_relaxed);
+        free_slot(static_cast<chunk*>(e->home), e->slot);
+        e->next_free = free_entry_;
+        free_entry_ = static_cast<std::uint32_t>(h.index());
+        --live_;
+        return true;
+    }
+
+    // 钉住对象并返回其地址；句柄已失效时返回空的 pin。对象正在搬移时等待搬移完成
+    arena_pin<T> pin(handle_type h) noexcept {
+        detail::arena_entry *e = entry_at(h.index());
+        if (!e) {
+            return arena_pin<T>();
+        }
+        for (;;) {
+            std::uint32_t s = e->state.fetch_add(1, std::memory_order_acquire);
+            if (!(s & detail::arena_entry::moving_bit)) {
+                break;
+            }
+            e->state.fetch_sub(1, std::memory_order_relaxed);
+            while (e->state.load(std::memory_order_acquire) & detail::arena_entry::moving_bit) {
+                std::this_thread::yield();
+            }
+        }
+        if (e->generation.load(std::memory_order_acquire) != h.generation() || !(h.generation() & 1)) {
+            e->state.fetch_sub(1, std::memory_order_release);
+            return arena_pin<T>();
+        }
+        return arena_pin<T>(e, static_cast<T*>(e->ptr.load(std::memory_order_acquire)));
+    }
+
+    // 增量整理：最多搬移 max_moves 个对象，返回实际搬移数；返回 0 表示本轮已足够紧凑
+    // （剩余的稀疏块里只有被钉住的对象）
+    std::size_t compact_step(std::size_t max_moves = 256) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::size_t moved = 0;
+        while (moved < max_moves) {
+            if (!source_) {
+                source_ = pick_source();
+                if (!source_) {
+                    ++pass_; // 一轮结束，下一次整理重新考虑被放弃的块
+                    break;
+                }
+                source_->draining = true;
+                unbucket(source_);
+                source_cursor_ = 0;
+            }
+            if (source_cursor_ == slots_per_chunk_ || source_->live == 0) {
+                source_->skipped_pass = pass_; // 剩下的都被钉住，留给下一轮
+                finish_source();
+                continue;
+            }
+            std::uint32_t slot = source_cursor_++;
+            std::uint32_t index = source_->owner[slot];
+            if (index == no_owner) {
+                continue;
+            }
+            detail::arena_entry *e = entry_at(index);
+            std::uint32_t idle = 0;
+            if (!e->state.compare_exchange_strong(idle, detail::arena_entry::moving_bit, std::memory_order_acquire,
+                                                  std::memory_order_relaxed)) {
+                continue;
+            }
+            auto place = allocate_slot();
+            T *to = slot_ptr(place.first, place.second);
+            detail::relocate_object(slot_ptr(source_, slot), to);
+            place.first->owner[place.second] = index;
+            e->home = place.first;
+            e->slot = place.second;
+            e->ptr.store(to, std::memory_order_release);
+            e->state.fetch_sub(detail::arena_entry::moving_bit, std::memory_order_release);
+            free_slot(source_, slot);
+            ++moved;
+        }
+        return moved;
+    }
+
+    // 一直整理到足够紧凑，返回搬移总数
+    std::size_t compact() {
+        std::size_t total = 0;
+        for (std::size_t n; (n = compact_step(4096)) != 0;) {
+            total += n;
+        }
+        return total;
+    }
+
+    std::size_t size() const noexcept { return live_; }
+    std::size_t chunk_count() const noexcept { return chunks_.size(); }
+    std::size_t committed_bytes() const noexcept { return chunks_.size() * chunk_bytes_; }
+
+    // 存活对象占已映射槽位的比例
+    double occupancy() const noexcept {
+        std::size_t capacity = chunks_.size() * slots_per_chunk_;
+        return capacity ? static_cast<double>(live_) / capacity : 1.0;
+    }
+};
+
+} // namespace my_ptr
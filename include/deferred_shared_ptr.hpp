@@ -0,0 +1,407 @@
+/*
+    延迟引用计数（Levanoni–Petrank / Deutsch–Bobrow 风格）
+    deferred_shared_ptr 的拷贝与析构不对控制块做原子读改写，只向线程私有的日志环追加一条 +1/-1 记录。
+    deferred_rc::collect() 收集所有线程的日志，把本轮的增量与上一轮的减量合并为每个控制块的净变化后一次性应用。
+    减量推迟一轮：任何减量对应的增量必然在它之前发生，最迟在下一轮被收集，因此计数不会提前归零，
+    dispose() 只会在相关日志都被处理之后执行
+*/
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "shared_ptr.hpp"
+#include "detail/control_block.hpp"
+#include "detail/traits.hpp"
+
+namespace my_ptr {
+
+namespace detail {
+
+// 每个线程一份日志：单生产者环，属主线程写入，收集器读取。
+// 属主只做普通写与 release 存储，快路径上没有任何原子读改写。
+// 记录是控制块地址，最低位为 1 表示减量
+struct deferred_log {
+    static constexpr std::size_t capacity = 8192;
+    static constexpr std::uintptr_t dec_tag = 1;
+
+    alignas(cache_line_size) std::atomic<std::size_t> head_{0}; // 属主写
+    std::size_t cached_tail_ = 0;                                // 属主私有
+    alignas(cache_line_size) std::atomic<std::size_t> tail_{0}; // 收集器写
+    std::atomic<bool> orphaned_{false}; // 属主线程已退出，日志可被新线程复用
+    std::uintptr_t entries_[capacity];
+
+    // 当前积压的记录数上界（属主调用，基于缓存的尾指针）
+    std::size_t backlog() const noexcept {
+        return head_.load(std::memory_order_relaxed) - cached_tail_;
+    }
+
+    void refresh_tail() noexcept {
+        cached_tail_ = tail_.load(std::memory_order_acquire);
+    }
+
+    // 调用者保证 backlog() < capacity
+    void append(std::uintptr_t entry) noexcept {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        entries_[head % capacity] = entry;
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    // 收集器取走已发布的全部记录（收集锁保证同一时刻只有一个读者）
+    template <typename F>
+    void drain(F&& f) {
+        std::size_t head = head_.load(std::memory_order_acquire);
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        for (; tail != head; ++tail) {
+            f(entries_[tail % capacity]);
+        }
+        tail_.store(tail, std::memory_order_release);
+    }
+
+    std::size_t pending() const noexcept {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+};
+
+// 收集器的合并表：以控制块地址为键的开放寻址表，累计每个控制块本轮的增减次数
+class deferred_delta_table {
+public:
+    struct entry {
+        control_block_base *cb;
+        std::int64_t delta;
+    };
+
+private:
+    std::vector<entry> slots_;
+    std::size_t size_ = 0;
+
+    static std::size_t hash(const control_block_base *cb) noexcept {
+        return static_cast<std::size_t>((reinterpret_cast<std::uintptr_t>(cb) * 0x9E3779B97F4A7C15ull) >> 32);
+    }
+
+    void grow() {
+        std::vector<entry> old(slots_.empty() ? 256 : slots_.size() * 2, entry{nullptr, 0});
+        old.swap(slots_);
+        size_ = 0;
+        for (const entry& e : old) {
+            if (e.cb) {
+                add(e.cb, e.delta);
+            }
+        }
+    }
+
+public:
+    void add(control_block_base *cb, std::int64_t d) {
+        if ((size_ + 1) * 2 > slots_.size()) {
+            grow();
+        }
+        std::size_t mask = slots_.size() - 1;
+        for (std::size_t i = hash(cb) & mask;; i = (i + 1) & mask) {
+            if (slots_[i].cb == cb) {
+                slots_[i].delta += d;
+                return;
+            }
+            if (!slots_[i].cb) {
+                slots_[i] = entry{cb, d};
+                ++size_;
+                return;
+            }
+        }
+    }
+
+    template <typename F>
+    void for_each(F&& f) const {
+        for (const entry& e : slots_) {
+            if (e.cb && e.delta != 0) {
+                f(e.cb, e.delta);
+            }
+        }
+    }
+};
+
+class deferred_rc_registry {
+private:
+    std::mutex logs_mutex_;
+    std::vector<deferred_log*> logs_; // 日志从不释放，线程退出后留给后来的线程复用
+    std::mutex collect_mutex_;
+    std::vector<deferred_delta_table::entry> prev_decs_; // 上一轮收集到、已按控制块合并的减量
+    // 收集过程中级联释放产生的记录：本线程的日志环可能已满，暂存于此并入下一轮
+    std::vector<std::uintptr_t> overflow_;
+    std::atomic<std::size_t> threshold_{deferred_log::capacity / 2};
+
+    static bool& collecting() noexcept {
+        thread_local bool flag = false;
+        return flag;
+    }
+
+public:
+    // 有意泄漏，保证线程局部对象与其它静态对象析构时仍可访问
+    static deferred_rc_registry& instance() noexcept {
+        static deferred_rc_registry *registry = new deferred_rc_registry();
+        return *registry;
+    }
+
+    deferred_log *attach() {
+        std::lock_guard<std::mutex> lock(logs_mutex_);
+        for (deferred_log *log : logs_) {
+            bool expected = true;
+            if (log->orphaned_.compare_exchange_strong(expected, false, std::memory_order_acq_rel)) {
+                // 接手遗留的记录：从已发布的位置继续写
+                log->refresh_tail();
+                return log;
+            }
+        }
+        logs_.push_back(new deferred_log());
+        return logs_.back();
+    }
+
+    void detach(deferred_log *log) noexcept {
+        log->orphaned_.store(true, std::memory_order_release); // 未处理的记录由下一次收集处理
+    }
+
+    std::size_t threshold() const noexcept { return threshold_.load(std::memory_order_relaxed); }
+
+    void set_threshold(std::size_t n) noexcept {
+        if (n == 0) n = 1;
+        if (n > deferred_log::capacity) n = deferred_log::capacity;
+        threshold_.store(n, std::memory_order_relaxed);
+    }
+
+    // 日志积压达到阈值时由属主调用；环已写满时阻塞直到收集腾出空间
+    void relieve(deferred_log& log, std::uintptr_t entry) {
+        if (collecting()) {
+            // 收集中的级联释放：不能再次进入收集，也不能等待自己
+            log.refresh_tail();
+            if (log.backlog() < deferred_log::capacity) {
+                log.append(entry);
+            } else {
+                overflow_.push_back(entry);
+            }
+            return;
+        }
+        for (;;) {
+            log.refresh_tail();
+            if (log.backlog() < threshold()) {
+                break;
+            }
+            if (log.backlog() < deferred_log::capacity) {
+                try_collect();
+                break;
+            }
+            collect();
+        }
+        log.refresh_tail();
+        log.append(entry);
+    }
+
+    // 已有收集在进行时直接返回
+    void try_collect() {
+        std::unique_lock<std::mutex> lock(collect_mutex_, std::try_to_lock);
+        if (lock.owns_lock()) {
+            collect_locked();
+        }
+    }
+
+    void collect() {
+        std::lock_guard<std::mutex> lock(collect_mutex_);
+        collect_locked();
+    }
+
+    // 尚未应用的记录数（含推迟到下一轮的减量）
+    std::size_t pending() {
+        std::lock_guard<std::mutex> collect_lock(collect_mutex_);
+        std::size_t n = overflow_.size();
+        for (const auto& e : prev_decs_) {
+            n += static_cast<std::size_t>(-e.delta);
+        }
+        std::lock_guard<std::mutex> lock(logs_mutex_);
+        for (deferred_log *log : logs_) {
+            n += log->pending();
+        }
+        return n;
+    }
+
+private:
+    void collect_locked() {
+        struct guard {
+            guard() noexcept { collecting() = true; }
+            ~guard() { collecting() = false; }
+        } in_collect;
+
+        // 本轮增量 + 上一轮减量 → 每个控制块的净变化
+        deferred_delta_table delta, decs;
+        for (const auto& e : prev_decs_) {
+            delta.add(e.cb, e.delta);
+        }
+        auto take = [&](std::uintptr_t entry) {
+            if (entry & deferred_log::dec_tag) {
+                decs.add(reinterpret_cast<control_block_base*>(entry & ~deferred_log::dec_tag), -1);
+            } else {
+                delta.add(reinterpret_cast<control_block_base*>(entry), 1);
+            }
+        };
+        for (std::uintptr_t entry : overflow_) {
+            take(entry);
+        }
+        overflow_.clear();
+        {
+            std::lock_guard<std::mutex> lock(logs_mutex_);
+            for (deferred_log *log : logs_) {
+                log->drain(take);
+            }
+        }
+        prev_decs_.clear();
+        decs.for_each([&](control_block_base *cb, std::int64_t d) { prev_decs_.push_back({cb, d}); });
+
+        // 先加后减：减到零触发的级联释放可能产生新的记录，留待下一轮
+        delta.for_each([](control_block_base *cb, std::int64_t d) {
+            if (d > 0) {
+                cb->add_shared_ref(static_cast<std::uint64_t>(d));
+            }
+        });
+        delta.for_each([](control_block_base *cb, std::int64_t d) {
+            if (d < 0) {
+                cb->release_shared(static_cast<std::uint64_t>(-d));
+            }
+        });
+    }
+};
+
+struct deferred_log_holder {
+    deferred_log *log;
+
+    deferred_log_holder() : log(deferred_rc_registry::instance().attach()) {}
+    ~deferred_log_holder() { deferred_rc_registry::instance().detach(log); }
+};
+
+inline deferred_log& local_deferred_log() {
+    thread_local deferred_log_holder holder;
+    return *holder.log;
+}
+
+// 快路径只比较私有的缓存尾指针；积压达到阈值才进入慢路径
+inline void log_reference(std::uintptr_t entry) {
+    deferred_log& log = local_deferred_log();
+    deferred_rc_registry& registry = deferred_rc_registry::instance();
+    if (log.backlog() < registry.threshold()) {
+        log.append(entry);
+    } else {
+        registry.relieve(log, entry);
+    }
+}
+
+} // namespace detail
+
+// 延迟引用计数的全局入口
+struct deferred_rc {
+    // 收集并应用所有线程的日志（周期性调用；日志积压达到阈值时也会自动触发）。
+    // 不能在托管对象的析构函数中调用
+    static void collect() { detail::deferred_rc_registry::instance().collect(); }
+
+    // 静止状态下连续两轮收集，使所有已记录的增减全部生效
+    static void collect_all() {
+        collect();
+        collect();
+    }
+
+    static std::size_t pending() { return detail::deferred_rc_registry::instance().pending(); }
+
+    // 单个线程日志触发自动收集的积压记录数（不超过日志容量）
+    static void set_threshold(std::size_t n) noexcept { detail::deferred_rc_registry::instance().set_threshold(n); }
+};
+
+// 延迟计数的共享指针：与 shared_ptr 共用控制块，可互相转换。
+// 拷贝与析构只写本线程日志；对象在最后一个句柄释放后的第二次收集中销毁
+template <typename T>
+class deferred_shared_ptr {
+public:
+    using element_type = T;
+
+private:
+    element_type *ptr_;
+    detail::control_block_base *ctrl_block_;
+
+    deferred_shared_ptr(detail::control_block_base *cb, element_type *p) noexcept : ptr_(p), ctrl_block_(cb) {}
+
+    template <typename U, typename... Args>
+    friend deferred_shared_ptr<U> make_deferred_shared(Args&&... args);
+
+public:
+    constexpr deferred_shared_ptr() noexcept : ptr_(nullptr), ctrl_block_(nullptr) {}
+    constexpr deferred_shared_ptr(std::nullptr_t) noexcept : ptr_(nullptr), ctrl_block_(nullptr) {}
+
+    // 从 shared_ptr 接入：立即对控制块加一
+    explicit deferred_shared_ptr(const shared_ptr<T>& sp) noexcept
+        : ptr_(sp.get()), ctrl_block_(detail::shared_ptr_access::control_block(sp)) {
+        if (ctrl_block_) {
+            ctrl_block_->add_shared_ref();
+        }
+    }
+
+    deferred_shared_ptr(const deferred_shared_ptr& other) : ptr_(other.ptr_), ctrl_block_(other.ctrl_block_) {
+        if (ctrl_block_) {
+            detail::log_reference(reinterpret_cast<std::uintptr_t>(ctrl_block_));
+        }
+    }
+
+    deferred_shared_ptr(deferred_shared_ptr&& other) noexcept : ptr_(other.ptr_), ctrl_block_(other.ctrl_block_) {
+        other.ptr_ = nullptr;
+        other.ctrl_block_ = nullptr;
+    }
+
+    ~deferred_shared_ptr() {
+        if (ctrl_block_) {
+            detail::log_reference(reinterpret_cast<std::uintptr_t>(ctrl_block_) | detail::deferred_log::dec_tag);
+        }
+    }
+
+    deferred_shared_ptr& operator=(const deferred_shared_ptr& other) {
+        deferred_shared_ptr(other).swap(*this);
+        return *this;
+    }
+
+    deferred_shared_ptr& operator=(deferred_shared_ptr&& other) noexcept {
+        deferred_shared_ptr(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    void reset() noexcept {
+        deferred_shared_ptr().swap(*this);
+    }
+
+    void swap(deferred_shared_ptr& other) noexcept {
+        std::swap(ptr_, other.ptr_);
+        std::swap(ctrl_block_, other.ctrl_block_);
+    }
+
+    // 转换为普通 shared_ptr：立即对控制块加一（持有本句柄即保证计数大于零）
+    shared_ptr<T> to_shared() const noexcept {
+        if (!ctrl_block_) {
+            return shared_ptr<T>();
+        }
+        ctrl_block_->add_shared_ref();
+        return detail::shared_ptr_access::adopt<shared_ptr<T>>(ctrl_block_, ptr_);
+    }
+
+    element_type *get() const noexcept { return ptr_; }
+    element_type& operator*() const noexcept { return *ptr_; }
+    element_type *operator->() const noexcept { return ptr_; }
+    explicit operator bool() const noexcept { return ptr_ != nullptr; }
+};
+
+template <typename T, typename... Args>
+deferred_shared_ptr<T> make_deferred_shared(Args&&... args) {
+    auto *cb = static_cast<detail::inline_control_block<T>*>(
+        detail::make_inline_control_block<T>(std::forward<Args>(args)...));
+    return deferred_shared_ptr<T>(cb, cb->get());
+}
+
+template <typename T>
+void swap(deferred_shared_ptr<T>& lhs, deferred_shared_ptr<T>& rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+} // namespace my_ptr
@@ -4,18 +4,123 @@
 
 #pragma once
 #include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <type_traits>
 #include <utility>
 #include "default_delete.hpp"
+#include "teardown.hpp"
+#include "futex.hpp"
+#include "traits.hpp"
 
 namespace my_ptr {
 namespace detail {
 
+// 等待者停靠的唤醒字按控制块地址散列到一张静态表上，而不放在控制块里：
+// 释放者在交出引用之后才唤醒，那时被唤醒的线程可能已经释放了控制块，唤醒不能再触及它。
+// 不同控制块共用一个槽只会带来虚假唤醒
+struct parking_slot {
+    alignas(cache_line_size) std::atomic<std::uint32_t> epoch{0};
+};
+
+inline std::atomic<std::uint32_t>& parking_word(const void *cb) noexcept {
+    static parking_slot slots[64];
+    return slots[(reinterpret_cast<std::uintptr_t>(cb) >> 6) % 64].epoch;
+}
+
 // 控制块基类
+// 计数字的高 16 位记录正在阻塞等待的线程数，低位是引用计数；
+// 弱计数字另有一位标记"对象已销毁"。等待者登记与释放操作落在同一个原子字上，
+// 因此释放路径只需检查 fetch_sub 的返回值，无人等待时不产生任何额外开销；
+// 唤醒发生在交出引用之后，只触及 parking_word，不触及控制块
 class control_block_base {
 protected:
-    std::atomic<size_t> shared_count_;
-    std::atomic<size_t> weak_count_;
+    static constexpr std::uint64_t waiter_unit = std::uint64_t(1) << 48;
+    static constexpr std::uint64_t disposed_bit = std::uint64_t(1) << 47;
+    static constexpr std::uint64_t count_mask = disposed_bit - 1;
+
+    // 永生标记放在强计数字的 disposed_bit 位上（这一位只在弱计数字上表示已销毁），控制块不因此变大。
+    // 永生对象的计数操作全部跳过：读一次计数字、一个可预测的分支，不写缓存行
+    static constexpr std::uint64_t immortal_bit = disposed_bit;
+    static constexpr std::uint64_t immortal_count = std::uint64_t(1) << 40;
+
+    std::atomic<std::uint64_t> shared_count_;
+    std::atomic<std::uint64_t> weak_count_;
+
+    // dispose() 只是开始销毁、完成后由派生类调用 finish_dispose() 的控制块返回 true
+    virtual bool deferred_dispose() const noexcept { return false; }
+
+    static void release_last(void *cb) noexcept {
+        auto *self = static_cast<control_block_base*>(cb);
+        bool deferred = self->deferred_dispose(); // dispose() 返回后 self 可能已被异步收尾释放
+        self->dispose();
+        if (!deferred) {
+            self->finish_dispose();
+        }
+    }
+
+    // 对象已销毁：一次原子操作同时释放隐含的弱引用并标记已销毁；此后 this 可能已被等待者释放
+    void finish_dispose() noexcept {
+        std::uint64_t old = weak_count_.fetch_add(disposed_bit - 1, std::memory_order_acq_rel);
+        if (old >= waiter_unit) {
+            notify_waiters(this);
+        }
+        if ((old & count_mask) == 1) {
+            destroy();
+        }
+    }
+
+    // 只使用地址，不解引用 cb
+    static void notify_waiters(const control_block_base *cb) noexcept {
+        std::atomic<std::uint32_t>& word = parking_word(cb);
+        word.fetch_add(1, std::memory_order_release);
+        futex_wake_all(word);
+    }
+
+    // 在 counter 上登记为等待者，直到 done(当前值) 成立或超时
+    // 永生对象永远不会满足条件，直接返回 false
+    template <typename Pred>
+    bool wait_on(std::atomic<std::uint64_t>& counter, Pred done, const std::chrono::nanoseconds *timeout) noexcept {
+        if (immortal()) {
+            return false;
+        }
+        std::atomic<std::uint32_t>& word = parking_word(this);
+        std::uint64_t cur = counter.fetch_add(waiter_unit, std::memory_order_acq_rel);
+        bool ok = done(cur);
+        auto deadline = std::chrono::steady_clock::now() + (timeout ? *timeout : std::chrono::nanoseconds(0));
+        while (!ok) {
+            std::uint32_t epoch = word.load(std::memory_order_acquire);
+            if (done(counter.load(std::memory_order_acquire))) {
+                ok = true;
+                break;
+            }
+            if (timeout) {
+                auto remaining = deadline - std::chrono::steady_clock::now();
+                if (remaining <= std::chrono::nanoseconds(0)) {
+                    break;
+                }
+                std::chrono::nanoseconds rel = std::chrono::duration_cast<std::chrono::nanoseconds>(remaining);
+                futex_wait(word, epoch, &rel);
+            } else {
+                futex_wait(word, epoch);
+            }
+        }
+        counter.fetch_sub(waiter_unit, std::memory_order_relaxed);
+        return ok;
+    }
+
+    // 供可回收的控制块复用：只能在 destroy 中（不再有任何引用时）调用
+    void reset_counts() noexcept {
+        shared_count_.store(1, std::memory_order_relaxed);
+        weak_count_.store(1, std::memory_order_relaxed);
+    }
+
+    struct immortal_tag {};
+
+    // 永生控制块的计数固定为一个很大的值，直接读取计数的代码也会视其为存活
+    explicit control_block_base(immortal_tag) noexcept
+        : shared_count_(immortal_count | immortal_bit), weak_count_(immortal_count) {}
 
 public:
     control_block_base() noexcept 
@@ -27,30 +132,68 @@ public:
     virtual void destroy() noexcept = 0; // 销毁控制块对象
 
     void add_shared_ref() noexcept {
+        if (immortal()) {
+            return;
+        }
         shared_count_.fetch_add(1, std::memory_order_acq_rel);
     }
 
+    // 最后一个强引用释放时，经线程局部队列执行 dispose，嵌套过深的级联释放被展开成循环
     void release_shared() noexcept {
-        if (shared_count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
-            dispose();
-            release_weak();
+        if (immortal()) {
+            return;
+        }
+        std::uint64_t old = shared_count_.fetch_sub(1, std::memory_order_acq_rel);
+        if ((old & count_mask) == 1) {
+            teardown_queue::run(this, &release_last);
+        } else if (old >= waiter_unit && (old & count_mask) == 2) {
+            notify_waiters(this); // 引用已交出，this 只作地址使用
+        }
+    }
+
+    // 一次加/减 n 个强引用（加权引用计数用整块权重记账）
+    void add_shared_ref(std::uint64_t n) noexcept {
+        if (immortal()) {
+            return;
+        }
+        shared_count_.fetch_add(n, std::memory_order_acq_rel);
+    }
+
+    void release_shared(std::uint64_t n) noexcept {
+        if (immortal()) {
+            return;
+        }
+        std::uint64_t old = shared_count_.fetch_sub(n, std::memory_order_acq_rel);
+        if ((old & count_mask) == n) {
+            teardown_queue::run(this, &release_last);
+        } else if (old >= waiter_unit && (old & count_mask) == n + 1) {
+            notify_waiters(this); // 引用已交出，this 只作地址使用
         }
     }
 
     void add_weak_ref() noexcept {
+        if (immortal()) {
+            return;
+        }
         weak_count_.fetch_add(1, std::memory_order_acq_rel);
     }
 
     void release_weak() noexcept {
-        if (weak_count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        if (immortal()) {
+            return;
+        }
+        if ((weak_count_.fetch_sub(1, std::memory_order_acq_rel) & count_mask) == 1) {
             destroy();
         }
     }
 
     // 尝试增加共享对象引用计数
     bool try_add_shared_ref() noexcept {
-        size_t count = shared_count_.load(std::memory_order_acquire);
-        while (count != 0) {
+        if (immortal()) {
+            return true;
+        }
+        std::uint64_t count = shared_count_.load(std::memory_order_acquire);
+        while ((count & count_mask) != 0) {
             if (shared_count_.compare_exchange_weak(count, count + 1, std::memory_order_acq_rel, std::memory_order_relaxed)) {
                 return true;
             }
@@ -58,8 +201,31 @@ public:
         return false;
     }
 
+    bool immortal() const noexcept {
+        return (shared_count_.load(std::memory_order_relaxed) & immortal_bit) != 0;
+    }
+
     size_t use_count() const noexcept {
-        return shared_count_.load(std::memory_order_relaxed);
+        return static_cast<size_t>(shared_count_.load(std::memory_order_relaxed) & count_mask);
+    }
+
+    // 强计数字与其中计数位的掩码，供批量扫描直接读取（见 bulk_weak.hpp）
+    const std::atomic<std::uint64_t> *shared_count_word() const noexcept {
+        return &shared_count_;
+    }
+
+    static constexpr std::uint64_t shared_count_mask() noexcept {
+        return count_mask;
+    }
+
+    // 阻塞直到调用者持有的是唯一强引用（调用者必须持有一个强引用）
+    bool wait_unique(const std::chrono::nanoseconds *timeout = nullptr) noexcept {
+        return wait_on(shared_count_, [](std::uint64_t v) { return (v & count_mask) == 1; }, timeout);
+    }
+
+    // 阻塞直到对象已被销毁（调用者必须持有一个弱引用）
+    bool wait_disposed(const std::chrono::nanoseconds *timeout = nullptr) noexcept {
+        return wait_on(weak_count_, [](std::uint64_t v) { return (v & disposed_bit) != 0; }, timeout);
     }
 };
 
@@ -124,6 +290,75 @@ public:
     }
 };
 
+// 永生控制块：对象与控制块一起分配，永不释放，析构函数不会执行
+template <typename T>
+class immortal_control_block : public control_block_base {
+private:
+    alignas(alignof(T)) unsigned char storage_[sizeof(T)];
+
+public:
+    template <typename... Args>
+    immortal_control_block(Args&&... args) : control_block_base(immortal_tag{}) {
+        new (storage_) T(std::forward<Args>(args)...);
+    }
+
+    void dispose() noexcept override {}
+    void destroy() noexcept override {}
+
+    T* get() noexcept {
+        return reinterpret_cast<T*>(storage_);
+    }
+};
+
+// 哨兵控制块：所有被收养的静态对象共用同一个，永不销毁
+class static_control_block : public control_block_base {
+public:
+    static_control_block() noexcept : control_block_base(immortal_tag{}) {}
+
+    void dispose() noexcept override {}
+    void destroy() noexcept override {}
+
+    // 有意泄漏，保证其它静态对象析构时仍可安全访问
+    static static_control_block& instance() noexcept {
+        static static_control_block *sentinel = new static_control_block();
+        return *sentinel;
+    }
+};
+
+// 访问 shared_ptr/weak_ptr 内部表示的入口，供库内组件使用
+struct shared_ptr_access {
+    template <typename SP>
+    static control_block_base *control_block(const SP& p) noexcept {
+        return p.ctrl_block_;
+    }
+
+    template <typename SP>
+    static typename SP::element_type *pointer(const SP& p) noexcept {
+        return p.ptr_;
+    }
+
+    // 控制块指针在智能指针对象中的偏移（批量扫描按此布局直接加载）
+    template <typename SP>
+    static constexpr std::size_t control_block_offset() noexcept {
+        return offsetof(SP, ctrl_block_);
+    }
+
+    // 接管一个已计数的强引用
+    template <typename SP>
+    static SP adopt(control_block_base *cb, typename SP::element_type *p) noexcept {
+        return SP(cb, p);
+    }
+
+    // 放弃所有权但不释放引用，返回控制块（由调用者负责之后的释放）
+    template <typename SP>
+    static control_block_base *release(SP& p) noexcept {
+        control_block_base *cb = p.ctrl_block_;
+        p.ptr_ = nullptr;
+        p.ctrl_block_ = nullptr;
+        return cb;
+    }
+};
+
 // 控制块工厂函数
 template <typename T, typename Deleter>
 control_block_base* make_control_block(T *ptr, Deleter&& deleter) {
@@ -0,0 +1,237 @@
+/*
+    基于纪元的内存回收（EBR）：读者进入临界区时登记当前全局纪元，
+    被摘下的节点记录摘下时的纪元，等全局纪元前进两次（所有在场的读者都已离开旧纪元）后才释放。
+    读路径只有一次普通存储与一次栅栏，没有引用计数
+*/
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "traits.hpp"
+
+namespace my_ptr {
+namespace detail {
+
+// 待回收项：摘下时的纪元与释放函数
+struct epoch_retired {
+    void *ptr;
+    void (*deleter)(void *) noexcept;
+    std::uint64_t epoch;
+};
+
+// 每个线程一份记录。epoch 为 0 表示不在临界区；其余字段只由属主线程访问
+struct epoch_record {
+    alignas(cache_line_size) std::atomic<std::uint64_t> epoch{0};
+    std::atomic<bool> in_use{true};
+    epoch_record *next = nullptr;
+    unsigned nesting = 0;
+    std::vector<epoch_retired> limbo; // 按纪元递增排列
+    std::size_t limbo_head = 0;
+    std::size_t since_collect = 0;
+    bool reclaiming = false; // 释放函数里再次登记时不嵌套回收
+};
+
+class epoch_domain {
+private:
+    static constexpr std::size_t collect_interval = 64;
+
+    alignas(cache_line_size) std::atomic<std::uint64_t> global_{2}; // 0 表示不在临界区，从 2 起避免 global - 2 下溢
+    std::atomic<epoch_record*> records_{nullptr}; // 只增不减的链表，线程退出后记录留给后来的线程复用
+    std::mutex orphans_mutex_;
+    std::vector<epoch_retired> orphans_; // 已退出线程遗留的待回收项
+    std::atomic<bool> has_orphans_{false};
+
+    // 释放纪元不晚于 safe 的项，返回剩余个数
+    static std::size_t reclaim(std::vector<epoch_retired>& list, std::size_t& head, std::uint64_t safe) noexcept {
+        while (head < list.size() && list[head].epoch <= safe) {
+            epoch_retired item = list[head++]; // 释放函数可能向 list 追加
+            item.deleter(item.ptr);
+        }
+        if (head == list.size()) {
+            list.clear();
+            head = 0;
+        } else if (head > list.size() / 2) {
+            list.erase(list.begin(), list.begin() + static_cast<std::ptrdiff_t>(head));
+            head = 0;
+        }
+        return list.size() - head;
+    }
+
+    // 返回是否还有遗留项未释放
+    bool reclaim_orphans(std::uint64_t safe) noexcept {
+        if (!has_orphans_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        std::unique_lock<std::mutex> lock(orphans_mutex_, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return true;
+        }
+        std::vector<epoch_retired> kept;
+        for (const epoch_retired& r : orphans_) {
+            if (r.epoch <= safe) {
+                r.deleter(r.ptr);
+            } else {
+                kept.push_back(r);
+            }
+        }
+        orphans_.swap(kept);
+        has_orphans_.store(!orphans_.empty(), std::memory_order_release);
+        return !orphans_.empty();
+    }
+
+public:
+    // 有意泄漏，保证线程局部对象与其它静态对象析构时仍可访问
+    static epoch_domain& instance() noexcept {
+        static epoch_domain *domain = new epoch_domain();
+        return *domain;
+    }
+
+    epoch_record *attach() {
+        for (epoch_record *r = records_.load(std::memory_order_acquire); r; r = r->next) {
+            bool expected = false;
+            if (r->in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                return r;
+            }
+        }
+        auto *r = new epoch_record();
+        epoch_record *head = records_.load(std::memory_order_relaxed);
+        do {
+            r->next = head;
+        } while (!records_.compare_exchange_weak(head, r, std::memory_order_release, std::memory_order_relaxed));
+        return r;
+    }
+
+    // 线程退出：未回收的项转交给全局遗留列表
+    void detach(epoch_record *r) noexcept {
+        if (r->limbo_head < r->limbo.size()) {
+            std::lock_guard<std::mutex> lock(orphans_mutex_);
+            orphans_.insert(orphans_.end(), r->limbo.begin() + static_cast<std::ptrdiff_t>(r->limbo_head),
+                            r->limbo.end());
+            has_orphans_.store(true, std::memory_order_release);
+        }
+        r->limbo.clear();
+        r->limbo_head = 0;
+        r->since_collect = 0;
+        r->in_use.store(false, std::memory_order_release);
+    }
+
+    void enter(epoch_record& r) noexcept {
+        if (r.nesting++ == 0) {
+            r.epoch.store(global_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    void leave(epoch_record& r) noexcept {
+        if (--r.nesting == 0) {
+            r.epoch.store(0, std::memory_order_release);
+        }
+    }
+
+    // 所有在临界区内的线程都已看到当前纪元时推进一次
+    bool try_advance() noexcept {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::uint64_t g = global_.load(std::memory_order_relaxed);
+        for (epoch_record *r = records_.load(std::memory_order_acquire); r; r = r->next) {
+            std::uint64_t e = r->epoch.load(std::memory_order_relaxed);
+            if (e != 0 && e != g) {
+                return false;
+            }
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return global_.compare_exchange_strong(g, g + 1, std::memory_order_acq_rel);
+    }
+
+    // 登记一个已从数据结构中摘下的对象，调用者此后不再触及它
+    void retire(epoch_record& r, void *p, void (*deleter)(void *) noexcept) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        r.limbo.push_back(epoch_retired{p, deleter, global_.load(std::memory_order_relaxed)});
+        if (++r.since_collect >= collect_interval) {
+            r.since_collect = 0;
+            collect(r);
+        }
+    }
+
+    // 尝试推进纪元并释放本线程（以及遗留列表中）已安全的项
+    void collect(epoch_record& r) noexcept {
+        if (r.reclaiming) {
+            return;
+        }
+        r.reclaiming = true;
+        try_advance();
+        std::uint64_t safe = global_.load(std::memory_order_acquire) - 2;
+        reclaim(r.limbo, r.limbo_head, safe);
+        reclaim_orphans(safe);
+        r.reclaiming = false;
+    }
+
+    // 阻塞直到本线程此前登记的、以及已退出线程遗留的全部对象都被释放；不能在临界区内调用
+    void synchronize(epoch_record& r) noexcept {
+        if (r.reclaiming) {
+            return;
+        }
+        r.reclaiming = true;
+        for (;;) {
+            try_advance();
+            std::uint64_t safe = global_.load(std::memory_order_acquire) - 2;
+            bool orphans_left = reclaim_orphans(safe);
+            if (reclaim(r.limbo, r.limbo_head, safe) == 0 && !orphans_left) {
+                break;
+            }
+            std::this_thread::yield();
+        }
+        r.reclaiming = false;
+    }
+
+    std::uint64_t epoch() const noexcept { return global_.load(std::memory_order_acquire); }
+};
+
+struct epoch_record_holder {
+    epoch_record *record;
+
+    epoch_record_holder() : record(epoch_domain::instance().attach()) {}
+    ~epoch_record_holder() { epoch_domain::instance().detach(record); }
+};
+
+inline epoch_record& local_epoch_record() {
+    thread_local epoch_record_holder holder;
+    return *holder.record;
+}
+
+// 临界区：期间读到的节点在离开之前不会被释放。可以嵌套
+class epoch_guard {
+private:
+    epoch_record& record_;
+
+public:
+    epoch_guard() : record_(local_epoch_record()) {
+        epoch_domain::instance().enter(record_);
+    }
+
+    ~epoch_guard() {
+        epoch_domain::instance().leave(record_);
+    }
+
+    epoch_guard(const epoch_guard&) = delete;
+    epoch_guard& operator=(const epoch_guard&) = delete;
+};
+
+// 登记待回收的对象；deleter 在所有可能看到它的临界区结束后调用
+inline void epoch_retire_raw(void *p, void (*deleter)(void *) noexcept) {
+    epoch_domain::instance().retire(local_epoch_record(), p, deleter);
+}
+
+template <typename T>
+void epoch_retire(T *p) {
+    epoch_retire_raw(p, [](void *q) noexcept { delete static_cast<T*>(q); });
+}
+
+inline void epoch_synchronize() {
+    epoch_domain::instance().synchronize(local_epoch_record());
+}
+
+} // namespace detail
+} // namespace my_ptr
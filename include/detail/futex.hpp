@@ -0,0 +1,69 @@
+/*
+    32 位原子字上的阻塞等待/唤醒
+    Linux 直接使用 futex 系统调用，其它平台退化为带退避的轮询
+*/
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#if defined(__linux__)
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace my_ptr {
+namespace detail {
+
+static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t), "futex word must be 32 bits");
+
+// 若 *word == expected 则阻塞，直到被唤醒、超时（timeout 非空时）或被信号打断；允许虚假唤醒
+inline void futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected,
+                       const std::chrono::nanoseconds *timeout = nullptr) noexcept {
+#if defined(__linux__)
+    timespec ts;
+    timespec *pts = nullptr;
+    if (timeout) {
+        auto ns = timeout->count() > 0 ? timeout->count() : 0;
+        ts.tv_sec = static_cast<time_t>(ns / 1000000000);
+        ts.tv_nsec = static_cast<long>(ns % 1000000000);
+        pts = &ts;
+    }
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, pts, nullptr, 0);
+#else
+    auto deadline = std::chrono::steady_clock::now() + (timeout ? *timeout : std::chrono::hours(24));
+    for (int spin = 0; word.load(std::memory_order_acquire) == expected; ++spin) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return;
+        }
+        if (spin < 64) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+#endif
+}
+
+inline void futex_wake_all(std::atomic<std::uint32_t>& word) noexcept {
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+inline void futex_wake_one(std::atomic<std::uint32_t>& word) noexcept {
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+} // namespace detail
+} // namespace my_ptr
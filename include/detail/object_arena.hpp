@@ -0,0 +1,91 @@
+/*
+    对象内存池（单调分配，整块释放）
+*/
+#pragma once
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace my_ptr {
+namespace detail {
+
+class object_arena {
+private:
+    static constexpr std::size_t default_chunk_size = 64 * 1024;
+
+    std::vector<unsigned char*> chunks_;
+    unsigned char *cur_;
+    std::size_t remaining_;
+    std::size_t chunk_size_;
+
+    void new_chunk(std::size_t min_size) {
+        std::size_t size = min_size > chunk_size_ ? min_size : chunk_size_;
+        auto *chunk = static_cast<unsigned char*>(::operator new(size));
+        chunks_.push_back(chunk);
+        cur_ = chunk;
+        remaining_ = size;
+    }
+
+public:
+    explicit object_arena(std::size_t chunk_size = default_chunk_size) noexcept
+        : cur_(nullptr), remaining_(0), chunk_size_(chunk_size) {}
+
+    ~object_arena() {
+        release();
+    }
+
+    object_arena(const object_arena&) = delete;
+    object_arena& operator=(const object_arena&) = delete;
+
+    object_arena(object_arena&& other) noexcept
+        : chunks_(std::move(other.chunks_)), cur_(other.cur_),
+          remaining_(other.remaining_), chunk_size_(other.chunk_size_) {
+        other.cur_ = nullptr;
+        other.remaining_ = 0;
+    }
+
+    object_arena& operator=(object_arena&& other) noexcept {
+        if (this != &other) {
+            release();
+            chunks_ = std::move(other.chunks_);
+            cur_ = other.cur_;
+            remaining_ = other.remaining_;
+            chunk_size_ = other.chunk_size_;
+            other.cur_ = nullptr;
+            other.remaining_ = 0;
+        }
+        return *this;
+    }
+
+    void *allocate(std::size_t size, std::size_t align) {
+        std::size_t pad = (align - reinterpret_cast<std::size_t>(cur_) % align) % align;
+        if (cur_ == nullptr || pad + size > remaining_) {
+            new_chunk(size + align);
+            pad = (align - reinterpret_cast<std::size_t>(cur_) % align) % align;
+        }
+        void *p = cur_ + pad;
+        cur_ += pad + size;
+        remaining_ -= pad + size;
+        return p;
+    }
+
+    // 只释放内存，不调用析构函数
+    void release() noexcept {
+        for (unsigned char *chunk : chunks_) {
+            ::operator delete(chunk);
+        }
+        chunks_.clear();
+        cur_ = nullptr;
+        remaining_ = 0;
+    }
+
+    void swap(object_arena& other) noexcept {
+        chunks_.swap(other.chunks_);
+        std::swap(cur_, other.cur_);
+        std::swap(remaining_, other.remaining_);
+        std::swap(chunk_size_, other.chunk_size_);
+    }
+};
+
+} // namespace detail
+} // namespace my_ptr
@@ -0,0 +1,138 @@
+/*
+    迭代式析构队列：把级联释放展开成循环，避免长链递归导致栈溢出。
+    嵌套深度在 inline_depth 以内的释放照常递归执行，保持普通的析构顺序（子对象在父对象的析构函数内销毁）；
+    只有超过这个深度的释放才排队，由最外层循环执行
+*/
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+
+namespace my_ptr {
+namespace detail {
+
+// 一次延迟执行的释放操作
+struct deferred_release {
+    void *obj;
+    void (*run)(void *) noexcept;
+};
+
+// 线程局部状态全部是平凡类型，线程退出时其它 thread_local 对象的析构仍可安全使用
+struct teardown_state {
+    static constexpr std::size_t inline_capacity = 32;
+    static constexpr std::size_t inline_depth = 64; // 递归执行的最大嵌套深度
+
+    deferred_release inline_buf[inline_capacity];
+    deferred_release *heap_buf;
+    std::size_t base;           // 队列底部（最早入队、通常是最大的子图），供分流使用
+    std::size_t size;
+    std::size_t heap_capacity;
+    std::size_t depth;          // 当前递归执行的嵌套深度（最外层为 1）
+    bool draining;
+
+    // 可选的分流钩子：返回 true 表示该项已交给其它线程执行
+    bool (*offload)(void *ctx, deferred_release item) noexcept;
+    void *offload_ctx;
+};
+
+inline teardown_state& local_teardown_state() noexcept {
+    static thread_local teardown_state state{};
+    return state;
+}
+
+class teardown_queue {
+private:
+    static deferred_release *slot(teardown_state& st, std::size_t idx) noexcept {
+        return idx < teardown_state::inline_capacity
+            ? &st.inline_buf[idx]
+            : &st.heap_buf[idx - teardown_state::inline_capacity];
+    }
+
+    static bool push(teardown_state& st, deferred_release item) noexcept {
+        std::size_t idx = st.size;
+        if (idx >= teardown_state::inline_capacity + st.heap_capacity) {
+            std::size_t cap = st.heap_capacity ? st.heap_capacity * 2 : 64;
+            void *buf = std::realloc(st.heap_buf, cap * sizeof(deferred_release));
+            if (!buf) {
+                return false;
+            }
+            st.heap_buf = static_cast<deferred_release*>(buf);
+            st.heap_capacity = cap;
+        }
+        *slot(st, idx) = item;
+        ++st.size;
+        return true;
+    }
+
+public:
+    // 在作用域内为当前线程安装分流钩子（并行释放使用）
+    class offload_scope {
+    private:
+        teardown_state& st_;
+        bool (*prev_fn_)(void *, deferred_release) noexcept;
+        void *prev_ctx_;
+
+    public:
+        offload_scope(bool (*fn)(void *, deferred_release) noexcept, void *ctx) noexcept
+            : st_(local_teardown_state()), prev_fn_(st_.offload), prev_ctx_(st_.offload_ctx) {
+            st_.offload = fn;
+            st_.offload_ctx = ctx;
+        }
+
+        ~offload_scope() {
+            st_.offload = prev_fn_;
+            st_.offload_ctx = prev_ctx_;
+        }
+
+        offload_scope(const offload_scope&) = delete;
+        offload_scope& operator=(const offload_scope&) = delete;
+    };
+
+    // 当前线程是否正处于某个释放级联中
+    static bool in_teardown() noexcept {
+        return local_teardown_state().draining;
+    }
+
+    // 执行 run(obj)。若当前线程已在级联中：嵌套深度未超过 inline_depth 时直接递归执行；
+    // 否则排队由最外层循环执行（LIFO，即深度优先），入队失败（内存不足）时仍退回为递归执行。
+    // 安装了分流钩子（并行释放）时一律排队，队列底部的大子图才能交给其它线程
+    static void run(void *obj, void (*fn)(void *) noexcept) noexcept {
+        teardown_state& st = local_teardown_state();
+        if (st.draining) {
+            if (!st.offload && st.depth < teardown_state::inline_depth) {
+                ++st.depth;
+                fn(obj);
+                --st.depth;
+                return;
+            }
+            if (!push(st, deferred_release{obj, fn})) {
+                fn(obj);
+            }
+            return;
+        }
+
+        st.draining = true;
+        st.depth = 1;
+        fn(obj);
+        while (st.size != st.base) {
+            if (st.offload && st.size - st.base > 1 && st.offload(st.offload_ctx, *slot(st, st.base))) {
+                ++st.base;
+                continue;
+            }
+            deferred_release item = *slot(st, --st.size);
+            item.run(item.obj);
+        }
+        st.base = 0;
+        st.size = 0;
+        st.depth = 0;
+        st.draining = false;
+
+        if (st.heap_buf) {
+            std::free(st.heap_buf);
+            st.heap_buf = nullptr;
+            st.heap_capacity = 0;
+        }
+    }
+};
+
+} // namespace detail
+} // namespace my_ptr
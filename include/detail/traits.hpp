@@ -2,11 +2,33 @@
     基础类型特征和工具
 */
 #pragma once
+#include <cstddef>
 #include <type_traits>
 #include <utility>
 
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#endif
+
 namespace my_ptr {
 namespace detail {
 
+template <bool B, typename T = void>
+using enable_if_t = typename std::enable_if<B, T>::type;
+
+// 缓存行大小（用于对齐/填充以避免伪共享）
+constexpr std::size_t cache_line_size = 64;
+
+// 预取到缓存（只作提示，不影响语义）
+inline void prefetch(const void *p) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(p);
+#elif defined(_MSC_VER)
+    _mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#else
+    (void)p;
+#endif
+}
+
 } // namespace detail
 } // namespace my_ptr
\ No newline at end of file
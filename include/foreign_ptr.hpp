@@ -0,0 +1,302 @@
+/*
+    分片亲和的所有权：每个分片（shard）属于一个线程，对象只在所属分片上被访问和释放。
+    foreign_ptr<P> 包装分片上创建的 unique_ptr/shared_ptr，可以转交给其它分片；
+    在其它分片上析构时不就地释放，而是把释放操作压入所属分片的无锁收件箱，
+    由所属线程在 poll() 时执行。这样分片内部的热点状态（对象池、计数等）无需原子操作。
+    释放发生在另一个分片的线程上时，先按目标分片攒在本分片的发件箱里，
+    攒满一批或本分片 poll() 时再用一次 CAS 整批投递
+*/
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace my_ptr {
+
+namespace detail {
+
+// 收件箱中的一个待释放项
+struct foreign_release {
+    foreign_release *next;
+    void (*destroy)(foreign_release *) noexcept;
+};
+
+} // namespace detail
+
+// 分片：在所属线程上构造与析构，构造时登记为该线程的当前分片
+class shard {
+private:
+    static constexpr std::size_t node_block_size = 64;
+    static constexpr std::size_t max_cached_nodes = 1 << 16;
+    static constexpr std::size_t outbox_slots = 8;
+    static constexpr std::size_t outbox_batch = 64;
+
+    // 发往某个分片、尚未投递的释放项（链表，head 最新，tail 最早）
+    struct outbox_slot {
+        shard *dest;
+        detail::foreign_release *head;
+        detail::foreign_release *tail;
+        std::size_t count;
+    };
+
+    std::atomic<detail::foreign_release*> inbox_; // 多生产者栈，所属线程整体取走
+    outbox_slot outbox_[outbox_slots];            // 只由所属线程访问
+    shard *prev_current_;
+    // 包装节点的本地缓存：节点总在所属分片上分配和释放，普通链表即可
+    void *node_cache_;
+    std::size_t cached_nodes_;
+    std::size_t live_nodes_; // 已分配、尚未在本分片上释放的节点数
+
+    static shard*& current_slot() noexcept {
+        static thread_local shard *current = nullptr;
+        return current;
+    }
+
+    static std::size_t outbox_index(const shard *dest) noexcept {
+        return (reinterpret_cast<std::uintptr_t>(dest) >> 6) % outbox_slots;
+    }
+
+    // 把一段已经链好的释放项整体压入收件箱
+    void post_chain(detail::foreign_release *head, detail::foreign_release *tail) noexcept {
+        detail::foreign_release *top = inbox_.load(std::memory_order_relaxed);
+        do {
+            tail->next = top;
+        } while (!inbox_.compare_exchange_weak(top, head, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    void flush_slot(outbox_slot& slot) noexcept {
+        if (slot.count != 0) {
+            slot.dest->post_chain(slot.head, slot.tail);
+        }
+        slot = outbox_slot{};
+    }
+
+public:
+    shard() noexcept
+        : inbox_(nullptr), outbox_(), prev_current_(current_slot()), node_cache_(nullptr), cached_nodes_(0), live_nodes_(0) {
+        current_slot() = this;
+    }
+
+    // 析构会等到所有属于本分片的 foreign_ptr 都释放并送回：释放项可能还攒在其它分片的发件箱里，
+    // 那些分片必须继续 poll()/flush()；始终不释放的 foreign_ptr 会让析构一直阻塞
+    ~shard() {
+        poll();
+        while (live_nodes_ != 0) {
+            std::this_thread::yield();
+            poll();
+        }
+        while (node_cache_) {
+            void *next = *static_cast<void**>(node_cache_);
+            ::operator delete(node_cache_);
+            node_cache_ = next;
+        }
+        current_slot() = prev_current_;
+    }
+
+    shard(const shard&) = delete;
+    shard& operator=(const shard&) = delete;
+
+    // 调用线程的当前分片（没有则为 nullptr）
+    static shard *current() noexcept { return current_slot(); }
+
+    bool is_home() const noexcept { return current_slot() == this; }
+
+    // 执行收件箱中的全部释放并投递发件箱，返回处理的个数（只能在所属线程调用）
+    std::size_t poll() noexcept {
+        detail::foreign_release *list = inbox_.exchange(nullptr, std::memory_order_acquire);
+        // 栈序反转为到达顺序
+        detail::foreign_release *ordered = nullptr;
+        while (list) {
+            detail::foreign_release *next = list->next;
+            list->next = ordered;
+            ordered = list;
+            list = next;
+        }
+        std::size_t n = 0;
+        while (ordered) {
+            detail::foreign_release *next = ordered->next;
+            ordered->destroy(ordered);
+            ordered = next;
+            ++n;
+        }
+        flush();
+        return n;
+    }
+
+    // 立即投递发件箱中攒下的全部释放项
+    void flush() noexcept {
+        for (outbox_slot& slot : outbox_) {
+            flush_slot(slot);
+        }
+    }
+
+    // 属于本分片、尚未释放回来的 foreign_ptr 个数（只能在所属线程调用）
+    std::size_t outstanding() const noexcept { return live_nodes_; }
+
+    bool inbox_empty() const noexcept {
+        return inbox_.load(std::memory_order_acquire) == nullptr;
+    }
+
+    // 其它线程把释放操作投递到本分片
+    void post_release(detail::foreign_release *item) noexcept {
+        post_chain(item, item);
+    }
+
+    // 在本分片的线程上释放属于 dest 的对象：先攒进发件箱（只能在所属线程调用）
+    void defer_release(shard *dest, detail::foreign_release *item) noexcept {
+        outbox_slot& slot = outbox_[outbox_index(dest)];
+        if (slot.dest != dest) {
+            flush_slot(slot);
+            slot.dest = dest;
+            slot.tail = item;
+        }
+        item->next = slot.head;
+        slot.head = item;
+        if (++slot.count >= outbox_batch) {
+            flush_slot(slot);
+        }
+    }
+
+    // ---- 包装节点的分配（只能在所属线程调用） ----
+    void *allocate_node(std::size_t size) {
+        void *p;
+        if (size <= node_block_size && node_cache_) {
+            p = node_cache_;
+            node_cache_ = *static_cast<void**>(p);
+            --cached_nodes_;
+        } else {
+            p = ::operator new(size <= node_block_size ? node_block_size : size);
+        }
+        ++live_nodes_;
+        return p;
+    }
+
+    void deallocate_node(void *p, std::size_t size) noexcept {
+        --live_nodes_;
+        if (size <= node_block_size && cached_nodes_ < max_cached_nodes) {
+            *static_cast<void**>(p) = node_cache_;
+            node_cache_ = p;
+            ++cached_nodes_;
+            return;
+        }
+        ::operator delete(p);
+    }
+};
+
+namespace detail {
+
+template <typename P>
+struct foreign_node : foreign_release {
+    P ptr;
+    shard *home;
+
+    foreign_node(P&& p, shard *h) noexcept : foreign_release{nullptr, &destroy_node}, ptr(std::move(p)), home(h) {}
+
+    // 在所属线程上释放被包装的指针与节点本身
+    static void destroy_node(foreign_release *item) noexcept {
+        auto *self = static_cast<foreign_node*>(item);
+        shard *h = self->home;
+        self->~foreign_node();
+        h->deallocate_node(self, sizeof(foreign_node));
+    }
+};
+
+} // namespace detail
+
+// 跨分片传递的所有权包装。只能移动；解引用在任何分片上都可以（访问约束由调用者遵守），
+// 释放总是回到所属分片执行
+template <typename P>
+class foreign_ptr {
+public:
+    using pointer_type = P;
+    using element_type = typename P::element_type;
+
+private:
+    detail::foreign_node<P> *node_;
+
+public:
+    constexpr foreign_ptr() noexcept : node_(nullptr) {}
+    constexpr foreign_ptr(std::nullptr_t) noexcept : node_(nullptr) {}
+
+    // 必须在所属分片的线程上构造；调用线程没有分片时抛出 std::logic_error
+    explicit foreign_ptr(P p) : node_(nullptr) {
+        shard *home = shard::current();
+        if (!home) {
+            throw std::logic_error("foreign_ptr: calling thread has no shard");
+        }
+        if (p) {
+            void *mem = home->allocate_node(sizeof(detail::foreign_node<P>));
+            node_ = new (mem) detail::foreign_node<P>(std::move(p), home);
+        }
+    }
+
+    foreign_ptr(foreign_ptr&& other) noexcept : node_(std::exchange(other.node_, nullptr)) {}
+
+    foreign_ptr& operator=(foreign_ptr&& other) noexcept {
+        foreign_ptr(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    foreign_ptr(const foreign_ptr&) = delete;
+    foreign_ptr& operator=(const foreign_ptr&) = delete;
+
+    ~foreign_ptr() {
+        reset();
+    }
+
+    // 在所属分片上就地释放；否则交给当前分片的发件箱，没有分片的线程直接投递到收件箱
+    void reset() noexcept {
+        detail::foreign_node<P> *node = std::exchange(node_, nullptr);
+        if (!node) {
+            return;
+        }
+        shard *current = shard::current();
+        if (current == node->home) {
+            detail::foreign_node<P>::destroy_node(node);
+        } else if (current) {
+            current->defer_release(node->home, node);
+        } else {
+            node->home->post_release(node);
+        }
+    }
+
+    // 取回被包装的指针（只能在所属分片上调用，否则抛出 std::logic_error）
+    P release() {
+        if (!node_) {
+            return P();
+        }
+        if (!node_->home->is_home()) {
+            throw std::logic_error("foreign_ptr::release called off the home shard");
+        }
+        P p = std::move(node_->ptr);
+        reset();
+        return p;
+    }
+
+    void swap(foreign_ptr& other) noexcept {
+        std::swap(node_, other.node_);
+    }
+
+    shard *home() const noexcept { return node_ ? node_->home : nullptr; }
+
+    element_type *get() const noexcept { return node_ ? node_->ptr.get() : nullptr; }
+    element_type& operator*() const noexcept { return *get(); }
+    element_type *operator->() const noexcept { return get(); }
+    explicit operator bool() const noexcept { return node_ != nullptr; }
+};
+
+template <typename P>
+foreign_ptr<P> make_foreign(P p) {
+    return foreign_ptr<P>(std::move(p));
+}
+
+template <typename P>
+void swap(foreign_ptr<P>& lhs, foreign_ptr<P>& rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+} // namespace my_ptr
@@ -0,0 +1,171 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include "shared_ptr.hpp"
+#include "detail/control_block.hpp"
+#include "detail/traits.hpp"
+
+namespace my_ptr {
+
+namespace detail {
+
+template <typename T, typename Hash, typename Eq>
+struct intern_state;
+
+// 驻留值的控制块：值与控制块一起分配；dispose 时先从池中摘除条目，再析构值，
+// 因此条目的生命周期严格跟随最后一个外部引用，不需要周期性清扫
+template <typename T, typename Hash, typename Eq>
+class intern_control_block : public control_block_base {
+private:
+    alignas(alignof(T)) unsigned char storage_[sizeof(T)];
+    shared_ptr<intern_state<T, Hash, Eq>> pool_;
+    std::size_t hash_;
+
+public:
+    template <typename... Args>
+    intern_control_block(shared_ptr<intern_state<T, Hash, Eq>> pool, Args&&... args)
+        : control_block_base(), pool_(std::move(pool)), hash_(0) {
+        new (storage_) T(std::forward<Args>(args)...);
+    }
+
+    void dispose() noexcept override;
+
+    void destroy() noexcept override {
+        delete this;
+    }
+
+    const T *get() const noexcept {
+        return reinterpret_cast<const T*>(storage_);
+    }
+
+    std::size_t hash() const noexcept { return hash_; }
+    void set_hash(std::size_t h) noexcept { hash_ = h; }
+};
+
+// 池的共享状态：每个驻留值持有一个引用，池本身先析构也不会留下悬空指针
+template <typename T, typename Hash, typename Eq>
+struct intern_state {
+    using block_type = intern_control_block<T, Hash, Eq>;
+
+    struct key_hash {
+        Hash hash;
+        std::size_t operator()(const T *v) const { return hash(*v); }
+    };
+
+    struct key_equal {
+        Eq eq;
+        bool operator()(const T *a, const T *b) const { return eq(*a, *b); }
+    };
+
+    struct alignas(cache_line_size) shard {
+        std::mutex mutex;
+        std::unordered_map<const T*, block_type*, key_hash, key_equal> map;
+    };
+
+    std::unique_ptr<shard[]> shards;
+    std::size_t mask;
+    Hash hash;
+
+    explicit intern_state(std::size_t n) : shards(new shard[n]), mask(n - 1) {}
+
+    shard& shard_for(std::size_t h) noexcept {
+        return shards[(h ^ (h >> 17)) & mask];
+    }
+};
+
+template <typename T, typename Hash, typename Eq>
+void intern_control_block<T, Hash, Eq>::dispose() noexcept {
+    auto& s = pool_->shard_for(hash_);
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        auto it = s.map.find(get());
+        // 可能已被一个相等的新条目替换，只删除指向自己的条目
+        if (it != s.map.end() && it->second == this) {
+            s.map.erase(it);
+        }
+    }
+    get()->~T();
+    pool_.reset();
+}
+
+} // namespace detail
+
+// 并发驻留池：相等的不可变值共享同一个 shared_ptr<const T>；
+// 最后一个外部引用释放时条目在 dispose 中自动移除
+template <typename T, typename Hash = std::hash<T>, typename Eq = std::equal_to<T>>
+class intern_pool {
+private:
+    using state_type = detail::intern_state<T, Hash, Eq>;
+    using block_type = typename state_type::block_type;
+
+    shared_ptr<state_type> state_;
+
+    template <typename U>
+    shared_ptr<const T> intern_impl(U&& value) {
+        std::size_t h = state_->hash(value);
+        auto& s = state_->shard_for(h);
+        std::unique_lock<std::mutex> lock(s.mutex);
+        auto it = s.map.find(&value);
+        if (it != s.map.end()) {
+            block_type *cb = it->second;
+            if (cb->try_add_shared_ref()) {
+                return detail::shared_ptr_access::adopt<shared_ptr<const T>>(cb, cb->get());
+            }
+            // 旧条目正在被销毁：移除，由新条目取代
+            s.map.erase(it);
+        }
+        auto *cb = new block_type(state_, std::forward<U>(value));
+        cb->set_hash(h);
+        try {
+            s.map.emplace(cb->get(), cb);
+        } catch (...) {
+            // dispose 需要获取分片锁，必须先解锁
+            lock.unlock();
+            cb->release_shared();
+            throw;
+        }
+        return detail::shared_ptr_access::adopt<shared_ptr<const T>>(cb, cb->get());
+    }
+
+public:
+    // 分片数向上取整为 2 的幂
+    explicit intern_pool(std::size_t shards = 16) {
+        std::size_t n = 1;
+        while (n < shards) {
+            n <<= 1;
+        }
+        state_ = shared_ptr<state_type>(new state_type(n));
+    }
+
+    intern_pool(const intern_pool&) = delete;
+    intern_pool& operator=(const intern_pool&) = delete;
+
+    shared_ptr<const T> intern(const T& value) {
+        return intern_impl(value);
+    }
+
+    shared_ptr<const T> intern(T&& value) {
+        return intern_impl(std::move(value));
+    }
+
+    template <typename... Args>
+    shared_ptr<const T> emplace(Args&&... args) {
+        return intern_impl(T(std::forward<Args>(args)...));
+    }
+
+    // 当前存活的不同值个数
+    std::size_t size() const {
+        std::size_t n = 0;
+        for (std::size_t i = 0; i <= state_->mask; ++i) {
+            std::lock_guard<std::mutex> lock(state_->shards[i].mutex);
+            n += state_->shards[i].map.size();
+        }
+        return n;
+    }
+};
+
+} // namespace my_ptr
@@ -0,0 +1,219 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "shared_ptr.hpp"
+#include "detail/traits.hpp"
+
+namespace my_ptr {
+
+// 默认代价：按值类型的 sizeof 计费
+template <typename V>
+struct sizeof_cost {
+    std::size_t operator()(const V&) const noexcept { return sizeof(V); }
+};
+
+// 分片的并发 LRU 缓存（CLOCK 近似）。
+// 命中只在共享锁下设置访问位，不修改链表；插入时由时钟指针扫描淘汰。
+// 值以 shared_ptr<V> 交出，被淘汰后调用者持有的引用仍然有效
+template <typename K, typename V, typename Hash = std::hash<K>, typename Cost = sizeof_cost<V>>
+class lru_cache {
+private:
+    struct entry {
+        const K *key;
+        shared_ptr<V> value;
+        std::size_t cost;
+        std::atomic<bool> referenced;
+        entry *prev;
+        entry *next;
+
+        entry() noexcept : key(nullptr), cost(0), referenced(false), prev(nullptr), next(nullptr) {}
+    };
+
+    // 每个分片：哈希表节点即链表节点（侵入式循环链表），hand_ 是时钟指针
+    struct alignas(detail::cache_line_size) shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<K, entry, Hash> map;
+        entry *hand = nullptr;
+        std::size_t bytes = 0;
+        std::size_t capacity = 0;
+
+        // 插入到时钟指针之前（即最后才会被扫描到）
+        void link(entry *e) noexcept {
+            if (!hand) {
+                e->prev = e->next = e;
+                hand = e;
+                return;
+            }
+            e->next = hand;
+            e->prev = hand->prev;
+            hand->prev->next = e;
+            hand->prev = e;
+        }
+
+        void unlink(entry *e) noexcept {
+            if (e->next == e) {
+                hand = nullptr;
+            } else {
+                if (hand == e) {
+                    hand = e->next;
+                }
+                e->prev->next = e->next;
+                e->next->prev = e->prev;
+            }
+        }
+
+        // CLOCK 淘汰：跳过并清除访问位，淘汰第一个未被访问的条目
+        void evict_until_fits(std::vector<shared_ptr<V>>& evicted) {
+            while (bytes > capacity && hand) {
+                entry *e = hand;
+                if (e->referenced.load(std::memory_order_relaxed)) {
+                    e->referenced.store(false, std::memory_order_relaxed);
+                    hand = e->next;
+                    continue;
+                }
+                // 先扩容再修改分片：push_back 抛出时分片保持原样
+                if (evicted.size() == evicted.capacity()) {
+                    evicted.reserve(evicted.size() * 2 + 8);
+                }
+                unlink(e);
+                bytes -= e->cost;
+                evicted.push_back(std::move(e->value));
+                map.erase(*e->key);
+            }
+        }
+    };
+
+    std::unique_ptr<shard[]> shards_;
+    std::size_t shard_mask_;
+    Hash hash_;
+    Cost cost_;
+
+    shard& shard_for(const K& key) const noexcept {
+        std::size_t h = hash_(key);
+        h ^= h >> 29;
+        h *= 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 32;
+        return shards_[h & shard_mask_];
+    }
+
+public:
+    // capacity_bytes 按分片平均分配（余数分给前几个分片）；分片数向上取整为 2 的幂，
+    // 但不超过 capacity_bytes，分片容量不会被除成 0
+    explicit lru_cache(std::size_t capacity_bytes, std::size_t shards = 16,
+                       const Hash& hash = Hash(), const Cost& cost = Cost())
+        : shard_mask_(0), hash_(hash), cost_(cost) {
+        std::size_t n = 1;
+        while (n < shards && n * 2 <= capacity_bytes) {
+            n <<= 1;
+        }
+        shards_.reset(new shard[n]);
+        shard_mask_ = n - 1;
+        for (std::size_t i = 0; i < n; ++i) {
+            shards_[i].capacity = capacity_bytes / n + (i < capacity_bytes % n ? 1 : 0);
+        }
+    }
+
+    lru_cache(const lru_cache&) = delete;
+    lru_cache& operator=(const lru_cache&) = delete;
+
+    // 命中返回值并设置访问位；未命中返回空指针
+    shared_ptr<V> get(const K& key) const {
+        shard& s = shard_for(key);
+        std::shared_lock<std::shared_mutex> lock(s.mutex);
+        auto it = s.map.find(key);
+        if (it == s.map.end()) {
+            return shared_ptr<V>();
+        }
+        entry& e = it->second;
+        if (!e.referenced.load(std::memory_order_relaxed)) {
+            e.referenced.store(true, std::memory_order_relaxed);
+        }
+        return e.value;
+    }
+
+    // 插入或替换；cost 为该条目计入容量的字节数
+    void put(const K& key, shared_ptr<V> value, std::size_t cost) {
+        std::vector<shared_ptr<V>> evicted;
+        evicted.reserve(8); // 锁外预留：替换旧值的 push_back 不会在修改分片后抛出
+        {
+            shard& s = shard_for(key);
+            std::unique_lock<std::shared_mutex> lock(s.mutex);
+            auto res = s.map.try_emplace(key);
+            entry& e = res.first->second;
+            if (res.second) {
+                e.key = &res.first->first;
+                s.link(&e);
+            } else {
+                s.bytes -= e.cost;
+                evicted.push_back(std::move(e.value));
+            }
+            e.value = std::move(value);
+            e.cost = cost;
+            s.bytes += cost;
+            s.evict_until_fits(evicted);
+        }
+        // 被淘汰的值在锁外释放
+    }
+
+    void put(const K& key, shared_ptr<V> value) {
+        std::size_t cost = value ? cost_(*value) : 0;
+        put(key, std::move(value), cost);
+    }
+
+    bool erase(const K& key) {
+        shared_ptr<V> victim;
+        shard& s = shard_for(key);
+        std::unique_lock<std::shared_mutex> lock(s.mutex);
+        auto it = s.map.find(key);
+        if (it == s.map.end()) {
+            return false;
+        }
+        s.unlink(&it->second);
+        s.bytes -= it->second.cost;
+        victim = std::move(it->second.value);
+        s.map.erase(it);
+        lock.unlock();
+        return true;
+    }
+
+    void clear() {
+        for (std::size_t i = 0; i <= shard_mask_; ++i) {
+            std::unordered_map<K, entry, Hash> victims;
+            {
+                std::unique_lock<std::shared_mutex> lock(shards_[i].mutex);
+                victims.swap(shards_[i].map);
+                shards_[i].hand = nullptr;
+                shards_[i].bytes = 0;
+            }
+        }
+    }
+
+    std::size_t size() const {
+        std::size_t n = 0;
+        for (std::size_t i = 0; i <= shard_mask_; ++i) {
+            std::shared_lock<std::shared_mutex> lock(shards_[i].mutex);
+            n += shards_[i].map.size();
+        }
+        return n;
+    }
+
+    std::size_t bytes() const {
+        std::size_t n = 0;
+        for (std::size_t i = 0; i <= shard_mask_; ++i) {
+            std::shared_lock<std::shared_mutex> lock(shards_[i].mutex);
+            n += shards_[i].bytes;
+        }
+        return n;
+    }
+
+    std::size_t shard_count() const noexcept { return shard_mask_ + 1; }
+};
+
+} // namespace my_ptr
@@ -0,0 +1,131 @@
+#pragma once
+#include <cerrno>
+#include <cstddef>
+#include <string>
+#include <system_error>
+#include <utility>
+#include "shared_ptr.hpp"
+#include "shared_buffer.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MY_PTR_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#endif
+
+namespace my_ptr {
+
+// map_file 的访问提示，可按位组合；平台不支持的提示被忽略
+enum map_flags : unsigned {
+    map_default    = 0,
+    map_sequential = 1u << 0, // MADV_SEQUENTIAL：顺序扫描，内核加大预读
+    map_random     = 1u << 1, // MADV_RANDOM：随机访问，关闭预读
+    map_willneed   = 1u << 2, // MADV_WILLNEED：立即异步预取整个文件
+    map_hugepage   = 1u << 3, // MADV_HUGEPAGE：允许透明大页
+    map_populate   = 1u << 4, // MAP_POPULATE：返回前建立全部页表项（Linux）
+};
+
+#if defined(MY_PTR_HAS_MMAP)
+
+namespace detail {
+
+// munmap 删除器：保存在 separate_control_block 中，最后一个切片释放时解除映射
+struct munmap_delete {
+    std::size_t length;
+
+    void operator()(char *p) const noexcept {
+        ::munmap(p, length);
+    }
+};
+
+inline void apply_map_advice(void *addr, std::size_t length, unsigned flags) noexcept {
+    if (flags & map_sequential) {
+        ::madvise(addr, length, MADV_SEQUENTIAL);
+    }
+    if (flags & map_random) {
+        ::madvise(addr, length, MADV_RANDOM);
+    }
+    if (flags & map_willneed) {
+        ::madvise(addr, length, MADV_WILLNEED);
+    }
+#if defined(MADV_HUGEPAGE)
+    if (flags & map_hugepage) {
+        ::madvise(addr, length, MADV_HUGEPAGE);
+    }
+#endif
+}
+
+} // namespace detail
+
+// 以只读方式映射整个文件。返回的切片及其所有子切片共享映射的所有权，
+// 映射在最后一个引用释放时 munmap。失败时抛出 std::system_error；空文件返回空切片
+inline buffer_slice map_file(const std::string& path, unsigned flags = map_default) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "map_file: open " + path);
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        int err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::generic_category(), "map_file: fstat " + path);
+    }
+    std::size_t length = static_cast<std::size_t>(st.st_size);
+    if (length == 0) {
+        ::close(fd);
+        return buffer_slice();
+    }
+
+    int mmap_flags = MAP_PRIVATE;
+#if defined(MAP_POPULATE)
+    if (flags & map_populate) {
+        mmap_flags |= MAP_POPULATE;
+    }
+#endif
+    void *addr = ::mmap(nullptr, length, PROT_READ, mmap_flags, fd, 0);
+    int err = errno;
+    ::close(fd); // 映射建立后文件描述符不再需要
+    if (addr == MAP_FAILED) {
+        throw std::system_error(err, std::generic_category(), "map_file: mmap " + path);
+    }
+    detail::apply_map_advice(addr, length, flags);
+
+    shared_ptr<char> mapping;
+    try {
+        mapping = shared_ptr<char>(static_cast<char*>(addr), detail::munmap_delete{length});
+    } catch (...) {
+        ::munmap(addr, length);
+        throw;
+    }
+    return buffer_slice(shared_ptr<const char>(std::move(mapping)), length);
+}
+
+#else
+
+// 无 mmap 的平台：退化为把整个文件读入 shared_buffer，接口与语义不变
+inline buffer_slice map_file(const std::string& path, unsigned flags = map_default) {
+    (void)flags;
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        throw std::system_error(std::make_error_code(std::errc::no_such_file_or_directory),
+                                "map_file: open " + path);
+    }
+    std::size_t length = static_cast<std::size_t>(in.tellg());
+    if (length == 0) {
+        return buffer_slice();
+    }
+    shared_buffer buf(length);
+    in.seekg(0);
+    if (!in.read(buf.data(), static_cast<std::streamsize>(length))) {
+        throw std::system_error(std::make_error_code(std::errc::io_error), "map_file: read " + path);
+    }
+    return buf.slice();
+}
+
+#endif
+
+} // namespace my_ptr
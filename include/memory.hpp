@@ -18,6 +18,29 @@
 #include "unique_ptr.hpp"
 #include "shared_ptr.hpp"
 #include "weak_ptr.hpp"
+#include "ptr_vector.hpp"
+#include "thread_pool.hpp"
+#include "parallel_release.hpp"
+#include "ownership_queue.hpp"
+#include "spsc_ring.hpp"
+#include "lru_cache.hpp"
+#include "intern_pool.hpp"
+#include "shared_buffer.hpp"
+#include "mapped_file.hpp"
+#include "chunk_reader.hpp"
+#include "buffer_chain.hpp"
+#include "serialization.hpp"
+#include "snapshot.hpp"
+#include "weighted_shared_ptr.hpp"
+#include "deferred_shared_ptr.hpp"
+#include "async_shared_ptr.hpp"
+#include "foreign_ptr.hpp"
+#include "slot_map.hpp"
+#include "compacting_arena.hpp"
+#include "skiplist_map.hpp"
+#include "observer_list.hpp"
+#include "bulk_weak.hpp"
+#include "cached_pointer_cast.hpp"
 #include "detail/control_block.hpp"
 
 namespace my_ptr {
@@ -0,0 +1,221 @@
+/*
+    观察者列表：以弱引用登记监听者，dispatch 时只通知仍存活的对象。
+    列表内容是不可变快照，写者在锁内复制出新快照再原子发布，旧快照经纪元回收释放；
+    dispatch 不加锁，只在纪元临界区内读取当前快照。
+    通知按批进行：先对一批控制块尝试加强引用，再逐个回调，最后整批释放。
+    dispatch 发现的失效项累计到阈值后顺手整理快照（拿不到写锁就留给下一次），清理成本被摊薄
+*/
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "shared_ptr.hpp"
+#include "detail/control_block.hpp"
+#include "detail/epoch.hpp"
+#include "detail/traits.hpp"
+
+namespace my_ptr {
+
+template <typename T>
+class observer_list {
+private:
+    static constexpr std::size_t batch_size = 32;
+    static constexpr std::size_t prefetch_distance = 8;
+
+    struct entry {
+        detail::control_block_base *cb;
+        T *ptr;
+    };
+
+    // 不可变快照：为每一项持有一个弱引用
+    struct snapshot {
+        std::vector<entry> entries;
+
+        snapshot() = default;
+        explicit snapshot(std::vector<entry>&& e) noexcept : entries(std::move(e)) {}
+
+        snapshot(const snapshot&) = delete;
+        snapshot& operator=(const snapshot&) = delete;
+
+        ~snapshot() {
+            for (const entry& e : entries) {
+                e.cb->release_weak();
+            }
+        }
+    };
+
+    std::atomic<snapshot*> current_;
+    std::atomic<std::size_t> expired_hint_; // 最近一次 dispatch 看到的失效项数
+    std::mutex write_mutex_;
+
+    // 复制当前快照的存活项（为每项加弱引用），keep(entry) 为假的项被丢弃
+    template <typename Keep>
+    std::vector<entry> copy_entries(const snapshot *s, std::size_t extra, Keep&& keep) const {
+        std::vector<entry> out;
+        out.reserve(s->entries.size() + extra);
+        for (const entry& e : s->entries) {
+            if (keep(e)) {
+                e.cb->add_weak_ref();
+                out.push_back(e);
+            }
+        }
+        return out;
+    }
+
+    // 调用者持有写锁
+    void publish(std::vector<entry>&& entries) {
+        auto *next = new snapshot(std::move(entries));
+        snapshot *old = current_.exchange(next, std::memory_order_acq_rel);
+        expired_hint_.store(0, std::memory_order_relaxed);
+        detail::epoch_retire(old);
+    }
+
+    static bool alive(const entry& e) noexcept { return e.cb->use_count() != 0; }
+
+    // 调用者持有写锁
+    std::size_t compact_locked() {
+        const snapshot *s = current_.load(std::memory_order_acquire);
+        std::size_t dropped = 0;
+        for (const entry& e : s->entries) {
+            dropped += alive(e) ? 0 : 1;
+        }
+        if (dropped != 0) {
+            publish(copy_entries(s, 0, alive));
+        }
+        return dropped;
+    }
+
+    // 一次 dispatch 中失效项达到多少时触发整理
+    static std::size_t compaction_threshold(std::size_t n) noexcept {
+        return n / 8 > 16 ? n / 8 : 16;
+    }
+
+public:
+    observer_list() : current_(new snapshot()), expired_hint_(0) {}
+
+    // 析构时不能有并发的 dispatch
+    ~observer_list() {
+        delete current_.load(std::memory_order_relaxed);
+    }
+
+    observer_list(const observer_list&) = delete;
+    observer_list& operator=(const observer_list&) = delete;
+
+    // 登记监听者（只保留弱引用）
+    void add(const shared_ptr<T>& listener) {
+        add(&listener, &listener + 1);
+    }
+
+    // 一次登记一批，只复制一次快照；复制时顺带丢弃已失效的项
+    template <typename It>
+    void add(It first, It last) {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        const snapshot *s = current_.load(std::memory_order_acquire);
+        std::vector<entry> entries = copy_entries(s, static_cast<std::size_t>(std::distance(first, last)), alive);
+        for (; first != last; ++first) {
+            detail::control_block_base *cb = detail::shared_ptr_access::control_block(*first);
+            if (cb) {
+                cb->add_weak_ref();
+                entries.push_back(entry{cb, first->get()});
+            }
+        }
+        publish(std::move(entries));
+    }
+
+    // 注销监听者，返回是否找到
+    bool remove(const shared_ptr<T>& listener) {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        const snapshot *s = current_.load(std::memory_order_acquire);
+        T *p = listener.get();
+        bool found = false;
+        std::vector<entry> entries = copy_entries(s, 0, [&](const entry& e) {
+            if (e.ptr == p) {
+                found = true;
+                return false;
+            }
+            return alive(e);
+        });
+        if (found) {
+            publish(std::move(entries));
+        } else {
+            for (const entry& e : entries) {
+                e.cb->release_weak();
+            }
+        }
+        return found;
+    }
+
+    // 丢弃已失效的项，返回丢弃的个数
+    std::size_t compact() {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        return compact_locked();
+    }
+
+    // 对每个存活的监听者调用 f(T&)，返回调用次数。回调中可以 add/remove，
+    // 变化从下一次 dispatch 起可见
+    template <typename F>
+    std::size_t dispatch(F&& f) {
+        std::size_t called = 0;
+        std::size_t expired = 0;
+        std::size_t total;
+        {
+            detail::epoch_guard guard;
+            const snapshot *s = current_.load(std::memory_order_acquire);
+            const entry *items = s->entries.data();
+            total = s->entries.size();
+            entry locked[batch_size];
+            for (std::size_t base = 0; base < total; base += batch_size) {
+                std::size_t end = base + batch_size < total ? base + batch_size : total;
+                // 先整批加强引用：加引用的原子操作彼此独立，预取让缓存缺失重叠
+                std::size_t n = 0;
+                for (std::size_t i = base; i < end; ++i) {
+                    if (i + prefetch_distance < total) {
+                        detail::prefetch(items[i + prefetch_distance].cb);
+                    }
+                    if (items[i].cb->try_add_shared_ref()) {
+                        locked[n++] = items[i];
+                    } else {
+                        ++expired;
+                    }
+                }
+                std::size_t done = 0;
+                try {
+                    for (; done < n; ++done) {
+                        f(*locked[done].ptr);
+                    }
+                } catch (...) {
+                    for (std::size_t i = 0; i < n; ++i) {
+                        locked[i].cb->release_shared();
+                    }
+                    throw;
+                }
+                for (std::size_t i = 0; i < n; ++i) {
+                    locked[i].cb->release_shared();
+                }
+                called += n;
+            }
+        }
+        expired_hint_.store(expired, std::memory_order_relaxed);
+        if (expired >= compaction_threshold(total)) {
+            std::unique_lock<std::mutex> lock(write_mutex_, std::try_to_lock);
+            if (lock.owns_lock()) {
+                compact_locked();
+            }
+        }
+        return called;
+    }
+
+    // 快照中的项数（包括尚未整理掉的失效项）
+    std::size_t size() const {
+        detail::epoch_guard guard;
+        return current_.load(std::memory_order_acquire)->entries.size();
+    }
+
+    // 最近一次 dispatch 观察到的失效项数
+    std::size_t expired_hint() const noexcept { return expired_hint_.load(std::memory_order_relaxed); }
+};
+
+} // namespace my_ptr
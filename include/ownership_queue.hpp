@@ -0,0 +1,121 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "detail/traits.hpp"
+
+namespace my_ptr {
+
+// 有界无锁 MPMC 队列（Vyukov 环形缓冲），专门用于在线程间转移智能指针的所有权。
+// 入队/出队都是移动构造，shared_ptr/unique_ptr 只搬运内部的指针对，不产生任何引用计数原子操作
+template <typename P>
+class ownership_queue {
+    static_assert(std::is_nothrow_move_constructible_v<P> && std::is_nothrow_move_assignable_v<P>,
+                  "ownership_queue requires a nothrow-movable element");
+
+private:
+    struct slot {
+        std::atomic<std::size_t> seq;
+        alignas(alignof(P)) unsigned char storage[sizeof(P)];
+
+        P *get() noexcept { return reinterpret_cast<P*>(storage); }
+    };
+
+    slot *slots_;
+    std::size_t mask_;
+    alignas(detail::cache_line_size) std::atomic<std::size_t> enqueue_pos_;
+    alignas(detail::cache_line_size) std::atomic<std::size_t> dequeue_pos_;
+
+    static std::size_t round_up_pow2(std::size_t n) {
+        std::size_t cap = 2;
+        while (cap < n) {
+            cap <<= 1;
+        }
+        return cap;
+    }
+
+public:
+    using value_type = P;
+
+    // 容量向上取整为 2 的幂
+    explicit ownership_queue(std::size_t capacity)
+        : slots_(nullptr), mask_(round_up_pow2(capacity) - 1), enqueue_pos_(0), dequeue_pos_(0) {
+        slots_ = static_cast<slot*>(::operator new(sizeof(slot) * (mask_ + 1)));
+        for (std::size_t i = 0; i <= mask_; ++i) {
+            new (&slots_[i].seq) std::atomic<std::size_t>(i);
+        }
+    }
+
+    ~ownership_queue() {
+        P tmp;
+        while (try_pop(tmp)) {
+        }
+        ::operator delete(slots_);
+    }
+
+    ownership_queue(const ownership_queue&) = delete;
+    ownership_queue& operator=(const ownership_queue&) = delete;
+
+    // 队列满时返回 false，value 保持原样
+    bool try_push(P&& value) noexcept {
+        std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        slot *s;
+        for (;;) {
+            s = &slots_[pos & mask_];
+            std::size_t seq = s->seq.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        new (s->storage) P(std::move(value));
+        s->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 队列空时返回 false；成功时把所有权移动到 out（out 原有的对象被释放）
+    bool try_pop(P& out) noexcept {
+        std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        slot *s;
+        for (;;) {
+            s = &slots_[pos & mask_];
+            std::size_t seq = s->seq.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        P *item = s->get();
+        out = std::move(*item);
+        item->~P();
+        s->seq.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::size_t capacity() const noexcept { return mask_ + 1; }
+
+    // 近似元素个数（并发修改时仅供参考）
+    std::size_t size_approx() const noexcept {
+        std::size_t head = dequeue_pos_.load(std::memory_order_relaxed);
+        std::size_t tail = enqueue_pos_.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    bool empty_approx() const noexcept { return size_approx() == 0; }
+};
+
+} // namespace my_ptr
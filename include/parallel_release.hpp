@@ -0,0 +1,124 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include "shared_ptr.hpp"
+#include "detail/teardown.hpp"
+
+namespace my_ptr {
+
+namespace detail {
+
+// 一次并行释放的共享状态
+struct parallel_release_state {
+    std::atomic<std::size_t> pending;   // 尚未完成的任务数（含根任务）
+    std::size_t max_in_flight;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done;
+
+    explicit parallel_release_state(std::size_t max_tasks) noexcept
+        : pending(1), max_in_flight(max_tasks), done(false) {}
+
+    void finish_one() {
+        if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+            cv.notify_all();
+        }
+    }
+};
+
+template <typename Executor>
+struct parallel_release_context {
+    Executor *executor;
+    shared_ptr<parallel_release_state> state;
+
+    // 分流钩子：未达并行上限时把队列底部的释放项交给执行器
+    static bool offload(void *ctx, deferred_release item) noexcept {
+        auto *self = static_cast<parallel_release_context*>(ctx);
+        parallel_release_state& st = *self->state;
+        std::size_t cur = st.pending.load(std::memory_order_relaxed);
+        do {
+            if (cur >= st.max_in_flight) {
+                return false;
+            }
+        } while (!st.pending.compare_exchange_weak(cur, cur + 1, std::memory_order_acq_rel,
+                                                   std::memory_order_relaxed));
+        try {
+            parallel_release_context child{self->executor, self->state};
+            self->executor->post([child, item]() mutable {
+                child.run_item(item);
+            });
+        } catch (...) {
+            st.pending.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    void run_item(deferred_release item) {
+        {
+            teardown_queue::offload_scope scope(&offload, this);
+            teardown_queue::run(item.obj, item.run);
+        }
+        state->finish_one();
+    }
+};
+
+} // namespace detail
+
+// 并行释放的完成句柄
+class release_handle {
+private:
+    shared_ptr<detail::parallel_release_state> state_;
+
+public:
+    release_handle() noexcept = default;
+    explicit release_handle(shared_ptr<detail::parallel_release_state> state) noexcept
+        : state_(std::move(state)) {}
+
+    bool done() const {
+        if (!state_) {
+            return true;
+        }
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return state_->done;
+    }
+
+    // 阻塞直到整个释放级联执行完毕
+    void wait() const {
+        if (!state_) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        state_->cv.wait(lock, [this]() { return state_->done; });
+    }
+};
+
+// 在执行器上并行执行 ptr 的最终释放级联。Executor 需提供 post(F)，例如 my_ptr::thread_pool。
+// max_parallelism 限制同时排队/执行的任务数，0 表示使用硬件线程数
+template <typename T, typename Executor>
+release_handle parallel_release(shared_ptr<T>&& ptr, Executor& executor, std::size_t max_parallelism = 0) {
+    if (max_parallelism == 0) {
+        max_parallelism = std::thread::hardware_concurrency();
+        if (max_parallelism == 0) {
+            max_parallelism = 1;
+        }
+    }
+    shared_ptr<detail::parallel_release_state> state(new detail::parallel_release_state(max_parallelism));
+    detail::parallel_release_context<Executor> ctx{&executor, state};
+    executor.post([ctx, root = std::move(ptr)]() mutable {
+        {
+            detail::teardown_queue::offload_scope scope(&decltype(ctx)::offload, &ctx);
+            root.reset();
+        }
+        ctx.state->finish_one();
+    });
+    return release_handle(std::move(state));
+}
+
+} // namespace my_ptr
@@ -0,0 +1,337 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "unique_ptr.hpp"
+#include "detail/object_arena.hpp"
+#include "detail/traits.hpp"
+
+namespace my_ptr {
+
+// 内存池删除器：只调用析构函数，内存由 ptr_vector 内部的 arena 统一回收
+template <typename T>
+struct arena_delete {
+    constexpr arena_delete() noexcept = default;
+
+    template <typename U, typename = detail::enable_if_t<std::is_convertible_v<U*, T*>>>
+    arena_delete(const arena_delete<U>&) noexcept {}
+
+    void operator()(T *ptr) const noexcept {
+        ptr->~T();
+    }
+};
+
+namespace detail {
+
+template <typename Deleter>
+struct is_arena_delete : std::false_type {};
+
+template <typename T>
+struct is_arena_delete<arena_delete<T>> : std::true_type {};
+
+// 解引用为 T& 的间接迭代器
+template <typename T, typename Ptr>
+class indirect_iterator {
+private:
+    Ptr *it_;
+
+    template <typename U, typename P>
+    friend class indirect_iterator;
+
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::remove_cv_t<T>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+
+    indirect_iterator() noexcept : it_(nullptr) {}
+    explicit indirect_iterator(Ptr *it) noexcept : it_(it) {}
+
+    template <typename U, typename P, typename = enable_if_t<std::is_convertible_v<P*, Ptr*>>>
+    indirect_iterator(const indirect_iterator<U, P>& other) noexcept : it_(other.it_) {}
+
+    reference operator*() const noexcept { return **it_; }
+    pointer operator->() const noexcept { return *it_; }
+    reference operator[](difference_type n) const noexcept { return *it_[n]; }
+    Ptr *base() const noexcept { return it_; }
+
+    indirect_iterator& operator++() noexcept { ++it_; return *this; }
+    indirect_iterator operator++(int) noexcept { return indirect_iterator(it_++); }
+    indirect_iterator& operator--() noexcept { --it_; return *this; }
+    indirect_iterator operator--(int) noexcept { return indirect_iterator(it_--); }
+    indirect_iterator& operator+=(difference_type n) noexcept { it_ += n; return *this; }
+    indirect_iterator& operator-=(difference_type n) noexcept { it_ -= n; return *this; }
+    indirect_iterator operator+(difference_type n) const noexcept { return indirect_iterator(it_ + n); }
+    indirect_iterator operator-(difference_type n) const noexcept { return indirect_iterator(it_ - n); }
+    difference_type operator-(const indirect_iterator& other) const noexcept { return it_ - other.it_; }
+
+    bool operator==(const indirect_iterator& other) const noexcept { return it_ == other.it_; }
+    bool operator!=(const indirect_iterator& other) const noexcept { return it_ != other.it_; }
+    bool operator<(const indirect_iterator& other) const noexcept { return it_ < other.it_; }
+    bool operator>(const indirect_iterator& other) const noexcept { return it_ > other.it_; }
+    bool operator<=(const indirect_iterator& other) const noexcept { return it_ <= other.it_; }
+    bool operator>=(const indirect_iterator& other) const noexcept { return it_ >= other.it_; }
+};
+
+// 按地址排序指针数组：地址范围较小时用基数排序（每轮 11 位），否则退回 std::sort
+template <typename P>
+void sort_by_address(P *data, std::size_t n) noexcept {
+    constexpr std::size_t small_size = 256;
+    constexpr unsigned radix_bits = 11;
+    constexpr std::size_t buckets = std::size_t(1) << radix_bits;
+
+    if (n < small_size) {
+        std::sort(data, data + n, std::less<P>());
+        return;
+    }
+
+    std::uintptr_t lo = reinterpret_cast<std::uintptr_t>(data[0]);
+    std::uintptr_t hi = lo;
+    for (std::size_t i = 1; i < n; ++i) {
+        std::uintptr_t v = reinterpret_cast<std::uintptr_t>(data[i]);
+        lo = v < lo ? v : lo;
+        hi = v > hi ? v : hi;
+    }
+    // 对象至少按 alignof(max_align_t) 的一半对齐，低位不参与排序
+    constexpr unsigned shift = 3;
+    std::uintptr_t range = (hi - lo) >> shift;
+    unsigned passes = 0;
+    while (range != 0) {
+        ++passes;
+        range >>= radix_bits;
+    }
+    if (passes > 3) {
+        std::sort(data, data + n, std::less<P>());
+        return;
+    }
+
+    std::vector<P> tmp;
+    std::vector<std::size_t> count;
+    try {
+        tmp.resize(n);
+        count.resize(buckets);
+    } catch (...) {
+        std::sort(data, data + n, std::less<P>());
+        return;
+    }
+    P *src = data;
+    P *dst = tmp.data();
+    for (unsigned pass = 0; pass < passes; ++pass) {
+        unsigned bit = shift + pass * radix_bits;
+        std::fill(count.begin(), count.end(), 0);
+        for (std::size_t i = 0; i < n; ++i) {
+            ++count[((reinterpret_cast<std::uintptr_t>(src[i]) - lo) >> bit) & (buckets - 1)];
+        }
+        std::size_t sum = 0;
+        for (std::size_t b = 0; b < buckets; ++b) {
+            std::size_t c = count[b];
+            count[b] = sum;
+            sum += c;
+        }
+        for (std::size_t i = 0; i < n; ++i) {
+            P p = src[i];
+            dst[count[((reinterpret_cast<std::uintptr_t>(p) - lo) >> bit) & (buckets - 1)]++] = p;
+        }
+        std::swap(src, dst);
+    }
+    if (src != data) {
+        std::copy(src, src + n, data);
+    }
+}
+
+} // namespace detail
+
+// 独占所有权的指针容器：裸指针连续存放，插入/移除时按 unique_ptr 语义转移所有权
+template <typename T, typename Deleter = detail::default_delete<T>>
+class ptr_vector {
+public:
+    using value_type = T;
+    using pointer = T*;
+    using deleter_type = Deleter;
+    using size_type = std::size_t;
+    using iterator = detail::indirect_iterator<T, T* const>;
+    using const_iterator = detail::indirect_iterator<const T, T* const>;
+    using unique_type = unique_ptr<T, Deleter>;
+
+private:
+    static constexpr bool uses_arena = detail::is_arena_delete<Deleter>::value;
+    static constexpr size_type prefetch_distance = 8;
+
+    std::vector<pointer> ptrs_;
+    deleter_type deleter_;
+    detail::object_arena arena_;
+
+    // 先保证还有一个空位（按几何级数扩容），之后的 push_back 不会抛出，已接管的指针不会泄漏
+    void reserve_one() {
+        if (ptrs_.size() == ptrs_.capacity()) {
+            ptrs_.reserve(std::max<size_type>(2 * ptrs_.capacity(), 8));
+        }
+    }
+
+    void destroy_range(pointer *first, pointer *last) noexcept {
+        for (pointer *it = first; it != last; ++it) {
+            deleter_(*it);
+        }
+    }
+
+public:
+    // 构造/析构
+    ptr_vector() noexcept(std::is_nothrow_default_constructible_v<Deleter>) : deleter_() {}
+
+    explicit ptr_vector(const deleter_type& deleter) : deleter_(deleter) {}
+
+    ptr_vector(ptr_vector&& other) noexcept
+        : ptrs_(std::move(other.ptrs_)), deleter_(std::move(other.deleter_)), arena_(std::move(other.arena_)) {
+        other.ptrs_.clear();
+    }
+
+    ptr_vector& operator=(ptr_vector&& other) noexcept {
+        ptr_vector(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    ptr_vector(const ptr_vector&) = delete;
+    ptr_vector& operator=(const ptr_vector&) = delete;
+
+    ~ptr_vector() {
+        clear();
+    }
+
+    // 插入：接管 unique_ptr 的所有权。元素统一由容器的删除器释放，传入的删除器不能带状态；
+    // arena_delete 模式下的对象只能由 emplace_back 在内部内存池中创建
+    template <typename U, typename E, typename = detail::enable_if_t<
+                std::is_convertible_v<U*, T*> && std::is_constructible_v<Deleter, E&&>>>
+    void push_back(unique_ptr<U, E>&& ptr) {
+        static_assert(!uses_arena, "arena_delete ptr_vector only owns objects created by emplace_back");
+        static_assert(std::is_empty_v<E>, "ptr_vector deletes with its own deleter; stateful deleters would be dropped");
+        reserve_one();
+        ptrs_.push_back(ptr.release());
+    }
+
+    template <typename U, typename E, typename = detail::enable_if_t<
+                std::is_convertible_v<U*, T*> && std::is_constructible_v<Deleter, E&&>>>
+    iterator insert(const_iterator pos, unique_ptr<U, E>&& ptr) {
+        static_assert(!uses_arena, "arena_delete ptr_vector only owns objects created by emplace_back");
+        static_assert(std::is_empty_v<E>, "ptr_vector deletes with its own deleter; stateful deleters would be dropped");
+        size_type idx = static_cast<size_type>(pos.base() - ptrs_.data());
+        ptrs_.insert(ptrs_.begin() + idx, nullptr);
+        ptrs_[idx] = ptr.release();
+        return iterator(ptrs_.data() + idx);
+    }
+
+    // 原位构造（支持派生类）；arena_delete 模式下从内部内存池分配
+    template <typename U = T, typename... Args>
+    U& emplace_back(Args&&... args) {
+        static_assert(std::is_convertible_v<U*, T*>, "emplace_back type must derive from T");
+        reserve_one();
+        U *obj;
+        if constexpr (uses_arena) {
+            void *mem = arena_.allocate(sizeof(U), alignof(U));
+            obj = new (mem) U(std::forward<Args>(args)...);
+        } else {
+            obj = new U(std::forward<Args>(args)...);
+        }
+        ptrs_.push_back(obj);
+        return *obj;
+    }
+
+    // 移除：以 unique_ptr 形式归还所有权。arena_delete 模式下对象的内存属于内部内存池，不能交出
+    unique_type release(const_iterator pos) {
+        static_assert(!uses_arena, "objects in an arena_delete ptr_vector cannot outlive the container");
+        pointer p = *pos.base();
+        ptrs_.erase(ptrs_.begin() + (pos.base() - ptrs_.data()));
+        return unique_type(p, deleter_);
+    }
+
+    unique_type pop_back() {
+        static_assert(!uses_arena, "objects in an arena_delete ptr_vector cannot outlive the container");
+        pointer p = ptrs_.back();
+        ptrs_.pop_back();
+        return unique_type(p, deleter_);
+    }
+
+    iterator erase(const_iterator pos) noexcept {
+        return erase(pos, pos + 1);
+    }
+
+    iterator erase(const_iterator first, const_iterator last) noexcept {
+        auto idx = first.base() - ptrs_.data();
+        auto count = last.base() - first.base();
+        destroy_range(ptrs_.data() + idx, ptrs_.data() + idx + count);
+        ptrs_.erase(ptrs_.begin() + idx, ptrs_.begin() + idx + count);
+        return iterator(ptrs_.data() + idx);
+    }
+
+    // 批量释放：按地址排序后顺序删除并预取，提高分配器的局部性
+    void clear() noexcept {
+        if (!ptrs_.empty()) {
+            pointer *data = ptrs_.data();
+            size_type n = ptrs_.size();
+            detail::sort_by_address(data, n);
+            for (size_type i = 0; i < n; ++i) {
+                if (i + prefetch_distance < n) {
+                    detail::prefetch(data[i + prefetch_distance]);
+                }
+                deleter_(data[i]);
+            }
+            ptrs_.clear();
+        }
+        if constexpr (uses_arena) {
+            arena_.release();
+        }
+    }
+
+    void swap(ptr_vector& other) noexcept {
+        ptrs_.swap(other.ptrs_);
+        std::swap(deleter_, other.deleter_);
+        arena_.swap(other.arena_);
+    }
+
+    void reserve(size_type n) { ptrs_.reserve(n); }
+
+    // 访问器
+    size_type size() const noexcept { return ptrs_.size(); }
+    size_type capacity() const noexcept { return ptrs_.capacity(); }
+    bool empty() const noexcept { return ptrs_.empty(); }
+
+    T& operator[](size_type idx) noexcept { return *ptrs_[idx]; }
+    const T& operator[](size_type idx) const noexcept { return *ptrs_[idx]; }
+
+    T& at(size_type idx) {
+        if (idx >= ptrs_.size()) {
+            throw std::out_of_range("ptr_vector::at");
+        }
+        return *ptrs_[idx];
+    }
+
+    T& front() noexcept { return *ptrs_.front(); }
+    T& back() noexcept { return *ptrs_.back(); }
+
+    // 连续存放的裸指针数组
+    pointer const *data() const noexcept { return ptrs_.data(); }
+
+    deleter_type& get_deleter() noexcept { return deleter_; }
+    const deleter_type& get_deleter() const noexcept { return deleter_; }
+
+    iterator begin() noexcept { return iterator(ptrs_.data()); }
+    iterator end() noexcept { return iterator(ptrs_.data() + ptrs_.size()); }
+    const_iterator begin() const noexcept { return const_iterator(ptrs_.data()); }
+    const_iterator end() const noexcept { return const_iterator(ptrs_.data() + ptrs_.size()); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+};
+
+// 非成员函数
+template <typename T, typename Deleter>
+void swap(ptr_vector<T, Deleter>& lhs, ptr_vector<T, Deleter>& rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+} // namespace my_ptr
@@ -0,0 +1,574 @@
+/*
+    保持共享关系的二进制序列化
+    每个 (控制块, 指针, 静态类型) 视图分配一个 ID，共享对象只写一次；加载时按原样恢复 shared_ptr/weak_ptr/unique_ptr 边。
+    同一控制块上首先出现的视图作为根写出对象体；之后落在根对象范围内的视图（别名指针指向的成员、
+    派生类对象的基类子对象）只记录根的 ID 与字节偏移，加载后与根共用控制块。
+    不落在根范围内的视图（例如先经成员别名、后经所有者到达同一对象）无法还原，保存时抛出 serialization_error。
+    对象体按指针的静态类型写出：多态对象的动态类型与静态类型不同时会被切片，同样在保存时抛出 serialization_error。
+    类型通过成员函数 template <typename Archive> void serialize(Archive& ar) 参与，保存与加载共用同一个访问函数。
+    对象体按首次出现的顺序排队写出、排队读入，任意深度的链表/DAG 都不会递归；
+    加载时先登记对象再读取对象体，因此环（经 weak_ptr 或 shared_ptr）也能恢复
+*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "unique_ptr.hpp"
+#include "shared_ptr.hpp"
+#include "weak_ptr.hpp"
+#include "detail/control_block.hpp"
+
+namespace my_ptr {
+
+class serialization_error : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+class output_archive;
+class input_archive;
+
+namespace detail {
+
+constexpr char archive_magic[4] = {'M', 'P', 'S', 'G'};
+constexpr std::uint64_t archive_version = 1;
+
+// 新 ID 之后紧跟的标记：独立对象（随后排队写出对象体），或同一控制块上根对象内的别名视图
+constexpr std::uint64_t ref_object = 0;
+constexpr std::uint64_t ref_alias = 1;
+constexpr std::size_t archive_buffer_size = 64 * 1024;
+
+template <typename T, typename = void>
+struct has_serialize : std::false_type {};
+
+template <typename T>
+struct has_serialize<T, std::void_t<decltype(std::declval<T&>().serialize(std::declval<output_archive&>()))>>
+    : std::true_type {};
+
+inline std::uint64_t zigzag_encode(std::int64_t v) noexcept {
+    return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+}
+
+inline std::int64_t zigzag_decode(std::uint64_t v) noexcept {
+    return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+}
+
+} // namespace detail
+
+// 输出档案：带缓冲地写入 std::ostream。
+// 整数用 LEB128 变长编码（有符号数先做 zigzag），浮点数按主机字节序原样写出
+class output_archive {
+private:
+    struct pending_body {
+        const void *obj;
+        void (*write)(output_archive&, const void*);
+        detail::control_block_base *keep; // 经 weak_ptr 发现的对象：写完对象体之前持有一个强引用
+    };
+
+    // 视图：同一控制块（永生控制块按对象地址区分）上的一个 (指针, 静态类型)
+    struct view_key {
+        const void *group;
+        const void *ptr;
+        const std::type_info *type;
+
+        bool operator==(const view_key& other) const noexcept {
+            return group == other.group && ptr == other.ptr && *type == *other.type;
+        }
+    };
+
+    struct view_hash {
+        std::size_t operator()(const view_key& k) const noexcept {
+            std::size_t h = std::hash<const void*>()(k.group);
+            h ^= std::hash<const void*>()(k.ptr) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+            return h ^ (k.type->hash_code() + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2));
+        }
+    };
+
+    // 控制块上首先出现的视图：写出对象体，其余视图以它为基准记录偏移
+    struct group_root {
+        std::uint64_t id;
+        const char *ptr;
+        std::size_t size;
+    };
+
+    std::ostream& os_;
+    std::vector<char> buffer_;
+    std::size_t used_;
+    std::unordered_map<view_key, std::uint64_t, view_hash> ids_;
+    std::unordered_map<const void*, group_root> roots_;
+    std::deque<pending_body> pending_;
+    bool draining_;
+
+    template <typename T>
+    static void write_body(output_archive& ar, const void *obj) {
+        ar.write(*static_cast<const T*>(obj));
+    }
+
+    // 对象体只按静态类型 T 写出，动态类型更具体的多态对象会被切片
+    template <typename T>
+    static void check_not_sliced(const T *obj) {
+        if constexpr (std::is_polymorphic_v<T>) {
+            if (typeid(*obj) != typeid(T)) {
+                throw serialization_error(std::string("output_archive: a ") + typeid(*obj).name() +
+                                          " object would be saved through its base " + typeid(T).name() +
+                                          "; reach it through a pointer to its dynamic type first");
+            }
+        }
+    }
+
+    void put(char c) {
+        if (used_ == buffer_.size()) {
+            flush_buffer();
+        }
+        buffer_[used_++] = c;
+    }
+
+    void flush_buffer() {
+        os_.write(buffer_.data(), static_cast<std::streamsize>(used_));
+        used_ = 0;
+        if (!os_) {
+            throw serialization_error("output_archive: write failed");
+        }
+    }
+
+    void release_pending() noexcept {
+        for (auto& job : pending_) {
+            if (job.keep) {
+                job.keep->release_shared();
+            }
+        }
+        pending_.clear();
+    }
+
+    void drain() {
+        draining_ = true;
+        try {
+            while (!pending_.empty()) {
+                pending_body job = pending_.front();
+                pending_.pop_front();
+                job.write(*this, job.obj);
+                if (job.keep) {
+                    job.keep->release_shared();
+                }
+            }
+        } catch (...) {
+            release_pending();
+            draining_ = false;
+            throw;
+        }
+        draining_ = false;
+    }
+
+    // 写出对象引用：0 表示空；视图首次出现时分配新 ID，随后写出它是独立对象（排队写出对象体）
+    // 还是根对象内的别名（根 ID 与字节偏移）。
+    // 永生控制块可能被多个静态对象共用（adopt_static），此时以对象地址区分
+    template <typename T>
+    void write_ref(detail::control_block_base *cb, const T *obj, bool keep) {
+        if (!cb || !obj) {
+            write_varint(0);
+            return;
+        }
+        const void *group = cb->immortal() ? static_cast<const void*>(obj) : static_cast<const void*>(cb);
+        auto res = ids_.try_emplace(view_key{group, obj, &typeid(T)}, ids_.size() + 1);
+        write_varint(res.first->second);
+        if (!res.second) {
+            return;
+        }
+        const char *p = reinterpret_cast<const char*>(obj);
+        auto root = roots_.find(group);
+        if (root == roots_.end()) {
+            check_not_sliced(obj);
+            roots_.emplace(group, group_root{res.first->second, p, sizeof(T)});
+            write_varint(detail::ref_object);
+            pending_.push_back(pending_body{obj, &write_body<T>, keep ? cb : nullptr});
+            if (keep) {
+                cb->add_shared_ref();
+            }
+            return;
+        }
+        const group_root& r = root->second;
+        if (p < r.ptr || p + sizeof(T) > r.ptr + r.size) {
+            throw serialization_error(std::string("output_archive: a ") + typeid(T).name() +
+                                      " view lies outside the object first saved for its control block; "
+                                      "reach the owning object first");
+        }
+        write_varint(detail::ref_alias);
+        write_varint(r.id);
+        write_varint(static_cast<std::uint64_t>(p - r.ptr));
+    }
+
+    template <typename T>
+    void write(const T& v) {
+        if constexpr (std::is_same_v<T, bool>) {
+            put(v ? 1 : 0);
+        } else if constexpr (std::is_enum_v<T>) {
+            write(static_cast<std::underlying_type_t<T>>(v));
+        } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+            write_varint(detail::zigzag_encode(static_cast<std::int64_t>(v)));
+        } else if constexpr (std::is_integral_v<T>) {
+            write_varint(static_cast<std::uint64_t>(v));
+        } else if constexpr (std::is_floating_point_v<T>) {
+            write_bytes(&v, sizeof(v));
+        } else {
+            static_assert(detail::has_serialize<T>::value,
+                          "type must provide template <typename Archive> void serialize(Archive&)");
+            const_cast<T&>(v).serialize(*this);
+        }
+    }
+
+    template <typename T>
+    void write(const shared_ptr<T>& p) {
+        write_ref(detail::shared_ptr_access::control_block(p), p.get(), false);
+    }
+
+    // 已过期的 weak_ptr 写为空
+    template <typename T>
+    void write(const weak_ptr<T>& w) {
+        shared_ptr<T> p = w.lock();
+        write_ref(detail::shared_ptr_access::control_block(p), p.get(), true);
+    }
+
+    // unique_ptr 的目标不会被共享：不分配 ID，只写一个存在标记
+    template <typename T, typename D>
+    void write(const unique_ptr<T, D>& p) {
+        if (p) {
+            check_not_sliced(p.get());
+        }
+        put(p ? 1 : 0);
+        if (p) {
+            pending_.push_back(pending_body{p.get(), &write_body<T>, nullptr});
+        }
+    }
+
+    void write(const std::string& s) {
+        write_varint(s.size());
+        write_bytes(s.data(), s.size());
+    }
+
+    template <typename T, typename A>
+    void write(const std::vector<T, A>& v) {
+        write_varint(v.size());
+        for (const auto& e : v) {
+            write(e);
+        }
+    }
+
+public:
+    explicit output_archive(std::ostream& os)
+        : os_(os), buffer_(detail::archive_buffer_size), used_(0), draining_(false) {
+        write_bytes(detail::archive_magic, sizeof(detail::archive_magic));
+        write_varint(detail::archive_version);
+    }
+
+    ~output_archive() {
+        release_pending();
+        if (used_) {
+            os_.write(buffer_.data(), static_cast<std::streamsize>(used_));
+        }
+        os_.flush();
+    }
+
+    output_archive(const output_archive&) = delete;
+    output_archive& operator=(const output_archive&) = delete;
+
+    // 依次写出各个值；最外层调用返回前写完所有新发现对象的对象体
+    template <typename... Args>
+    output_archive& operator()(const Args&... args) {
+        (write(args), ...);
+        if (!draining_) {
+            drain();
+        }
+        return *this;
+    }
+
+    // 把缓冲写入流，出错抛出 serialization_error
+    void flush() {
+        flush_buffer();
+        os_.flush();
+    }
+
+    void write_varint(std::uint64_t v) {
+        while (v >= 0x80) {
+            put(static_cast<char>(v | 0x80));
+            v >>= 7;
+        }
+        put(static_cast<char>(v));
+    }
+
+    void write_bytes(const void *src, std::size_t n) {
+        const char *p = static_cast<const char*>(src);
+        while (n > 0) {
+            if (used_ == buffer_.size()) {
+                flush_buffer();
+            }
+            std::size_t chunk = buffer_.size() - used_ < n ? buffer_.size() - used_ : n;
+            std::memcpy(buffer_.data() + used_, p, chunk);
+            used_ += chunk;
+            p += chunk;
+            n -= chunk;
+        }
+    }
+
+    // 已写出的共享对象个数（别名视图不计）
+    std::size_t objects_written() const noexcept { return roots_.size(); }
+};
+
+// 输入档案：直接经 std::istream 的 streambuf 读取（流自身已有缓冲），只消耗档案本身的字节，
+// 流中档案之后的数据留给调用者。
+// 所有加载的共享对象在档案析构前各被持有一个强引用，同一档案中的多个根之间的共享关系得以保留；
+// 只被 weak_ptr 引用的对象在档案析构后随之过期（与序列化时没有被保存的持有者一致）
+class input_archive {
+private:
+    // 已加载的视图；别名视图与根共用控制块
+    struct loaded_object {
+        detail::control_block_base *cb;
+        void *obj;
+        const std::type_info *type;
+        std::size_t size;
+        bool root;
+    };
+
+    struct pending_body {
+        void *obj;
+        void (*read)(input_archive&, void*);
+    };
+
+    std::istream& is_;
+    std::streambuf *sb_;
+    std::vector<loaded_object> objects_;
+    std::size_t roots_read_;
+    std::deque<pending_body> pending_;
+    bool draining_;
+
+    template <typename T>
+    static void read_body(input_archive& ar, void *obj) {
+        ar.read(*static_cast<T*>(obj));
+    }
+
+    [[noreturn]] void truncated() {
+        is_.setstate(std::ios::eofbit | std::ios::failbit);
+        throw serialization_error("input_archive: unexpected end of archive");
+    }
+
+    char get() {
+        int c = sb_->sbumpc();
+        if (c == std::char_traits<char>::eof()) {
+            truncated();
+        }
+        return static_cast<char>(c);
+    }
+
+    void drain() {
+        draining_ = true;
+        try {
+            while (!pending_.empty()) {
+                pending_body job = pending_.front();
+                pending_.pop_front();
+                job.read(*this, job.obj);
+            }
+        } catch (...) {
+            pending_.clear();
+            draining_ = false;
+            throw;
+        }
+        draining_ = false;
+    }
+
+    // 读取对象引用：已加载的 ID 直接共享；新的别名视图指向根对象内的偏移；
+    // 新的独立对象先构造、登记，再排队读取对象体
+    template <typename T>
+    shared_ptr<T> read_ref() {
+        std::uint64_t id = read_varint();
+        if (id == 0) {
+            return shared_ptr<T>();
+        }
+        if (id <= objects_.size()) {
+            const loaded_object& e = objects_[id - 1];
+            if (*e.type != typeid(T)) {
+                throw serialization_error("input_archive: object type mismatch");
+            }
+            e.cb->add_shared_ref();
+            return detail::shared_ptr_access::adopt<shared_ptr<T>>(e.cb, static_cast<T*>(e.obj));
+        }
+        if (id != objects_.size() + 1) {
+            throw serialization_error("input_archive: invalid object id");
+        }
+        // 先腾出登记位置，之后的 push_back 不会抛出
+        if (objects_.size() == objects_.capacity()) {
+            objects_.reserve(objects_.size() * 2 + 16);
+        }
+        std::uint64_t kind = read_varint();
+        if (kind == detail::ref_alias) {
+            std::uint64_t root_id = read_varint();
+            std::uint64_t offset = read_varint();
+            if (root_id == 0 || root_id > objects_.size() || !objects_[root_id - 1].root) {
+                throw serialization_error("input_archive: invalid alias root");
+            }
+            const loaded_object& r = objects_[root_id - 1];
+            if (offset > r.size || sizeof(T) > r.size - offset) {
+                throw serialization_error("input_archive: alias offset out of range");
+            }
+            // 保存时该视图就位于根对象内的这个偏移处，加载端的对象布局相同
+            T *p = reinterpret_cast<T*>(static_cast<char*>(r.obj) + offset);
+            r.cb->add_shared_ref(); // 档案持有
+            r.cb->add_shared_ref(); // 返回值持有
+            objects_.push_back(loaded_object{r.cb, p, &typeid(T), sizeof(T), false});
+            return detail::shared_ptr_access::adopt<shared_ptr<T>>(r.cb, p);
+        }
+        if (kind != detail::ref_object) {
+            throw serialization_error("input_archive: invalid reference kind");
+        }
+        static_assert(std::is_default_constructible_v<T>, "deserialized types must be default constructible");
+        pending_body job{nullptr, &read_body<T>};
+        pending_.push_back(job);
+        shared_ptr<T> p;
+        try {
+            p = make_shared<T>();
+        } catch (...) {
+            pending_.pop_back();
+            throw;
+        }
+        detail::control_block_base *cb = detail::shared_ptr_access::control_block(p);
+        cb->add_shared_ref();
+        objects_.push_back(loaded_object{cb, p.get(), &typeid(T), sizeof(T), true});
+        ++roots_read_;
+        pending_.back().obj = p.get();
+        return p;
+    }
+
+    template <typename T>
+    void read(T& v) {
+        if constexpr (std::is_same_v<T, bool>) {
+            v = get() != 0;
+        } else if constexpr (std::is_enum_v<T>) {
+            std::underlying_type_t<T> u;
+            read(u);
+            v = static_cast<T>(u);
+        } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+            v = static_cast<T>(detail::zigzag_decode(read_varint()));
+        } else if constexpr (std::is_integral_v<T>) {
+            v = static_cast<T>(read_varint());
+        } else if constexpr (std::is_floating_point_v<T>) {
+            read_bytes(&v, sizeof(v));
+        } else {
+            static_assert(detail::has_serialize<T>::value,
+                          "type must provide template <typename Archive> void serialize(Archive&)");
+            v.serialize(*this);
+        }
+    }
+
+    template <typename T>
+    void read(shared_ptr<T>& p) {
+        p = read_ref<T>();
+    }
+
+    template <typename T>
+    void read(weak_ptr<T>& w) {
+        w = read_ref<T>();
+    }
+
+    template <typename T, typename D>
+    void read(unique_ptr<T, D>& p) {
+        if (get() == 0) {
+            p.reset();
+            return;
+        }
+        static_assert(std::is_default_constructible_v<T>, "deserialized types must be default constructible");
+        p.reset(new T());
+        pending_.push_back(pending_body{p.get(), &read_body<T>});
+    }
+
+    void read(std::string& s) {
+        std::uint64_t n = read_varint();
+        s.clear();
+        char tmp[4096];
+        while (n > 0) {
+            std::size_t chunk = n < sizeof(tmp) ? static_cast<std::size_t>(n) : sizeof(tmp);
+            read_bytes(tmp, chunk);
+            s.append(tmp, chunk);
+            n -= chunk;
+        }
+    }
+
+    template <typename T, typename A>
+    void read(std::vector<T, A>& v) {
+        std::uint64_t n = read_varint();
+        v.clear();
+        // 长度来自输入，预留量设上限，损坏的档案不会触发巨量分配
+        v.reserve(n < 4096 ? static_cast<std::size_t>(n) : 4096);
+        for (std::uint64_t i = 0; i < n; ++i) {
+            v.emplace_back();
+            read(v.back());
+        }
+    }
+
+public:
+    explicit input_archive(std::istream& is)
+        : is_(is), sb_(is.rdbuf()), roots_read_(0), draining_(false) {
+        if (!sb_) {
+            throw serialization_error("input_archive: stream has no buffer");
+        }
+        char magic[sizeof(detail::archive_magic)];
+        read_bytes(magic, sizeof(magic));
+        if (std::memcmp(magic, detail::archive_magic, sizeof(magic)) != 0) {
+            throw serialization_error("input_archive: bad magic");
+        }
+        if (read_varint() != detail::archive_version) {
+            throw serialization_error("input_archive: unsupported version");
+        }
+    }
+
+    ~input_archive() {
+        for (auto& e : objects_) {
+            e.cb->release_shared();
+        }
+    }
+
+    input_archive(const input_archive&) = delete;
+    input_archive& operator=(const input_archive&) = delete;
+
+    // 依次读入各个值；最外层调用返回前读完所有新对象的对象体
+    template <typename... Args>
+    input_archive& operator()(Args&... args) {
+        (read(args), ...);
+        if (!draining_) {
+            drain();
+        }
+        return *this;
+    }
+
+    std::uint64_t read_varint() {
+        std::uint64_t v = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            unsigned char b = static_cast<unsigned char>(get());
+            v |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80)) {
+                return v;
+            }
+        }
+        throw serialization_error("input_archive: malformed varint");
+    }
+
+    void read_bytes(void *dst, std::size_t n) {
+        if (static_cast<std::size_t>(sb_->sgetn(static_cast<char*>(dst), static_cast<std::streamsize>(n))) != n) {
+            truncated();
+        }
+    }
+
+    // 已加载的共享对象个数（别名视图不计）
+    std::size_t objects_read() const noexcept { return roots_read_; }
+};
+
+} // namespace my_ptr
@@ -0,0 +1,148 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include "shared_ptr.hpp"
+#include "detail/control_block.hpp"
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+#include <span>
+#endif
+
+namespace my_ptr {
+
+namespace detail {
+
+// 字节缓冲控制块：头部与字节区一次分配（内联控制块的变长版本），字节区紧跟在头部之后
+class buffer_control_block : public control_block_base {
+private:
+    std::size_t size_;
+
+    explicit buffer_control_block(std::size_t size) noexcept : control_block_base(), size_(size) {}
+
+public:
+    static buffer_control_block *create(std::size_t size) {
+        void *mem = ::operator new(sizeof(buffer_control_block) + size);
+        return new (mem) buffer_control_block(size);
+    }
+
+    void dispose() noexcept override {} // 字节无需析构
+
+    void destroy() noexcept override {
+        this->~buffer_control_block();
+        ::operator delete(this);
+    }
+
+    char *data() noexcept {
+        return reinterpret_cast<char*>(this + 1);
+    }
+
+    std::size_t size() const noexcept { return size_; }
+};
+
+} // namespace detail
+
+// 只读字节区间视图，与底层缓冲共享所有权（别名 shared_ptr，不拷贝字节）
+class buffer_slice {
+private:
+    shared_ptr<const char> data_;
+    std::size_t size_;
+
+    static std::size_t clamp(std::size_t size, std::size_t offset, std::size_t count) {
+        if (offset > size) {
+            throw std::out_of_range("buffer_slice::slice");
+        }
+        return count < size - offset ? count : size - offset;
+    }
+
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    buffer_slice() noexcept : data_(), size_(0) {}
+    buffer_slice(shared_ptr<const char> data, std::size_t size) noexcept
+        : data_(std::move(data)), size_(size) {}
+
+    const char *data() const noexcept { return data_.get(); }
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    const char *begin() const noexcept { return data_.get(); }
+    const char *end() const noexcept { return data_.get() + size_; }
+    char operator[](std::size_t i) const noexcept { return data_.get()[i]; }
+
+    // 子区间：offset 越界抛 std::out_of_range，count 超出部分被截断（同 string_view::substr）
+    buffer_slice slice(std::size_t offset, std::size_t count = npos) const& {
+        std::size_t n = clamp(size_, offset, count);
+        return buffer_slice(shared_ptr<const char>(data_, data_.get() + offset), n);
+    }
+
+    // 右值版本直接转移所有权，省去一次引用计数操作
+    buffer_slice slice(std::size_t offset, std::size_t count = npos) && {
+        std::size_t n = clamp(size_, offset, count);
+        const char *p = data_.get() + offset;
+        return buffer_slice(shared_ptr<const char>(std::move(data_), p), n);
+    }
+
+    std::string_view view() const noexcept { return std::string_view(data_.get(), size_); }
+    operator std::string_view() const noexcept { return view(); }
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+    std::span<const char> span() const noexcept { return std::span<const char>(data_.get(), size_); }
+#endif
+
+    // 共享同一底层缓冲的引用数
+    long use_count() const noexcept { return data_.use_count(); }
+
+    const shared_ptr<const char>& owner() const noexcept { return data_; }
+};
+
+// 引用计数的可写字节缓冲。默认构造方式是头部 + 字节一次分配；
+// 也可以接管任意 shared_ptr<char>（例如映射文件），切片始终保持底层存储存活
+class shared_buffer {
+private:
+    shared_ptr<char> data_;
+    std::size_t size_;
+
+public:
+    shared_buffer() noexcept : data_(), size_(0) {}
+
+    // 分配 size 字节（内容未初始化）
+    explicit shared_buffer(std::size_t size) : data_(), size_(size) {
+        auto *cb = detail::buffer_control_block::create(size);
+        data_ = detail::shared_ptr_access::adopt<shared_ptr<char>>(cb, cb->data());
+    }
+
+    shared_buffer(const void *src, std::size_t size) : shared_buffer(size) {
+        if (size) {
+            std::memcpy(data_.get(), src, size);
+        }
+    }
+
+    explicit shared_buffer(std::string_view bytes) : shared_buffer(bytes.data(), bytes.size()) {}
+
+    // 接管已有存储
+    shared_buffer(shared_ptr<char> data, std::size_t size) noexcept
+        : data_(std::move(data)), size_(size) {}
+
+    char *data() const noexcept { return data_.get(); }
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    char *begin() const noexcept { return data_.get(); }
+    char *end() const noexcept { return data_.get() + size_; }
+
+    buffer_slice slice(std::size_t offset = 0, std::size_t count = buffer_slice::npos) const {
+        return buffer_slice(shared_ptr<const char>(data_, data_.get()), size_).slice(offset, count);
+    }
+
+    operator buffer_slice() const { return slice(); }
+
+    std::string_view view() const noexcept { return std::string_view(data_.get(), size_); }
+
+    long use_count() const noexcept { return data_.use_count(); }
+};
+
+} // namespace my_ptr
@@ -1,4 +1,5 @@
 #pragma once
+#include <chrono>
 #include <type_traits>
 #include <utility>
 #include "detail/control_block.hpp"
@@ -30,6 +31,7 @@ private:
     friend class shared_ptr;
     template <typename U>
     friend class weak_ptr;
+    friend struct detail::shared_ptr_access;
 
 public:
     // 构造/析构
@@ -41,7 +43,7 @@ public:
     : ptr_(ptr), ctrl_block_(detail::make_control_block(ptr, detail::default_delete<U>())) {}
   
     template <typename U, typename Deleter>
-    shared_ptr(U *ptr, Deleter&& deleter) : ptr_(ptr), ctrl_block_(detail::make_control_block(ptr, std::move<Deleter>(deleter))) {}
+    shared_ptr(U *ptr, Deleter&& deleter) : ptr_(ptr), ctrl_block_(detail::make_control_block(ptr, std::forward<Deleter>(deleter))) {}
 
     // 拷贝构造
     shared_ptr(const shared_ptr& other) noexcept : ptr_(other.ptr_), ctrl_block_(other.ctrl_block_) { 
@@ -65,12 +67,28 @@ public:
     }
     
     template<typename U>
-    shared_ptr(shared_ptr<U>&& other) noexcept 
+    shared_ptr(shared_ptr<U>&& other) noexcept
         : ptr_(other.ptr_), ctrl_block_(other.ctrl_block_) {
         other.ptr_ = nullptr;
         other.ctrl_block_ = nullptr;
     }
 
+    // 别名构造：与 other 共享所有权，但指向 p（通常是 other 所管对象的成员或子区间）
+    template <typename U>
+    shared_ptr(const shared_ptr<U>& other, element_type *p) noexcept
+        : ptr_(p), ctrl_block_(other.ctrl_block_) {
+        if (ctrl_block_) {
+            ctrl_block_->add_shared_ref();
+        }
+    }
+
+    template <typename U>
+    shared_ptr(shared_ptr<U>&& other, element_type *p) noexcept
+        : ptr_(p), ctrl_block_(other.ctrl_block_) {
+        other.ptr_ = nullptr;
+        other.ctrl_block_ = nullptr;
+    }
+
     // 从weak_ptr构造
     template <typename U>
     explicit shared_ptr(const weak_ptr<U>& other);
@@ -132,6 +150,22 @@ public:
     
     long use_count() const noexcept { return ctrl_block_ ? static_cast<long>(ctrl_block_->use_count()) : 0;}
     bool unique() const noexcept { return use_count() == 1; }
+
+    // 阻塞等待其它所有强引用释放（基于 futex，无人等待时释放路径没有额外开销）
+    void wait_for_unique() const noexcept {
+        if (ctrl_block_) {
+            ctrl_block_->wait_unique();
+        }
+    }
+
+    template <typename Rep, typename Period>
+    bool wait_for_unique_for(const std::chrono::duration<Rep, Period>& timeout) const noexcept {
+        if (!ctrl_block_) {
+            return true;
+        }
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout);
+        return ctrl_block_->wait_unique(&ns);
+    }
 };
 
 // 非成员函数
@@ -175,8 +209,72 @@ bool operator<(const shared_ptr<T>& lhs, const shared_ptr<T>& rhs) noexcept {
     return lhs.get() < rhs.get();
 }
 
+// 指针转换：结果与源共享控制块（别名构造）；右值版本直接接管源的引用，不做计数操作
+template<typename T, typename U>
+shared_ptr<T> static_pointer_cast(const shared_ptr<U>& p) noexcept {
+    return shared_ptr<T>(p, static_cast<T*>(p.get()));
+}
+
+template<typename T, typename U>
+shared_ptr<T> static_pointer_cast(shared_ptr<U>&& p) noexcept {
+    T *q = static_cast<T*>(p.get());
+    return shared_ptr<T>(std::move(p), q);
+}
+
+template<typename T, typename U>
+shared_ptr<T> const_pointer_cast(const shared_ptr<U>& p) noexcept {
+    return shared_ptr<T>(p, const_cast<T*>(p.get()));
+}
+
+template<typename T, typename U>
+shared_ptr<T> const_pointer_cast(shared_ptr<U>&& p) noexcept {
+    T *q = const_cast<T*>(p.get());
+    return shared_ptr<T>(std::move(p), q);
+}
+
+template<typename T, typename U>
+shared_ptr<T> reinterpret_pointer_cast(const shared_ptr<U>& p) noexcept {
+    return shared_ptr<T>(p, reinterpret_cast<T*>(p.get()));
+}
+
+template<typename T, typename U>
+shared_ptr<T> reinterpret_pointer_cast(shared_ptr<U>&& p) noexcept {
+    T *q = reinterpret_cast<T*>(p.get());
+    return shared_ptr<T>(std::move(p), q);
+}
+
+// 转换失败时返回空指针；右值版本失败时源保持不变
+template<typename T, typename U>
+shared_ptr<T> dynamic_pointer_cast(const shared_ptr<U>& p) noexcept {
+    if (T *q = dynamic_cast<T*>(p.get())) {
+        return shared_ptr<T>(p, q);
+    }
+    return shared_ptr<T>();
+}
+
+template<typename T, typename U>
+shared_ptr<T> dynamic_pointer_cast(shared_ptr<U>&& p) noexcept {
+    if (T *q = dynamic_cast<T*>(p.get())) {
+        return shared_ptr<T>(std::move(p), q);
+    }
+    return shared_ptr<T>();
+}
+
 // 工厂函数
 template<typename T, typename... Args>
 shared_ptr<T> make_shared(Args&&... args);
 
+// 永生对象：计数操作退化为一次分支，对象与控制块永不释放
+template<typename T, typename... Args>
+shared_ptr<T> make_immortal_shared(Args&&... args) {
+    auto *cb = new detail::immortal_control_block<T>(std::forward<Args>(args)...);
+    return detail::shared_ptr_access::adopt<shared_ptr<T>>(cb, cb->get());
+}
+
+// 收养静态存储期对象（全局单例、常量等），共用一个哨兵控制块
+template<typename T>
+shared_ptr<T> adopt_static(T& obj) noexcept {
+    return detail::shared_ptr_access::adopt<shared_ptr<T>>(&detail::static_control_block::instance(), &obj);
+}
+
 } // namespace my_ptr
@@ -0,0 +1,364 @@
+/*
+    无锁有序映射（Fraser / Herlihy–Shavit 跳表）：各层的 next 指针最低位作删除标记，
+    删除先逐层打标记再物理摘除；被摘下的节点与被替换的值由纪元回收（detail/epoch.hpp）延迟释放。
+    值以 shared_ptr<V> 保存并按值返回，读者取得的值在键被删除后仍然有效。
+    范围遍历在纪元临界区内沿底层链表前进，跳过已标记删除的节点，可与修改并发进行
+*/
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <utility>
+#include "shared_ptr.hpp"
+#include "detail/epoch.hpp"
+
+namespace my_ptr {
+
+template <typename K, typename V, typename Compare = std::less<K>>
+class skiplist_map {
+public:
+    using key_type = K;
+    using mapped_type = V;
+
+private:
+    static constexpr int max_height = 20; // p = 1/4，足够 4^20 个键
+    static constexpr std::uintptr_t mark_bit = 1;
+
+    // 值不可变；更新整体替换，旧值由纪元回收释放
+    struct value_box {
+        shared_ptr<V> value;
+    };
+
+    // 删除者取走值后换上的墓碑：替换只对非墓碑的值做 CAS，被删除键的值不会丢失
+    static value_box *tombstone() noexcept {
+        static value_box t;
+        return &t;
+    }
+
+    // 节点头部之后紧跟 height 个 next 指针
+    struct node {
+        std::atomic<value_box*> box;
+        // 插入者与删除者各持一票，两者都完成后（节点已从每一层摘除）才交给纪元回收
+        std::atomic<std::uint32_t> retire_votes;
+        int height;
+        alignas(alignof(K)) unsigned char key_storage[sizeof(K)];
+
+        std::atomic<std::uintptr_t> *next() noexcept {
+            return reinterpret_cast<std::atomic<std::uintptr_t>*>(this + 1);
+        }
+
+        const K& key() const noexcept { return *std::launder(reinterpret_cast<const K*>(key_storage)); }
+    };
+
+    static node *ptr_of(std::uintptr_t link) noexcept { return reinterpret_cast<node*>(link & ~mark_bit); }
+    static bool marked(std::uintptr_t link) noexcept { return (link & mark_bit) != 0; }
+    static std::uintptr_t link_of(node *n) noexcept { return reinterpret_cast<std::uintptr_t>(n); }
+
+    static node *allocate_node(int height) {
+        static_assert(alignof(node) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "over-aligned keys are not supported");
+        void *mem = ::operator new(sizeof(node) + sizeof(std::atomic<std::uintptr_t>) * height);
+        node *n = new (mem) node;
+        n->box.store(nullptr, std::memory_order_relaxed);
+        n->retire_votes.store(2, std::memory_order_relaxed);
+        n->height = height;
+        for (int i = 0; i < height; ++i) {
+            new (&n->next()[i]) std::atomic<std::uintptr_t>(0);
+        }
+        return n;
+    }
+
+    // 释放节点及其当前的值（head 没有键）
+    static void free_node(node *n, bool has_key) noexcept {
+        value_box *box = n->box.load(std::memory_order_relaxed);
+        if (box != tombstone()) {
+            delete box;
+        }
+        if (has_key) {
+            n->key().~K();
+        }
+        n->~node();
+        ::operator delete(n);
+    }
+
+    static void reclaim_node(void *p) noexcept { free_node(static_cast<node*>(p), true); }
+    static void reclaim_box(void *p) noexcept { delete static_cast<value_box*>(p); }
+
+    static int random_height() noexcept {
+        thread_local std::uint64_t state = 0x9e3779b97f4a7c15ull ^ reinterpret_cast<std::uintptr_t>(&state);
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        int h = 1;
+        for (std::uint64_t bits = state; h < max_height && (bits & 3) == 0; bits >>= 2) {
+            ++h;
+        }
+        return h;
+    }
+
+    node *head_;
+    std::atomic<std::size_t> size_;
+    Compare less_;
+
+    bool less(const node *n, const K& key) const { return less_(n->key(), key); }
+    bool equal(const node *n, const K& key) const { return !less_(n->key(), key) && !less_(key, n->key()); }
+
+    // 为 key 找到每一层的前驱与后继，顺路摘除已标记的节点。调用者需处于纪元临界区内
+    bool find(const K& key, node **preds, node **succs) {
+    retry:
+        node *pred = head_;
+        for (int level = max_height - 1; level >= 0; --level) {
+            node *curr = ptr_of(pred->next()[level].load(std::memory_order_acquire));
+            while (curr) {
+                std::uintptr_t succ = curr->next()[level].load(std::memory_order_acquire);
+                while (marked(succ)) {
+                    std::uintptr_t expected = link_of(curr);
+                    if (!pred->next()[level].compare_exchange_strong(expected, succ & ~mark_bit,
+                                                                     std::memory_order_acq_rel)) {
+                        goto retry;
+                    }
+                    curr = ptr_of(succ);
+                    if (!curr) {
+                        break;
+                    }
+                    succ = curr->next()[level].load(std::memory_order_acquire);
+                }
+                if (curr && less(curr, key)) {
+                    pred = curr;
+                    curr = ptr_of(succ);
+                } else {
+                    break;
+                }
+            }
+            preds[level] = pred;
+            succs[level] = curr;
+        }
+        return succs[0] && equal(succs[0], key);
+    }
+
+    // 投出一票；节点已从所有层摘除且双方都完成时交给纪元回收
+    void vote_retire(node *n) {
+        if (n->retire_votes.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            detail::epoch_retire_raw(n, &reclaim_node);
+        }
+    }
+
+    // 替换已存在节点的值；节点已被删除者标记或取走值时失败，value 原样留给调用者
+    bool replace_value(node *n, shared_ptr<V>& value) {
+        if (marked(n->next()[0].load(std::memory_order_acquire))) {
+            return false;
+        }
+        value_box *fresh = new value_box{std::move(value)};
+        value_box *old = n->box.load(std::memory_order_acquire);
+        while (old != tombstone()) {
+            if (n->box.compare_exchange_weak(old, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                detail::epoch_retire_raw(old, &reclaim_box);
+                return true;
+            }
+        }
+        value = std::move(fresh->value);
+        delete fresh;
+        return false;
+    }
+
+public:
+    skiplist_map() : head_(allocate_node(max_height)), size_(0), less_() {}
+
+    explicit skiplist_map(const Compare& comp) : head_(allocate_node(max_height)), size_(0), less_(comp) {}
+
+    // 析构时不能有并发访问；已摘下的节点仍由纪元回收释放
+    ~skiplist_map() {
+        node *n = ptr_of(head_->next()[0].load(std::memory_order_relaxed));
+        while (n) {
+            node *next = ptr_of(n->next()[0].load(std::memory_order_relaxed));
+            free_node(n, true);
+            n = next;
+        }
+        free_node(head_, false);
+    }
+
+    skiplist_map(const skiplist_map&) = delete;
+    skiplist_map& operator=(const skiplist_map&) = delete;
+
+    // 插入或替换，返回是否新插入了键
+    bool put(const K& key, shared_ptr<V> value) {
+        detail::epoch_guard guard;
+        node *preds[max_height];
+        node *succs[max_height];
+        node *n = nullptr;
+        int height = 0;
+        for (;;) {
+            if (find(key, preds, succs)) {
+                if (n) {
+                    value = std::move(n->box.load(std::memory_order_relaxed)->value);
+                    free_node(n, true); // 从未发布
+                    n = nullptr;
+                }
+                if (replace_value(succs[0], value)) {
+                    return false;
+                }
+                continue; // 节点正在被删除：重新 find（会摘除它）后插入新节点
+            }
+            if (!n) {
+                height = random_height();
+                n = allocate_node(height);
+                try {
+                    new (n->key_storage) K(key);
+                } catch (...) {
+                    free_node(n, false);
+                    throw;
+                }
+                n->box.store(new value_box{std::move(value)}, std::memory_order_relaxed);
+            }
+            for (int i = 0; i < height; ++i) {
+                n->next()[i].store(link_of(succs[i]), std::memory_order_relaxed);
+            }
+            std::uintptr_t expected = link_of(succs[0]);
+            if (preds[0]->next()[0].compare_exchange_strong(expected, link_of(n), std::memory_order_acq_rel)) {
+                break;
+            }
+        }
+        size_.fetch_add(1, std::memory_order_relaxed);
+
+        // 逐层向上链接；节点在此期间被删除（next 被标记）则停止
+        for (int i = 1; i < height; ++i) {
+            for (;;) {
+                std::uintptr_t expected = link_of(succs[i]);
+                if (preds[i]->next()[i].compare_exchange_strong(expected, link_of(n), std::memory_order_acq_rel)) {
+                    break;
+                }
+                find(key, preds, succs);
+                std::uintptr_t own = n->next()[i].load(std::memory_order_acquire);
+                if (marked(own)) {
+                    goto linked;
+                }
+                if (succs[i] == n) {
+                    break; // find 已经看到本层的链接
+                }
+                if (own != link_of(succs[i]) &&
+                    !n->next()[i].compare_exchange_strong(own, link_of(succs[i]), std::memory_order_acq_rel)) {
+                    goto linked; // 只会因为被标记而失败
+                }
+            }
+        }
+    linked:
+        if (marked(n->next()[0].load(std::memory_order_acquire))) {
+            find(key, preds, succs); // 删除者可能先于最后几层的链接完成摘除，这里再摘一次
+        }
+        vote_retire(n);
+        return true;
+    }
+
+    template <typename... Args>
+    bool emplace(const K& key, Args&&... args) {
+        return put(key, make_shared<V>(std::forward<Args>(args)...));
+    }
+
+    // 返回键对应的值，不存在时返回空指针
+    shared_ptr<V> get(const K& key) const {
+        detail::epoch_guard guard;
+        node *pred = head_;
+        node *curr = nullptr;
+        for (int level = max_height - 1; level >= 0; --level) {
+            curr = ptr_of(pred->next()[level].load(std::memory_order_acquire));
+            while (curr && less(curr, key)) {
+                pred = curr;
+                curr = ptr_of(curr->next()[level].load(std::memory_order_acquire));
+            }
+        }
+        if (!curr || !equal(curr, key) || marked(curr->next()[0].load(std::memory_order_acquire))) {
+            return shared_ptr<V>();
+        }
+        return curr->box.load(std::memory_order_acquire)->value;
+    }
+
+    bool contains(const K& key) const { return static_cast<bool>(get(key)); }
+
+    // 删除键并返回它的值；键不存在时返回空指针
+    shared_ptr<V> remove(const K& key) {
+        detail::epoch_guard guard;
+        node *preds[max_height];
+        node *succs[max_height];
+        if (!find(key, preds, succs)) {
+            return shared_ptr<V>();
+        }
+        node *n = succs[0];
+        for (int i = n->height - 1; i >= 1; --i) {
+            n->next()[i].fetch_or(mark_bit, std::memory_order_acq_rel);
+        }
+        std::uintptr_t succ = n->next()[0].load(std::memory_order_acquire);
+        for (;;) {
+            if (marked(succ)) {
+                return shared_ptr<V>(); // 另一个删除者抢先
+            }
+            if (n->next()[0].compare_exchange_weak(succ, succ | mark_bit, std::memory_order_acq_rel)) {
+                break;
+            }
+        }
+        // 标记之后取走值：此后的替换都会看到墓碑而改为重新插入
+        value_box *box = n->box.exchange(tombstone(), std::memory_order_acq_rel);
+        shared_ptr<V> value = box->value; // 并发读者可能仍在复制它，不能移走
+        detail::epoch_retire_raw(box, &reclaim_box);
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        find(key, preds, succs); // 物理摘除
+        vote_retire(n);
+        return value;
+    }
+
+    // 按键序访问 [lo, hi) 中的元素：f(const K&, const shared_ptr<V>&)，返回访问的个数。
+    // 遍历期间的并发插入与删除可能被看到也可能不被看到；回调在纪元临界区内执行，
+    // 长时间阻塞会推迟所有线程的内存回收
+    template <typename F>
+    std::size_t scan(const K& lo, const K& hi, F&& f) const {
+        detail::epoch_guard guard;
+        node *pred = head_;
+        node *curr = nullptr;
+        for (int level = max_height - 1; level >= 0; --level) {
+            curr = ptr_of(pred->next()[level].load(std::memory_order_acquire));
+            while (curr && less(curr, lo)) {
+                pred = curr;
+                curr = ptr_of(curr->next()[level].load(std::memory_order_acquire));
+            }
+        }
+        std::size_t visited = 0;
+        for (; curr && less(curr, hi); curr = ptr_of(curr->next()[0].load(std::memory_order_acquire))) {
+            if (marked(curr->next()[0].load(std::memory_order_acquire))) {
+                continue;
+            }
+            value_box *box = curr->box.load(std::memory_order_acquire);
+            if (box == tombstone()) {
+                continue;
+            }
+            f(curr->key(), box->value);
+            ++visited;
+        }
+        return visited;
+    }
+
+    // 按键序访问全部元素
+    template <typename F>
+    std::size_t for_each(F&& f) const {
+        detail::epoch_guard guard;
+        std::size_t visited = 0;
+        for (node *curr = ptr_of(head_->next()[0].load(std::memory_order_acquire)); curr;
+             curr = ptr_of(curr->next()[0].load(std::memory_order_acquire))) {
+            if (marked(curr->next()[0].load(std::memory_order_acquire))) {
+                continue;
+            }
+            value_box *box = curr->box.load(std::memory_order_acquire);
+            if (box != tombstone()) {
+                f(curr->key(), box->value);
+                ++visited;
+            }
+        }
+        return visited;
+    }
+
+    // 并发修改时为近似值
+    std::size_t size() const noexcept { return size_.load(std::memory_order_relaxed); }
+    bool empty() const noexcept { return size() == 0; }
+
+};
+
+} // namespace my_ptr
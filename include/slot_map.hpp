@@ -0,0 +1,319 @@
+/*
+    代际句柄槽表：用 32/64 位句柄（槽下标 + 代数）代替 weak_ptr 引用大量对象。
+    get(handle) 只做一次 acquire 读取与比较，没有原子读改写；槽分块存放，元素地址在其生命期内不变；
+    另有一个紧凑的存活下标数组供顺序遍历。
+    写操作（emplace/insert/erase/clear/share_slot）之间需外部同步；get/contains 可与写操作并发，
+    但并发 erase 时 get 返回的指针随时可能失效，需要在写者之外使用对象时应通过 share_slot 持有
+*/
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "shared_ptr.hpp"
+#include "detail/traits.hpp"
+
+namespace my_ptr {
+
+// 代际句柄：低位是槽下标，高位是代数。值为 0 的句柄为空（代数从 1 起，且总为奇数）
+template <typename Word>
+struct slot_handle {
+    static_assert(std::is_same_v<Word, std::uint32_t> || std::is_same_v<Word, std::uint64_t>,
+                  "slot handles are 32 or 64 bits");
+
+    static constexpr unsigned index_bits = sizeof(Word) == 4 ? 20 : 32;
+    static constexpr unsigned generation_bits = sizeof(Word) * 8 - index_bits;
+    static constexpr Word index_mask = (Word(1) << index_bits) - 1;
+    static constexpr Word max_generation = (Word(1) << generation_bits) - 1;
+
+    Word value = 0;
+
+    static slot_handle make(Word index, Word generation) noexcept {
+        return slot_handle{static_cast<Word>(index | (generation << index_bits))};
+    }
+
+    Word index() const noexcept { return value & index_mask; }
+    Word generation() const noexcept { return value >> index_bits; }
+
+    explicit operator bool() const noexcept { return value != 0; }
+    bool operator==(const slot_handle& other) const noexcept { return value == other.value; }
+    bool operator!=(const slot_handle& other) const noexcept { return value != other.value; }
+};
+
+using slot_handle32 = slot_handle<std::uint32_t>;
+using slot_handle64 = slot_handle<std::uint64_t>;
+
+template <typename T, typename Word>
+class slot_map;
+
+template <typename T, typename Word>
+shared_ptr<T> share_slot(const shared_ptr<slot_map<T, Word>>& map, slot_handle<Word> h);
+
+template <typename T, typename Word = std::uint64_t>
+class slot_map {
+public:
+    using value_type = T;
+    using handle_type = slot_handle<Word>;
+
+private:
+    static constexpr std::size_t chunk_shift = 12;
+    static constexpr std::size_t chunk_slots = std::size_t(1) << chunk_shift;
+    static constexpr std::size_t max_slots = std::size_t(handle_type::index_mask) + 1;
+    static constexpr std::uint32_t no_slot = ~std::uint32_t(0);
+
+    // shares 的高位标记：对象已被 erase 但仍有 share_slot 持有者 / 最后的持有者已析构对象
+    static constexpr std::uint32_t erased_bit = std::uint32_t(1) << 31;
+    static constexpr std::uint32_t dead_bit = std::uint32_t(1) << 30;
+
+    // 代数为奇数表示槽中有对象；空槽的 link 串成空闲链表（待回收的槽串成另一条），
+    // 占用槽的 link 是它在 dense_ 中的位置
+    struct slot {
+        std::atomic<Word> generation;
+        std::uint32_t link;
+        std::atomic<std::uint32_t> shares; // share_slot 发出的、尚未释放的 shared_ptr 个数
+        alignas(alignof(T)) unsigned char storage[sizeof(T)];
+
+        T *value() noexcept { return std::launder(reinterpret_cast<T*>(storage)); }
+        const T *value() const noexcept { return std::launder(reinterpret_cast<const T*>(storage)); }
+    };
+
+    // share_slot 的删除器：归还份额；对象已被 erase 时由最后一个持有者析构它
+    struct share_release {
+        shared_ptr<slot_map> map;
+        std::uint32_t index;
+
+        void operator()(T *) const noexcept {
+            map->release_share(index);
+        }
+    };
+
+    friend shared_ptr<T> share_slot<T, Word>(const shared_ptr<slot_map>& map, handle_type h);
+
+    // 块目录只增长：扩容时发布新目录，旧目录保留到析构，并发的 get 读到哪一份都有效
+    std::vector<std::unique_ptr<slot[]>> chunks_;
+    std::vector<std::unique_ptr<slot*[]>> dirs_;
+    std::atomic<slot**> dir_;
+    std::size_t dir_capacity_;
+    std::atomic<std::size_t> slot_count_;
+    std::vector<std::uint32_t> dense_; // 存活对象的槽下标
+    std::uint32_t free_head_;
+    std::uint32_t zombie_head_; // 已 erase、等待 share_slot 持有者释放的槽
+
+    slot& at(std::size_t index) noexcept {
+        return dir_.load(std::memory_order_acquire)[index >> chunk_shift][index & (chunk_slots - 1)];
+    }
+
+    const slot& at(std::size_t index) const noexcept {
+        return dir_.load(std::memory_order_acquire)[index >> chunk_shift][index & (chunk_slots - 1)];
+    }
+
+    void push_free(std::uint32_t index, slot& s) noexcept {
+        if (s.generation.load(std::memory_order_relaxed) < handle_type::max_generation) {
+            s.link = free_head_;
+            free_head_ = index;
+        }
+    }
+
+    // 把最后的持有者已析构对象的待回收槽放回空闲链表
+    void reclaim_zombies() noexcept {
+        std::uint32_t *link = &zombie_head_;
+        while (*link != no_slot) {
+            std::uint32_t index = *link;
+            slot& s = at(index);
+            if (s.shares.load(std::memory_order_acquire) == dead_bit) {
+                *link = s.link;
+                s.shares.store(0, std::memory_order_relaxed);
+                push_free(index, s);
+            } else {
+                link = &s.link;
+            }
+        }
+    }
+
+    void add_chunk() {
+        std::unique_ptr<slot[]> chunk(new slot[chunk_slots]);
+        for (std::size_t i = 0; i < chunk_slots; ++i) {
+            chunk[i].generation.store(0, std::memory_order_relaxed);
+            chunk[i].link = no_slot;
+            chunk[i].shares.store(0, std::memory_order_relaxed);
+        }
+        if (chunks_.size() == dir_capacity_) {
+            std::size_t capacity = dir_capacity_ ? dir_capacity_ * 2 : 16;
+            std::unique_ptr<slot*[]> dir(new slot*[capacity]);
+            for (std::size_t i = 0; i < chunks_.size(); ++i) {
+                dir[i] = chunks_[i].get();
+            }
+            dirs_.reserve(dirs_.size() + 1);
+            chunks_.reserve(chunks_.size() + 1);
+            dir_.store(dir.get(), std::memory_order_release);
+            dirs_.push_back(std::move(dir));
+            dir_capacity_ = capacity;
+        } else {
+            chunks_.reserve(chunks_.size() + 1);
+        }
+        // 新块在 slot_count_ 增长（release）之前写入目录，get 不会读到未初始化的项
+        dir_.load(std::memory_order_relaxed)[chunks_.size()] = chunk.get();
+        chunks_.push_back(std::move(chunk));
+    }
+
+    // 取一个空槽（不改变代数）
+    std::uint32_t acquire_slot() {
+        if (free_head_ == no_slot && zombie_head_ != no_slot) {
+            reclaim_zombies();
+        }
+        if (free_head_ != no_slot) {
+            return free_head_;
+        }
+        std::size_t count = slot_count_.load(std::memory_order_relaxed);
+        if (count == max_slots) {
+            throw std::length_error("slot_map: handle index space exhausted");
+        }
+        if ((count & (chunk_slots - 1)) == 0) {
+            add_chunk();
+        }
+        std::uint32_t index = static_cast<std::uint32_t>(count);
+        at(index).link = no_slot;
+        slot_count_.store(count + 1, std::memory_order_release);
+        free_head_ = index;
+        return index;
+    }
+
+    void release_share(std::uint32_t index) noexcept {
+        slot& s = at(index);
+        if (s.shares.fetch_sub(1, std::memory_order_acq_rel) == (erased_bit | 1)) {
+            s.value()->~T();
+            s.shares.store(dead_bit, std::memory_order_release);
+        }
+    }
+
+public:
+    slot_map() noexcept
+        : dir_(nullptr), dir_capacity_(0), slot_count_(0), free_head_(no_slot), zombie_head_(no_slot) {}
+
+    // share_slot 持有者保活 map，析构时不会有未释放的份额
+    ~slot_map() {
+        clear();
+    }
+
+    slot_map(const slot_map&) = delete;
+    slot_map& operator=(const slot_map&) = delete;
+
+    template <typename... Args>
+    handle_type emplace(Args&&... args) {
+        std::uint32_t index = acquire_slot();
+        if (dense_.size() == dense_.capacity()) {
+            dense_.reserve(dense_.size() * 2 + 16); // 先扩容，构造对象之后的 push_back 不会抛出
+        }
+        slot& s = at(index);
+        new (s.storage) T(std::forward<Args>(args)...);
+        free_head_ = s.link;
+        s.link = static_cast<std::uint32_t>(dense_.size());
+        dense_.push_back(index);
+        Word generation = s.generation.load(std::memory_order_relaxed) + 1; // 偶数 → 奇数
+        s.generation.store(generation, std::memory_order_release); // 发布构造好的对象
+        return handle_type::make(index, generation);
+    }
+
+    handle_type insert(const T& value) { return emplace(value); }
+    handle_type insert(T&& value) { return emplace(std::move(value)); }
+
+    // 句柄仍指向存活对象时返回其地址，否则返回 nullptr
+    T *get(handle_type h) noexcept {
+        std::size_t index = h.index();
+        if (index >= slot_count_.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        slot& s = at(index);
+        Word generation = s.generation.load(std::memory_order_acquire);
+        return generation == h.generation() && (generation & 1) ? s.value() : nullptr;
+    }
+
+    const T *get(handle_type h) const noexcept {
+        return const_cast<slot_map*>(this)->get(h);
+    }
+
+    bool contains(handle_type h) const noexcept { return get(h) != nullptr; }
+
+    // 使所有指向该对象的句柄失效并销毁对象；仍有 share_slot 持有者时，对象由最后一个持有者销毁，
+    // 槽在那之后才复用。代数用尽的槽不再复用
+    bool erase(handle_type h) noexcept {
+        T *p = get(h);
+        if (!p) {
+            return false;
+        }
+        std::uint32_t index = static_cast<std::uint32_t>(h.index());
+        slot& s = at(index);
+        s.generation.store(s.generation.load(std::memory_order_relaxed) + 1, std::memory_order_release); // 奇数 → 偶数
+        std::uint32_t pos = s.link;
+        std::uint32_t moved = dense_.back();
+        dense_[pos] = moved;
+        at(moved).link = pos;
+        dense_.pop_back();
+        if (s.shares.fetch_or(erased_bit, std::memory_order_acq_rel) == 0) {
+            p->~T();
+            s.shares.store(0, std::memory_order_relaxed);
+            push_free(index, s);
+        } else {
+            s.link = zombie_head_;
+            zombie_head_ = index;
+        }
+        return true;
+    }
+
+    void clear() noexcept {
+        while (!dense_.empty()) {
+            std::uint32_t index = dense_.back();
+            erase(handle_type::make(index, at(index).generation.load(std::memory_order_relaxed)));
+        }
+    }
+
+    std::size_t size() const noexcept { return dense_.size(); }
+    bool empty() const noexcept { return dense_.empty(); }
+
+    // 按存活下标数组遍历所有对象：f(handle, T&)
+    template <typename F>
+    void for_each(F&& f) {
+        constexpr std::size_t lookahead = 8;
+        const std::size_t n = dense_.size();
+        for (std::size_t i = 0; i < n; ++i) {
+            if (i + lookahead < n) {
+                detail::prefetch(&at(dense_[i + lookahead]));
+            }
+            std::uint32_t index = dense_[i];
+            slot& s = at(index);
+            f(handle_type::make(index, s.generation.load(std::memory_order_relaxed)), *s.value());
+        }
+    }
+
+    template <typename F>
+    void for_each(F&& f) const {
+        const_cast<slot_map*>(this)->for_each([&f](handle_type h, T& v) { f(h, static_cast<const T&>(v)); });
+    }
+};
+
+// 把槽中的对象包装成拥有它的 shared_ptr：持有者保活 map 的存储，并推迟对象的销毁——
+// 期间 erase 仍立即使句柄失效，对象由最后一个持有者销毁。与写操作一样需要外部同步；
+// 句柄已失效时返回空指针
+template <typename T, typename Word>
+shared_ptr<T> share_slot(const shared_ptr<slot_map<T, Word>>& map, slot_handle<Word> h) {
+    T *p = map ? map->get(h) : nullptr;
+    if (!p) {
+        return shared_ptr<T>();
+    }
+    std::uint32_t index = static_cast<std::uint32_t>(h.index());
+    auto& s = map->at(index);
+    s.shares.fetch_add(1, std::memory_order_relaxed);
+    try {
+        return shared_ptr<T>(p, typename slot_map<T, Word>::share_release{map, index});
+    } catch (...) {
+        s.shares.fetch_sub(1, std::memory_order_relaxed);
+        throw;
+    }
+}
+
+} // namespace my_ptr
@@ -0,0 +1,250 @@
+/*
+    可重定位快照：对象以自相对偏移指针相互引用，文件映射后无需反序列化即可直接使用。
+    快照中的对象由映射区域统一拥有：取出的 shared_ptr 是映射控制块上的别名指针，
+    页面按访问缺页载入。快照格式与写出它的平台（字节序、对齐、类型布局）绑定
+*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "shared_ptr.hpp"
+#include "shared_buffer.hpp"
+#include "mapped_file.hpp"
+
+namespace my_ptr {
+
+// 自相对偏移指针：保存目标地址与自身地址之差，整块内存搬移后依然有效。
+// 偏移 1 表示空（对象不可能位于自身地址 +1 处）
+template <typename T>
+class offset_ptr {
+private:
+    std::int64_t offset_;
+
+    static constexpr std::int64_t null_offset = 1;
+
+    std::int64_t offset_to(const void *p) const noexcept {
+        if (!p) {
+            return null_offset;
+        }
+        return reinterpret_cast<std::intptr_t>(p) - reinterpret_cast<std::intptr_t>(this);
+    }
+
+public:
+    using element_type = T;
+
+    offset_ptr() noexcept : offset_(null_offset) {}
+    offset_ptr(std::nullptr_t) noexcept : offset_(null_offset) {}
+    offset_ptr(T *p) noexcept : offset_(offset_to(p)) {}
+
+    // 拷贝时按目标地址重新计算偏移
+    offset_ptr(const offset_ptr& other) noexcept : offset_(offset_to(other.get())) {}
+
+    offset_ptr& operator=(const offset_ptr& other) noexcept {
+        offset_ = offset_to(other.get());
+        return *this;
+    }
+
+    offset_ptr& operator=(T *p) noexcept {
+        offset_ = offset_to(p);
+        return *this;
+    }
+
+    T *get() const noexcept {
+        if (offset_ == null_offset) {
+            return nullptr;
+        }
+        return reinterpret_cast<T*>(reinterpret_cast<std::intptr_t>(this) + offset_);
+    }
+
+    T& operator*() const noexcept { return *get(); }
+    T *operator->() const noexcept { return get(); }
+    T& operator[](std::size_t i) const noexcept { return get()[i]; }
+    explicit operator bool() const noexcept { return offset_ != null_offset; }
+};
+
+namespace detail {
+
+struct snapshot_header {
+    char magic[8];
+    std::uint64_t version;
+    std::uint64_t size;       // 整个快照的字节数
+    std::uint64_t root_table; // 根偏移表的位置
+    std::uint64_t root_count;
+};
+
+constexpr char snapshot_magic[8] = {'M', 'P', 'S', 'N', 'A', 'P', '\0', '\0'};
+constexpr std::uint64_t snapshot_version = 1;
+
+template <typename T>
+constexpr void check_snapshot_type() {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "snapshot objects must be trivially destructible (plain data and offset_ptr only)");
+    static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types are not supported in snapshots");
+}
+
+} // namespace detail
+
+// 快照内对象的句柄（相对快照起点的偏移），构建期间缓冲扩容后依然有效
+template <typename T>
+struct snapshot_ref {
+    std::uint64_t offset = 0;
+
+    explicit operator bool() const noexcept { return offset != 0; }
+
+    // create_array 返回的数组中第 i 个元素
+    snapshot_ref at(std::size_t i) const noexcept { return snapshot_ref{offset + i * sizeof(T)}; }
+};
+
+// 快照构建器：在一块连续缓冲中放置对象。
+// operator[] 返回的裸指针在下一次 create 之前有效；offset_ptr 字段在两次 create 之间赋值
+class snapshot_builder {
+private:
+    std::vector<char> buffer_;
+    std::vector<std::uint64_t> roots_;
+
+    std::uint64_t allocate(std::size_t size, std::size_t align) {
+        std::size_t offset = (buffer_.size() + align - 1) & ~(align - 1);
+        buffer_.resize(offset + size);
+        return offset;
+    }
+
+public:
+    snapshot_builder() : buffer_(sizeof(detail::snapshot_header)) {}
+
+    template <typename T, typename... Args>
+    snapshot_ref<T> create(Args&&... args) {
+        detail::check_snapshot_type<T>();
+        std::uint64_t offset = allocate(sizeof(T), alignof(T));
+        new (buffer_.data() + offset) T(std::forward<Args>(args)...);
+        return snapshot_ref<T>{offset};
+    }
+
+    // 连续 n 个值初始化的 T
+    template <typename T>
+    snapshot_ref<T> create_array(std::size_t n) {
+        detail::check_snapshot_type<T>();
+        std::uint64_t offset = allocate(sizeof(T) * n, alignof(T));
+        for (std::size_t i = 0; i < n; ++i) {
+            new (buffer_.data() + offset + i * sizeof(T)) T();
+        }
+        return snapshot_ref<T>{offset};
+    }
+
+    template <typename T>
+    T *operator[](snapshot_ref<T> ref) noexcept {
+        return ref ? reinterpret_cast<T*>(buffer_.data() + ref.offset) : nullptr;
+    }
+
+    // 登记根对象，返回其下标
+    template <typename T>
+    std::size_t add_root(snapshot_ref<T> ref) {
+        roots_.push_back(ref.offset);
+        return roots_.size() - 1;
+    }
+
+    std::size_t size() const noexcept { return buffer_.size(); }
+
+    // 写出快照文件；出错抛出 std::runtime_error
+    void write(const std::string& path) {
+        std::uint64_t table = allocate(roots_.size() * sizeof(std::uint64_t), alignof(std::uint64_t));
+        if (!roots_.empty()) {
+            std::memcpy(buffer_.data() + table, roots_.data(), roots_.size() * sizeof(std::uint64_t));
+        }
+        detail::snapshot_header header;
+        std::memcpy(header.magic, detail::snapshot_magic, sizeof(header.magic));
+        header.version = detail::snapshot_version;
+        header.size = buffer_.size();
+        header.root_table = table;
+        header.root_count = roots_.size();
+        std::memcpy(buffer_.data(), &header, sizeof(header));
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        buffer_.resize(table); // 撤销根表，构建器可以继续使用
+        if (!out) {
+            throw std::runtime_error("snapshot_builder: cannot write " + path);
+        }
+    }
+};
+
+// 已加载的快照。映射区域拥有其中所有对象：取出的 shared_ptr 与映射共享控制块，
+// 只要还有一个这样的指针存活，映射就不会被解除
+class snapshot {
+private:
+    buffer_slice region_;
+    detail::snapshot_header header_;
+
+    const char *base() const noexcept { return region_.data(); }
+
+    void validate() {
+        if (region_.size() < sizeof(detail::snapshot_header)) {
+            throw std::runtime_error("snapshot: file too small");
+        }
+        std::memcpy(&header_, base(), sizeof(header_));
+        if (std::memcmp(header_.magic, detail::snapshot_magic, sizeof(header_.magic)) != 0 ||
+            header_.version != detail::snapshot_version) {
+            throw std::runtime_error("snapshot: bad header");
+        }
+        if (header_.size != region_.size() || header_.root_table > header_.size ||
+            header_.root_count > (header_.size - header_.root_table) / sizeof(std::uint64_t)) {
+            throw std::runtime_error("snapshot: corrupt header");
+        }
+    }
+
+public:
+    snapshot() noexcept : region_(), header_() {}
+
+    // 映射快照文件；页面在首次访问时才载入
+    static snapshot open(const std::string& path, unsigned flags = map_random) {
+        snapshot s;
+        s.region_ = map_file(path, flags);
+        s.validate();
+        return s;
+    }
+
+    std::size_t root_count() const noexcept { return static_cast<std::size_t>(header_.root_count); }
+
+    // 取第 index 个根，类型由调用者保证与写入时一致
+    template <typename T>
+    shared_ptr<const T> root(std::size_t index) const {
+        if (index >= root_count()) {
+            throw std::out_of_range("snapshot::root");
+        }
+        std::uint64_t offset;
+        std::memcpy(&offset, base() + header_.root_table + index * sizeof(std::uint64_t), sizeof(offset));
+        // 先确认快照放得下一个 T，否则 header_.size - sizeof(T) 会下溢
+        if (header_.size < sizeof(T) || offset < sizeof(detail::snapshot_header) ||
+            offset > header_.size - sizeof(T) || offset % alignof(T) != 0) {
+            throw std::runtime_error("snapshot: corrupt root offset");
+        }
+        return share(reinterpret_cast<const T*>(base() + offset));
+    }
+
+    // 把快照内任意对象（例如沿 offset_ptr 到达的节点）包装成共享映射所有权的 shared_ptr
+    template <typename T>
+    shared_ptr<const T> share(const T *p) const {
+        if (!contains(p)) {
+            throw std::out_of_range("snapshot::share");
+        }
+        return shared_ptr<const T>(region_.owner(), p);
+    }
+
+    bool contains(const void *p) const noexcept {
+        const char *c = static_cast<const char*>(p);
+        return c >= base() && c < base() + region_.size();
+    }
+
+    std::size_t size() const noexcept { return region_.size(); }
+
+    // 底层映射，可继续切片
+    const buffer_slice& region() const noexcept { return region_; }
+};
+
+} // namespace my_ptr
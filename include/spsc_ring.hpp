@@ -0,0 +1,246 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include "unique_ptr.hpp"
+#include "detail/futex.hpp"
+#include "detail/traits.hpp"
+
+namespace my_ptr {
+
+// 等待策略共用的等待字：epoch 用于 futex，waiters 记录是否有人在睡眠
+struct ring_wait_word {
+    std::atomic<std::uint32_t> epoch{0};
+    std::atomic<std::uint32_t> waiters{0};
+};
+
+// 忙轮询：低延迟，空等时占满 CPU（自旋一段时间后让出时间片）
+struct busy_poll_wait {
+    template <typename Ready>
+    static void wait(ring_wait_word&, Ready ready) noexcept {
+        for (unsigned spin = 0; !ready(); ++spin) {
+            if (spin >= 64) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    static void notify(ring_wait_word&) noexcept {}
+};
+
+// futex 等待：空等时睡眠；只有在对方确实睡眠时才发起唤醒系统调用
+struct futex_wait_strategy {
+    template <typename Ready>
+    static void wait(ring_wait_word& w, Ready ready) noexcept {
+        for (unsigned spin = 0; spin < 64; ++spin) {
+            if (ready()) {
+                return;
+            }
+        }
+        w.waiters.fetch_add(1, std::memory_order_seq_cst);
+        for (;;) {
+            std::uint32_t epoch = w.epoch.load(std::memory_order_acquire);
+            if (ready()) {
+                break;
+            }
+            detail::futex_wait(w.epoch, epoch);
+        }
+        w.waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    static void notify(ring_wait_word& w) noexcept {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (w.waiters.load(std::memory_order_relaxed) != 0) {
+            w.epoch.fetch_add(1, std::memory_order_release);
+            detail::futex_wake_all(w.epoch);
+        }
+    }
+};
+
+// 单生产者单消费者环形缓冲，专门用于在流水线阶段之间零拷贝传递 unique_ptr。
+// 槽位只存裸指针；生产者/消费者各自缓存对方的索引，只在缓存值不足时才读取共享索引
+template <typename T, typename Deleter = detail::default_delete<T>, typename WaitStrategy = busy_poll_wait>
+class spsc_ring {
+public:
+    using pointer = T*;
+    using unique_type = unique_ptr<T, Deleter>;
+
+private:
+    pointer *slots_;
+    std::size_t mask_;
+    Deleter deleter_;
+
+    // 生产者独占的缓存行
+    alignas(detail::cache_line_size) std::atomic<std::size_t> head_;
+    std::size_t cached_tail_;
+
+    // 消费者独占的缓存行
+    alignas(detail::cache_line_size) std::atomic<std::size_t> tail_;
+    std::size_t cached_head_;
+
+    alignas(detail::cache_line_size) ring_wait_word not_empty_;
+    ring_wait_word not_full_;
+    std::atomic<bool> closed_;
+
+    static std::size_t round_up_pow2(std::size_t n) {
+        std::size_t cap = 2;
+        while (cap < n) {
+            cap <<= 1;
+        }
+        return cap;
+    }
+
+    std::size_t free_slots() noexcept {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        std::size_t free = mask_ + 1 - (head - cached_tail_);
+        if (free == 0) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            free = mask_ + 1 - (head - cached_tail_);
+        }
+        return free;
+    }
+
+    std::size_t ready_slots() noexcept {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        std::size_t ready = cached_head_ - tail;
+        if (ready == 0) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            ready = cached_head_ - tail;
+        }
+        return ready;
+    }
+
+public:
+    explicit spsc_ring(std::size_t capacity, Deleter deleter = Deleter())
+        : slots_(nullptr), mask_(round_up_pow2(capacity) - 1), deleter_(std::move(deleter)),
+          head_(0), cached_tail_(0), tail_(0), cached_head_(0), closed_(false) {
+        slots_ = new pointer[mask_ + 1];
+    }
+
+    // 回收环中尚未被消费的对象
+    ~spsc_ring() {
+        clear();
+        delete[] slots_;
+    }
+
+    spsc_ring(const spsc_ring&) = delete;
+    spsc_ring& operator=(const spsc_ring&) = delete;
+
+    // ---- 生产者接口 ----
+    bool try_push(unique_type&& item) noexcept {
+        if (free_slots() == 0) {
+            return false;
+        }
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        slots_[head & mask_] = item.release();
+        head_.store(head + 1, std::memory_order_release);
+        WaitStrategy::notify(not_empty_);
+        return true;
+    }
+
+    // 批量入队：返回实际入队的个数，前 k 个元素的所有权被转移
+    std::size_t push_batch(unique_type *items, std::size_t n) noexcept {
+        std::size_t free = free_slots();
+        if (free < n) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            free = mask_ + 1 - (head_.load(std::memory_order_relaxed) - cached_tail_);
+        }
+        std::size_t count = n < free ? n : free;
+        if (count == 0) {
+            return 0;
+        }
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < count; ++i) {
+            slots_[(head + i) & mask_] = items[i].release();
+        }
+        head_.store(head + count, std::memory_order_release);
+        WaitStrategy::notify(not_empty_);
+        return count;
+    }
+
+    // 阻塞入队；环已关闭时返回 false，item 保持原样
+    bool push(unique_type&& item) noexcept {
+        while (!try_push(std::move(item))) {
+            if (closed()) {
+                return false;
+            }
+            WaitStrategy::wait(not_full_, [this]() { return free_slots() != 0 || closed(); });
+        }
+        return true;
+    }
+
+    // ---- 消费者接口 ----
+    bool try_pop(unique_type& out) noexcept {
+        if (ready_slots() == 0) {
+            return false;
+        }
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        out.reset(slots_[tail & mask_]);
+        tail_.store(tail + 1, std::memory_order_release);
+        WaitStrategy::notify(not_full_);
+        return true;
+    }
+
+    // 批量出队：最多取 max 个，返回实际个数
+    std::size_t pop_batch(unique_type *out, std::size_t max) noexcept {
+        std::size_t ready = ready_slots();
+        if (ready < max) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            ready = cached_head_ - tail_.load(std::memory_order_relaxed);
+        }
+        std::size_t count = max < ready ? max : ready;
+        if (count == 0) {
+            return 0;
+        }
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < count; ++i) {
+            out[i].reset(slots_[(tail + i) & mask_]);
+        }
+        tail_.store(tail + count, std::memory_order_release);
+        WaitStrategy::notify(not_full_);
+        return count;
+    }
+
+    // 阻塞出队；环已关闭且为空时返回 false
+    bool pop(unique_type& out) noexcept {
+        while (!try_pop(out)) {
+            if (closed() && ready_slots() == 0) {
+                return false;
+            }
+            WaitStrategy::wait(not_empty_, [this]() { return ready_slots() != 0 || closed(); });
+        }
+        return true;
+    }
+
+    // 关闭后阻塞的 push/pop 会返回；已入队的元素仍可被取出
+    void close() noexcept {
+        closed_.store(true, std::memory_order_release);
+        not_empty_.epoch.fetch_add(1, std::memory_order_release);
+        not_full_.epoch.fetch_add(1, std::memory_order_release);
+        detail::futex_wake_all(not_empty_.epoch);
+        detail::futex_wake_all(not_full_.epoch);
+    }
+
+    bool closed() const noexcept { return closed_.load(std::memory_order_acquire); }
+
+    // 由消费者（或在无并发时）调用，删除所有未消费的对象
+    void clear() noexcept {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        std::size_t head = head_.load(std::memory_order_acquire);
+        for (; tail != head; ++tail) {
+            deleter_(slots_[tail & mask_]);
+        }
+        tail_.store(tail, std::memory_order_release);
+        cached_head_ = head;
+    }
+
+    std::size_t capacity() const noexcept { return mask_ + 1; }
+
+    std::size_t size_approx() const noexcept {
+        return head_.load(std::memory_order_relaxed) - tail_.load(std::memory_order_relaxed);
+    }
+};
+
+} // namespace my_ptr
@@ -0,0 +1,139 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace my_ptr {
+
+// 工作窃取线程池：每个工作线程有自己的任务队列，空闲时从其它队列尾部窃取
+class thread_pool {
+public:
+    using task_type = std::function<void()>;
+
+private:
+    struct worker_queue {
+        std::mutex mutex;
+        std::deque<task_type> tasks;
+    };
+
+    std::vector<std::unique_ptr<worker_queue>> queues_;
+    std::vector<std::thread> threads_;
+    std::atomic<std::size_t> queued_;
+    std::atomic<std::size_t> next_queue_;
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+    bool stop_;
+
+    struct worker_context {
+        thread_pool *pool;
+        std::size_t index;
+    };
+
+    static worker_context& current() noexcept {
+        static thread_local worker_context ctx{nullptr, 0};
+        return ctx;
+    }
+
+    // 自己的队列从头部取（LIFO），其它队列从尾部窃取（FIFO）
+    bool try_pop(std::size_t self, task_type& out) {
+        {
+            worker_queue& q = *queues_[self];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (!q.tasks.empty()) {
+                out = std::move(q.tasks.front());
+                q.tasks.pop_front();
+                return true;
+            }
+        }
+        for (std::size_t i = 1; i < queues_.size(); ++i) {
+            worker_queue& q = *queues_[(self + i) % queues_.size()];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (!q.tasks.empty()) {
+                out = std::move(q.tasks.back());
+                q.tasks.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void worker_loop(std::size_t index) {
+        current() = worker_context{this, index};
+        task_type task;
+        for (;;) {
+            if (try_pop(index, task)) {
+                queued_.fetch_sub(1, std::memory_order_relaxed);
+                task();
+                task = nullptr;
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            sleep_cv_.wait(lock, [this]() {
+                return stop_ || queued_.load(std::memory_order_relaxed) != 0;
+            });
+            if (stop_ && queued_.load(std::memory_order_relaxed) == 0) {
+                return;
+            }
+        }
+    }
+
+public:
+    explicit thread_pool(std::size_t threads = std::thread::hardware_concurrency())
+        : queued_(0), next_queue_(0), stop_(false) {
+        if (threads == 0) {
+            threads = 1;
+        }
+        for (std::size_t i = 0; i < threads; ++i) {
+            queues_.push_back(std::make_unique<worker_queue>());
+        }
+        threads_.reserve(threads);
+        for (std::size_t i = 0; i < threads; ++i) {
+            threads_.emplace_back([this, i]() { worker_loop(i); });
+        }
+    }
+
+    // 析构前执行完所有已提交的任务
+    ~thread_pool() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            stop_ = true;
+        }
+        sleep_cv_.notify_all();
+        for (auto& t : threads_) {
+            t.join();
+        }
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    // 工作线程内提交的任务进入自己的队列，外部线程轮流分配
+    template <typename F>
+    void post(F&& f) {
+        worker_context& ctx = current();
+        std::size_t index = ctx.pool == this
+            ? ctx.index
+            : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+        queued_.fetch_add(1, std::memory_order_relaxed);
+        {
+            worker_queue& q = *queues_[index];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            q.tasks.emplace_front(std::forward<F>(f));
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+        }
+        sleep_cv_.notify_one();
+    }
+
+    std::size_t size() const noexcept { return threads_.size(); }
+};
+
+} // namespace my_ptr
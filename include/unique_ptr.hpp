@@ -2,9 +2,29 @@
 #include <type_traits>
 #include <utility>
 #include "detail/default_delete.hpp"
+#include "detail/teardown.hpp"
 
 namespace my_ptr {
 
+// 迭代删除器：嵌套过深的删除排入线程局部队列，由最外层循环依次执行，避免长链递归析构
+template <typename T>
+struct iterative_delete {
+    constexpr iterative_delete() noexcept = default;
+
+    template <typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    iterative_delete(const iterative_delete<U>&) noexcept {}
+
+    void operator()(T *ptr) const noexcept {
+        static_assert(sizeof(T) > 0, "iterative_delete can not delete incomplete type");
+        detail::teardown_queue::run(ptr, &delete_one);
+    }
+
+private:
+    static void delete_one(void *ptr) noexcept {
+        delete static_cast<T*>(ptr);
+    }
+};
+
 // unique_ptr 基类模板
 template <typename T, typename Deleter = detail::default_delete<T>>
 class unique_ptr {
@@ -16,6 +36,9 @@ public:
 private:
     pointer ptr_;
     deleter_type deleter_;
+
+    template <typename U, typename E>
+    friend class unique_ptr;
     
     // 编译时检查删除器是否可用
     template <typename U>
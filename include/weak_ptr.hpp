@@ -1,5 +1,6 @@
 #pragma once
 #include "shared_ptr.hpp"
+#include <chrono>
 #include <exception>
 
 namespace my_ptr {
@@ -25,6 +26,7 @@ private:
     friend class shared_ptr;
     template <typename U>
     friend class weak_ptr;
+    friend struct detail::shared_ptr_access;
 
 public:
     // 构造/析构
@@ -116,6 +118,22 @@ public:
         return use_count() == 0;
     }
 
+    // 阻塞等待对象被销毁：返回时析构函数已执行完毕
+    void wait_until_expired() const noexcept {
+        if (ctrl_block_) {
+            ctrl_block_->wait_disposed();
+        }
+    }
+
+    template <typename Rep, typename Period>
+    bool wait_until_expired_for(const std::chrono::duration<Rep, Period>& timeout) const noexcept {
+        if (!ctrl_block_) {
+            return true;
+        }
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout);
+        return ctrl_block_->wait_disposed(&ns);
+    }
+
     shared_ptr<T> lock() const noexcept {
         if (ctrl_block_ && ctrl_block_->try_add_shared_ref()) {
             return shared_ptr<T>(ctrl_block_, ptr_);
@@ -0,0 +1,176 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include "shared_ptr.hpp"
+#include "detail/control_block.hpp"
+
+namespace my_ptr {
+
+namespace detail {
+
+// 每个新对象（或间接块）发放的总权重，控制块的强计数记录尚未归还的权重之和
+constexpr std::uint64_t initial_weight = std::uint64_t(1) << 24;
+
+// 强计数只有 47 位：计数超过这个值后，从 shared_ptr 换取的句柄改经间接块持有（只占原计数 1），
+// 剩余的余量足够容纳大量并发的换取操作在检查与加计数之间的竞争
+constexpr std::uint64_t direct_weight_limit = std::uint64_t(1) << 40;
+
+// 间接块：某个句柄的权重耗尽时，以它仅剩的 1 单位权重持有原控制块，
+// 自身再发放一份新的总权重。句柄的对象指针不变，解引用没有额外开销
+class weight_indirection_block final : public control_block_base {
+private:
+    control_block_base *target_;
+
+public:
+    explicit weight_indirection_block(control_block_base *target) noexcept
+        : control_block_base(), target_(target) {}
+
+    control_block_base *target() const noexcept { return target_; }
+
+    void dispose() noexcept override {
+        target_->release_shared(1);
+    }
+
+    void destroy() noexcept override {
+        delete this;
+    }
+};
+
+} // namespace detail
+
+// 加权引用计数指针。每个句柄携带一份权重，split() 在本地把权重一分为二，不写控制块；
+// 只有析构时把权重一次性归还。权重耗尽（为 1）时再分会分配一个间接块。
+// 分权重要修改源句柄，因此没有拷贝构造：只能对自己持有的非 const 句柄调用 split()，
+// 多个线程扇出时各自从自己的句柄分
+template <typename T>
+class weighted_shared_ptr {
+public:
+    using element_type = T;
+
+private:
+    element_type *ptr_;
+    detail::control_block_base *ctrl_block_; // 权重耗尽时换成间接块
+    std::uint64_t weight_;
+
+    weighted_shared_ptr(detail::control_block_base *cb, element_type *p, std::uint64_t weight) noexcept
+        : ptr_(p), ctrl_block_(cb), weight_(weight) {}
+
+    template <typename U, typename... Args>
+    friend weighted_shared_ptr<U> make_weighted_shared(Args&&... args);
+
+    // 从本句柄分出一半权重
+    std::uint64_t take_half() {
+        if (weight_ == 1 && !ctrl_block_->immortal()) {
+            // 权重耗尽：用最后 1 单位权重换一个带新总权重的间接块
+            auto *ind = new detail::weight_indirection_block(ctrl_block_);
+            ind->add_shared_ref(detail::initial_weight - 1);
+            ctrl_block_ = ind;
+            weight_ = detail::initial_weight;
+        }
+        if (weight_ == 1) {
+            return 1; // 永生对象的计数操作都是空操作，权重无需守恒
+        }
+        std::uint64_t half = weight_ / 2;
+        weight_ -= half;
+        return half;
+    }
+
+public:
+    constexpr weighted_shared_ptr() noexcept : ptr_(nullptr), ctrl_block_(nullptr), weight_(0) {}
+    constexpr weighted_shared_ptr(std::nullptr_t) noexcept : ptr_(nullptr), ctrl_block_(nullptr), weight_(0) {}
+
+    // 从 shared_ptr 换取一份权重（对控制块的一次原子加）；
+    // 控制块上已发放的权重过多时改为分配一个间接块，避免计数溢出
+    explicit weighted_shared_ptr(const shared_ptr<T>& sp)
+        : ptr_(sp.get()), ctrl_block_(detail::shared_ptr_access::control_block(sp)), weight_(0) {
+        if (ctrl_block_) {
+            if (!ctrl_block_->immortal() && ctrl_block_->use_count() >= detail::direct_weight_limit) {
+                auto *ind = new detail::weight_indirection_block(ctrl_block_);
+                ctrl_block_->add_shared_ref();
+                ind->add_shared_ref(detail::initial_weight - 1);
+                ctrl_block_ = ind;
+            } else {
+                ctrl_block_->add_shared_ref(detail::initial_weight);
+            }
+            weight_ = detail::initial_weight;
+        }
+    }
+
+    weighted_shared_ptr(const weighted_shared_ptr&) = delete;
+    weighted_shared_ptr& operator=(const weighted_shared_ptr&) = delete;
+
+    weighted_shared_ptr(weighted_shared_ptr&& other) noexcept
+        : ptr_(other.ptr_), ctrl_block_(other.ctrl_block_), weight_(other.weight_) {
+        other.ptr_ = nullptr;
+        other.ctrl_block_ = nullptr;
+        other.weight_ = 0;
+    }
+
+    ~weighted_shared_ptr() {
+        if (ctrl_block_) {
+            ctrl_block_->release_shared(weight_);
+        }
+    }
+
+    weighted_shared_ptr& operator=(weighted_shared_ptr&& other) noexcept {
+        weighted_shared_ptr(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    // 分出一个指向同一对象的新句柄，带走本句柄一半的权重（不写控制块）
+    weighted_shared_ptr split() {
+        if (!ctrl_block_) {
+            return weighted_shared_ptr();
+        }
+        std::uint64_t w = take_half();
+        return weighted_shared_ptr(ctrl_block_, ptr_, w);
+    }
+
+    void reset() noexcept {
+        weighted_shared_ptr().swap(*this);
+    }
+
+    void swap(weighted_shared_ptr& other) noexcept {
+        std::swap(ptr_, other.ptr_);
+        std::swap(ctrl_block_, other.ctrl_block_);
+        std::swap(weight_, other.weight_);
+    }
+
+    // 转换为普通 shared_ptr（对控制块的一次原子加）。经间接块持有时直接引用最底层的原控制块，
+    // 这样从结果得到的 weak_ptr 跟随对象本身，而不是这一条间接路径
+    shared_ptr<T> to_shared() const noexcept {
+        if (!ctrl_block_) {
+            return shared_ptr<T>();
+        }
+        detail::control_block_base *cb = ctrl_block_;
+        while (auto *ind = dynamic_cast<detail::weight_indirection_block*>(cb)) {
+            cb = ind->target();
+        }
+        cb->add_shared_ref();
+        return detail::shared_ptr_access::adopt<shared_ptr<T>>(cb, ptr_);
+    }
+
+    element_type *get() const noexcept { return ptr_; }
+    element_type& operator*() const noexcept { return *ptr_; }
+    element_type *operator->() const noexcept { return ptr_; }
+    explicit operator bool() const noexcept { return ptr_ != nullptr; }
+
+    // 本句柄当前持有的权重
+    std::uint64_t weight() const noexcept { return weight_; }
+};
+
+template <typename T, typename... Args>
+weighted_shared_ptr<T> make_weighted_shared(Args&&... args) {
+    auto *cb = static_cast<detail::inline_control_block<T>*>(
+        detail::make_inline_control_block<T>(std::forward<Args>(args)...));
+    cb->add_shared_ref(detail::initial_weight - 1);
+    return weighted_shared_ptr<T>(cb, cb->get(), detail::initial_weight);
+}
+
+template <typename T>
+void swap(weighted_shared_ptr<T>& lhs, weighted_shared_ptr<T>& rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+} // namespace my_ptr
@@ -1,4 +1,21 @@
 #include "../include/memory.hpp"
+#include <algorithm>
+#include <deque>
+#include <list>
+#include <map>
+#include <shared_mutex>
+#include <unordered_map>
+#include <mutex>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
 
 class TestClass {
 public:
@@ -114,6 +131,1745 @@ void test_thread_safety() {
     std::cout << "  Time: " << duration.count() << " ms\n";
 }
 
+// 计时辅助函数
+template <typename F>
+long long time_us(F&& f) {
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+}
+
+// 测试ptr_vector性能（异构对象，插入顺序打乱以模拟真实的地址分布）
+struct Shape {
+    virtual ~Shape() = default;
+    virtual int area() const = 0;
+};
+
+struct Square : Shape {
+    int side;
+    explicit Square(int s) : side(s) {}
+    int area() const override { return side * side; }
+};
+
+struct Rect : Shape {
+    int w, h;
+    Rect(int w_, int h_) : w(w_), h(h_) {}
+    int area() const override { return w * h; }
+};
+
+void benchmark_ptr_vector() {
+    const int count = 1000000;
+    std::mt19937 rng(42);
+
+    auto make_shapes = [&]() {
+        std::vector<my_ptr::unique_ptr<Shape>> shapes;
+        shapes.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            if (i % 2) {
+                shapes.push_back(my_ptr::make_unique<Square>(i % 100));
+            } else {
+                shapes.push_back(my_ptr::make_unique<Rect>(i % 100, 3));
+            }
+        }
+        std::shuffle(shapes.begin(), shapes.end(), rng);
+        return shapes;
+    };
+
+    // vector<unique_ptr>
+    auto uvec = make_shapes();
+    long long usum = 0;
+    auto u_iter = time_us([&]() {
+        for (const auto& s : uvec) usum += s->area();
+    });
+    auto u_erase = time_us([&]() {
+        for (int i = 0; i < 1000; ++i) uvec.erase(uvec.begin() + (uvec.size() / 2));
+    });
+    auto u_clear = time_us([&]() { uvec.clear(); });
+
+    // ptr_vector
+    my_ptr::ptr_vector<Shape> pvec;
+    {
+        auto shapes = make_shapes();
+        for (auto& s : shapes) pvec.push_back(std::move(s));
+    }
+    long long psum = 0;
+    auto p_iter = time_us([&]() {
+        for (const auto& s : pvec) psum += s.area();
+    });
+    auto p_erase = time_us([&]() {
+        for (int i = 0; i < 1000; ++i) pvec.erase(pvec.begin() + (pvec.size() / 2));
+    });
+    auto p_clear = time_us([&]() { pvec.clear(); });
+
+    // ptr_vector + arena
+    my_ptr::ptr_vector<Shape, my_ptr::arena_delete<Shape>> avec;
+    auto a_fill = time_us([&]() {
+        for (int i = 0; i < count; ++i) {
+            if (i % 2) avec.emplace_back<Square>(i % 100);
+            else avec.emplace_back<Rect>(i % 100, 3);
+        }
+    });
+    auto a_clear = time_us([&]() { avec.clear(); });
+
+    std::cout << "\nptr_vector benchmark (" << count << " objects):\n";
+    std::cout << "  iterate  vector<unique_ptr>: " << u_iter << " μs, ptr_vector: " << p_iter << " μs"
+              << (usum == psum ? "" : " (MISMATCH)") << "\n";
+    std::cout << "  erase    vector<unique_ptr>: " << u_erase << " μs, ptr_vector: " << p_erase << " μs\n";
+    std::cout << "  clear    vector<unique_ptr>: " << u_clear << " μs, ptr_vector: " << p_clear << " μs\n";
+    std::cout << "  arena    fill: " << a_fill << " μs, clear: " << a_clear << " μs\n";
+}
+
+// 测试长链/深树的析构性能（std 版本需手动逐个断链才能避免栈溢出）
+template <template <typename> class SP>
+struct ListNode {
+    int value;
+    SP<ListNode> next;
+    explicit ListNode(int v) : value(v) {}
+};
+
+template <template <typename> class SP>
+struct BinNode {
+    int value;
+    SP<BinNode> left, right;
+    explicit BinNode(int v) : value(v) {}
+};
+
+template <typename T> using my_sp = my_ptr::shared_ptr<T>;
+template <typename T> using std_sp = std::shared_ptr<T>;
+
+template <template <typename> class SP, typename Make>
+SP<BinNode<SP>> build_tree(int depth, Make make) {
+    auto node = make(depth);
+    if (depth > 0) {
+        node->left = build_tree<SP>(depth - 1, make);
+        node->right = build_tree<SP>(depth - 1, make);
+    }
+    return node;
+}
+
+struct UniqueListNode {
+    int value;
+    my_ptr::unique_ptr<UniqueListNode, my_ptr::iterative_delete<UniqueListNode>> next;
+    explicit UniqueListNode(int v) : value(v) {}
+};
+
+void benchmark_teardown() {
+    const int length = 2000000;
+    const int depth = 20;
+
+    auto my_list = my_ptr::make_shared<ListNode<my_sp>>(0);
+    {
+        auto *tail = my_list.get();
+        for (int i = 1; i < length; ++i) {
+            tail->next = my_ptr::make_shared<ListNode<my_sp>>(i);
+            tail = tail->next.get();
+        }
+    }
+    auto my_list_us = time_us([&]() { my_list.reset(); });
+
+    auto std_list = std::make_shared<ListNode<std_sp>>(0);
+    {
+        auto *tail = std_list.get();
+        for (int i = 1; i < length; ++i) {
+            tail->next = std::make_shared<ListNode<std_sp>>(i);
+            tail = tail->next.get();
+        }
+    }
+    auto std_list_us = time_us([&]() {
+        while (std_list) {
+            auto next = std::move(std_list->next);
+            std_list = std::move(next);
+        }
+    });
+
+    my_ptr::unique_ptr<UniqueListNode, my_ptr::iterative_delete<UniqueListNode>> uq_list(new UniqueListNode(0));
+    {
+        auto *tail = uq_list.get();
+        for (int i = 1; i < length; ++i) {
+            tail->next.reset(new UniqueListNode(i));
+            tail = tail->next.get();
+        }
+    }
+    auto uq_list_us = time_us([&]() { uq_list.reset(); });
+
+    auto my_tree = build_tree<my_sp>(depth, [](int v) { return my_ptr::make_shared<BinNode<my_sp>>(v); });
+    auto my_tree_us = time_us([&]() { my_tree.reset(); });
+    auto std_tree = build_tree<std_sp>(depth, [](int v) { return std::make_shared<BinNode<std_sp>>(v); });
+    auto std_tree_us = time_us([&]() { std_tree.reset(); });
+
+    std::cout << "\nTeardown benchmark:\n";
+    std::cout << "  list of " << length << " my_ptr::shared_ptr (iterative): " << my_list_us << " μs\n";
+    std::cout << "  list of " << length << " std::shared_ptr (manual unlink): " << std_list_us << " μs\n";
+    std::cout << "  list of " << length << " my_ptr::unique_ptr (iterative_delete): " << uq_list_us << " μs\n";
+    std::cout << "  tree of 2^" << (depth + 1) << " my_ptr::shared_ptr: " << my_tree_us << " μs\n";
+    std::cout << "  tree of 2^" << (depth + 1) << " std::shared_ptr (recursive): " << std_tree_us << " μs\n";
+}
+
+// 测试并行释放大型对象图的墙钟时间
+// 默认 2^22 个节点，使整个基准程序在小内存的机器上几分钟内跑完；
+// 设置 MY_PTR_BENCH_RELEASE_NODES=100000000 测量请求的 1 亿节点规模（取 2^27 - 1 个节点，约需 11 GB 内存）
+void benchmark_parallel_release() {
+    int depth = 21;
+    if (const char *env = std::getenv("MY_PTR_BENCH_RELEASE_NODES")) {
+        unsigned long long nodes = std::strtoull(env, nullptr, 10);
+        depth = 0;
+        while (depth < 30 && ((2ull << depth) - 1) < nodes) { // 取节点数不少于请求值的最小满二叉树
+            ++depth;
+        }
+    }
+    std::size_t threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    auto make = [](int v) { return my_ptr::make_shared<BinNode<my_sp>>(v); };
+
+    auto serial_tree = build_tree<my_sp>(depth, make);
+    auto serial_us = time_us([&]() { serial_tree.reset(); });
+
+    my_ptr::thread_pool pool(threads);
+    auto parallel_tree = build_tree<my_sp>(depth, make);
+    auto parallel_us = time_us([&]() {
+        my_ptr::parallel_release(std::move(parallel_tree), pool).wait();
+    });
+
+    std::cout << "\nParallel release benchmark (tree of 2^" << (depth + 1) << " - 1 nodes, "
+              << threads << " threads):\n";
+    std::cout << "  serial: " << serial_us << " μs\n";
+    std::cout << "  parallel_release: " << parallel_us << " μs\n";
+}
+
+// 测试阻塞等待的唤醒延迟（对比 use_count 睡眠轮询）
+void benchmark_wait_wakeup() {
+    const int rounds = 200;
+    using clock = std::chrono::steady_clock;
+
+    auto measure = [&](auto wait) {
+        long long total_ns = 0;
+        for (int r = 0; r < rounds; ++r) {
+            auto owner = my_ptr::make_shared<TestClass>(r);
+            std::atomic<long long> released_at{0};
+            std::thread reader([copy = owner, &released_at]() mutable {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                released_at.store(clock::now().time_since_epoch().count());
+                copy.reset();
+            });
+            wait(owner);
+            total_ns += clock::now().time_since_epoch().count() - released_at.load();
+            reader.join();
+        }
+        return total_ns / rounds;
+    };
+
+    auto futex_ns = measure([](my_ptr::shared_ptr<TestClass>& sp) { sp.wait_for_unique(); });
+    auto poll_ns = measure([](my_ptr::shared_ptr<TestClass>& sp) {
+        while (sp.use_count() != 1) {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    });
+
+    std::cout << "\nWake-up latency benchmark (" << rounds << " rounds):\n";
+    std::cout << "  wait_for_unique (futex): " << futex_ns / 1000.0 << " μs\n";
+    std::cout << "  use_count sleep-poll (50 μs): " << poll_ns / 1000.0 << " μs\n";
+}
+
+// 测试多线程拷贝同一个全局单例的吞吐（普通计数 vs 永生对象）
+void benchmark_immortal_copy() {
+    std::size_t threads = std::thread::hardware_concurrency();
+    if (threads < 4) threads = 4;
+    const int copies_per_thread = 1000000;
+
+    auto run = [&](const auto& global) {
+        std::vector<std::thread> workers;
+        return time_us([&]() {
+            for (std::size_t t = 0; t < threads; ++t) {
+                workers.emplace_back([&global, copies_per_thread]() {
+                    long long sum = 0;
+                    for (int i = 0; i < copies_per_thread; ++i) {
+                        auto local = global;
+                        sum += local->value;
+                    }
+                    if (sum == -1) std::cout << "";
+                });
+            }
+            for (auto& w : workers) w.join();
+        });
+    };
+
+    auto mortal = my_ptr::make_shared<TestClass>(1);
+    auto immortal = my_ptr::make_immortal_shared<TestClass>(1);
+    static TestClass static_obj(1);
+    auto adopted = my_ptr::adopt_static(static_obj);
+    auto std_sp = std::make_shared<TestClass>(1);
+
+    auto mortal_us = run(mortal);
+    auto immortal_us = run(immortal);
+    auto adopted_us = run(adopted);
+    auto std_us = run(std_sp);
+
+    std::cout << "\nShared singleton copy benchmark (" << threads << " threads x " << copies_per_thread << " copies):\n";
+    std::cout << "  my_ptr::make_shared: " << mortal_us << " μs\n";
+    std::cout << "  my_ptr::make_immortal_shared: " << immortal_us << " μs\n";
+    std::cout << "  my_ptr::adopt_static: " << adopted_us << " μs\n";
+    std::cout << "  std::make_shared: " << std_us << " μs\n";
+}
+
+// 测试 MPMC 队列传递 shared_ptr 的吞吐和延迟（对比 mutex + std::deque 拷贝传递）
+struct QueuedTask {
+    long long enqueued_ns;
+    explicit QueuedTask(long long t) : enqueued_ns(t) {}
+};
+
+template <typename Push, typename Pop>
+void run_mpmc(const char* name, int producers, int consumers, int per_producer, Push push, Pop pop) {
+    using clock = std::chrono::steady_clock;
+    std::atomic<int> consumed{0};
+    std::atomic<long long> latency_ns{0};
+    const int total = producers * per_producer;
+    std::vector<std::thread> threads;
+
+    auto us = time_us([&]() {
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&]() {
+                for (int i = 0; i < per_producer; ++i) {
+                    push(my_ptr::make_shared<QueuedTask>(clock::now().time_since_epoch().count()));
+                }
+            });
+        }
+        for (int c = 0; c < consumers; ++c) {
+            threads.emplace_back([&]() {
+                my_ptr::shared_ptr<QueuedTask> task;
+                long long local_latency = 0;
+                while (consumed.load(std::memory_order_relaxed) < total) {
+                    if (pop(task)) {
+                        local_latency += clock::now().time_since_epoch().count() - task->enqueued_ns;
+                        task.reset();
+                        consumed.fetch_add(1, std::memory_order_relaxed);
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+                latency_ns += local_latency;
+            });
+        }
+        for (auto& t : threads) t.join();
+    });
+
+    std::cout << "  " << name << ": " << (total * 1000000.0 / us) / 1e6 << " M msgs/s, avg latency "
+              << latency_ns.load() / total / 1000.0 << " μs\n";
+}
+
+void benchmark_ownership_queue() {
+    const int per_producer = 200000;
+    std::cout << "\nMPMC ownership transfer benchmark:\n";
+    for (int threads : {1, 2, 4}) {
+        std::cout << " " << threads << " producers / " << threads << " consumers\n";
+
+        my_ptr::ownership_queue<my_ptr::shared_ptr<QueuedTask>> q(1024);
+        run_mpmc("ownership_queue", threads, threads, per_producer,
+            [&](my_ptr::shared_ptr<QueuedTask>&& t) {
+                while (!q.try_push(std::move(t))) std::this_thread::yield();
+            },
+            [&](my_ptr::shared_ptr<QueuedTask>& out) { return q.try_pop(out); });
+
+        std::mutex m;
+        std::deque<my_ptr::shared_ptr<QueuedTask>> dq;
+        run_mpmc("mutex + deque (copy)", threads, threads, per_producer,
+            [&](const my_ptr::shared_ptr<QueuedTask>& t) {
+                std::lock_guard<std::mutex> lock(m);
+                dq.push_back(t);
+            },
+            [&](my_ptr::shared_ptr<QueuedTask>& out) {
+                std::lock_guard<std::mutex> lock(m);
+                if (dq.empty()) return false;
+                out = dq.front();
+                dq.pop_front();
+                return true;
+            });
+    }
+}
+
+// 测试 SPSC 环形缓冲组成的多阶段流水线吞吐（消息/秒）
+struct Record {
+    std::uint64_t id;
+    char payload[56];
+    explicit Record(std::uint64_t i) : id(i), payload{} {}
+};
+
+template <typename Wait>
+double run_pipeline(int stages, int messages) {
+    using ring_type = my_ptr::spsc_ring<Record, my_ptr::detail::default_delete<Record>, Wait>;
+    const std::size_t batch = 32;
+    std::vector<std::unique_ptr<ring_type>> rings;
+    for (int i = 0; i < stages - 1; ++i) {
+        rings.push_back(std::make_unique<ring_type>(1024));
+    }
+
+    std::vector<std::thread> threads;
+    std::uint64_t checksum = 0;
+    auto us = time_us([&]() {
+        // 第一阶段：解析（生成）记录
+        threads.emplace_back([&]() {
+            my_ptr::unique_ptr<Record> buf[batch];
+            for (int i = 0; i < messages; i += batch) {
+                std::size_t n = 0;
+                for (; n < batch && i + static_cast<int>(n) < messages; ++n) {
+                    buf[n].reset(new Record(i + n));
+                }
+                for (std::size_t done = 0; done < n;) {
+                    std::size_t pushed = rings[0]->push_batch(buf + done, n - done);
+                    if (pushed == 0) {
+                        my_ptr::unique_ptr<Record> one = std::move(buf[done]);
+                        rings[0]->push(std::move(one));
+                        pushed = 1;
+                    }
+                    done += pushed;
+                }
+            }
+            rings[0]->close();
+        });
+        // 中间阶段：转发
+        for (int s = 1; s < stages - 1; ++s) {
+            threads.emplace_back([&, s]() {
+                my_ptr::unique_ptr<Record> item;
+                while (rings[s - 1]->pop(item)) {
+                    item->payload[0] = static_cast<char>(s);
+                    rings[s]->push(std::move(item));
+                }
+                rings[s]->close();
+            });
+        }
+        // 最后阶段：消费并释放
+        threads.emplace_back([&]() {
+            my_ptr::unique_ptr<Record> item;
+            while (rings.back()->pop(item)) {
+                checksum += item->id;
+                item.reset();
+            }
+        });
+        for (auto& t : threads) t.join();
+    });
+    if (checksum != static_cast<std::uint64_t>(messages) * (messages - 1) / 2) {
+        std::cout << "  (checksum mismatch)\n";
+    }
+    return messages * 1000000.0 / us;
+}
+
+void benchmark_spsc_pipeline() {
+    const int messages = 1000000;
+    std::cout << "\nSPSC pipeline benchmark (" << messages << " records):\n";
+    for (int stages : {2, 4}) {
+        std::cout << "  " << stages << " stages, busy-poll: "
+                  << run_pipeline<my_ptr::busy_poll_wait>(stages, messages) / 1e6 << " M msgs/s\n";
+        std::cout << "  " << stages << " stages, futex:     "
+                  << run_pipeline<my_ptr::futex_wait_strategy>(stages, messages) / 1e6 << " M msgs/s\n";
+    }
+}
+
+// 测试命中率为主的多线程 get：分片 CLOCK 缓存 vs 全局互斥锁 LRU
+class global_mutex_lru {
+private:
+    std::mutex mutex_;
+    std::list<std::pair<int, my_ptr::shared_ptr<std::string>>> order_;
+    std::unordered_map<int, decltype(order_)::iterator> map_;
+    std::size_t capacity_;
+
+public:
+    explicit global_mutex_lru(std::size_t capacity) : capacity_(capacity) {}
+
+    my_ptr::shared_ptr<std::string> get(int key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = map_.find(key);
+        if (it == map_.end()) return my_ptr::shared_ptr<std::string>();
+        order_.splice(order_.begin(), order_, it->second);
+        return it->second->second;
+    }
+
+    void put(int key, my_ptr::shared_ptr<std::string> value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = map_.find(key);
+        if (it != map_.end()) {
+            it->second->second = std::move(value);
+            order_.splice(order_.begin(), order_, it->second);
+            return;
+        }
+        order_.emplace_front(key, std::move(value));
+        map_[key] = order_.begin();
+        if (order_.size() > capacity_) {
+            map_.erase(order_.back().first);
+            order_.pop_back();
+        }
+    }
+};
+
+void benchmark_lru_cache() {
+    const int keys = 100000;
+    const int capacity = 80000;
+    const int ops_per_thread = 500000;
+    std::size_t threads = std::thread::hardware_concurrency();
+    if (threads < 4) threads = 4;
+
+    auto run = [&](auto get, auto put) {
+        for (int k = 0; k < keys; ++k) put(k);
+        std::atomic<long long> hits{0};
+        std::vector<std::thread> workers;
+        auto us = time_us([&]() {
+            for (std::size_t t = 0; t < threads; ++t) {
+                workers.emplace_back([&, t]() {
+                    std::mt19937 rng(static_cast<unsigned>(t));
+                    // 90% 的访问落在 10% 的热点键上
+                    std::uniform_int_distribution<int> hot(0, keys / 10 - 1), all(0, keys - 1), pct(0, 99);
+                    long long local_hits = 0;
+                    for (int i = 0; i < ops_per_thread; ++i) {
+                        int key = pct(rng) < 90 ? hot(rng) : all(rng);
+                        if (get(key)) ++local_hits;
+                        else put(key);
+                    }
+                    hits += local_hits;
+                });
+            }
+            for (auto& w : workers) w.join();
+        });
+        return std::make_pair(us, hits.load() * 100.0 / (threads * ops_per_thread));
+    };
+
+    my_ptr::lru_cache<int, std::string> sharded(capacity * sizeof(std::string), 64);
+    auto r1 = run([&](int k) { return sharded.get(k); },
+                  [&](int k) { sharded.put(k, my_ptr::make_shared<std::string>("value")); });
+
+    global_mutex_lru global(capacity);
+    auto r2 = run([&](int k) { return global.get(k); },
+                  [&](int k) { global.put(k, my_ptr::make_shared<std::string>("value")); });
+
+    std::cout << "\nLRU cache benchmark (" << threads << " threads x " << ops_per_thread << " ops):\n";
+    std::cout << "  my_ptr::lru_cache (64 shards, CLOCK): " << r1.first << " μs, hit rate " << r1.second << "%\n";
+    std::cout << "  global mutex + std::list LRU: " << r2.first << " μs, hit rate " << r2.second << "%\n";
+}
+
+// 当前进程的常驻内存（KB），读取 /proc/self/statm；不可用时返回 0
+long current_rss_kb() {
+    std::ifstream statm("/proc/self/statm");
+    long pages = 0, resident = 0;
+    if (!(statm >> pages >> resident)) {
+        return 0;
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// 堆上正在使用的字节数（KB）；glibc 用 mallinfo2，其它平台退化为 RSS。
+// 释放的内存通常被分配器留作缓存，RSS 不会回落，比较前后差值时堆统计更可靠
+long heap_in_use_kb() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 mi = mallinfo2();
+    return static_cast<long>((mi.uordblks + mi.hblkhd) / 1024);
+#else
+    return current_rss_kb();
+#endif
+}
+
+void benchmark_intern_pool() {
+    const int records = 500000;
+    const int distinct = 1000;
+    std::size_t threads = std::thread::hardware_concurrency();
+    if (threads < 4) threads = 4;
+
+    std::vector<std::string> tags;
+    for (int i = 0; i < distinct; ++i) {
+        tags.push_back("service.region-" + std::to_string(i % 7) + ".endpoint/" + std::to_string(i));
+    }
+
+    // 内存：每条记录各自持有一份拷贝 vs 驻留后共享
+    long base = heap_in_use_kb();
+    std::vector<my_ptr::shared_ptr<const std::string>> copies;
+    copies.reserve(records);
+    for (int i = 0; i < records; ++i) {
+        copies.push_back(my_ptr::make_shared<const std::string>(tags[i % distinct]));
+    }
+    long copy_kb = heap_in_use_kb() - base;
+    copies.clear();
+    copies.shrink_to_fit();
+
+    my_ptr::intern_pool<std::string> pool;
+    base = heap_in_use_kb();
+    std::vector<my_ptr::shared_ptr<const std::string>> interned;
+    interned.reserve(records);
+    for (int i = 0; i < records; ++i) {
+        interned.push_back(pool.intern(tags[i % distinct]));
+    }
+    long intern_kb = heap_in_use_kb() - base;
+    interned.clear();
+
+    // 吞吐：多线程并发驻留（热点值常驻）vs 每次 make_shared 一份拷贝
+    std::vector<my_ptr::shared_ptr<const std::string>> pinned;
+    for (const auto& t : tags) pinned.push_back(pool.intern(t));
+    auto run = [&](auto make) {
+        std::vector<std::thread> workers;
+        return time_us([&]() {
+            for (std::size_t t = 0; t < threads; ++t) {
+                workers.emplace_back([&, t]() {
+                    for (int i = 0; i < records / 4; ++i) {
+                        auto p = make(tags[(i * 7 + t) % distinct]);
+                        (void)p;
+                    }
+                });
+            }
+            for (auto& w : workers) w.join();
+        });
+    };
+    auto intern_us = run([&](const std::string& s) { return pool.intern(s); });
+    auto copy_us = run([&](const std::string& s) { return my_ptr::make_shared<const std::string>(s); });
+
+    std::cout << "\nintern_pool benchmark (" << records << " tags, " << distinct << " distinct):\n";
+    std::cout << "  heap growth, one copy per record: " << copy_kb << " KB\n";
+    std::cout << "  heap growth, interned: " << intern_kb << " KB\n";
+    std::cout << "  " << threads << " threads x " << records / 4 << " lookups, intern: " << intern_us << " μs\n";
+    std::cout << "  " << threads << " threads x " << records / 4 << " lookups, make_shared copy: " << copy_us << " μs\n";
+}
+
+void benchmark_shared_buffer() {
+    const int fields = 4000;
+    const int rounds = 200;
+
+    // 构造一条 "key=value;" 组成的报文，value 长度超过 SSO 阈值
+    std::string payload;
+    for (int i = 0; i < fields; ++i) {
+        payload += "field" + std::to_string(i) + "=session-token/" + std::to_string(i * 7919) + "/0123456789abcdef;";
+    }
+    my_ptr::shared_buffer message(payload);
+
+    // 解析出每个字段的 key/value 切片
+    auto slice_us = time_us([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            std::vector<std::pair<my_ptr::buffer_slice, my_ptr::buffer_slice>> out;
+            out.reserve(fields);
+            std::string_view sv = message.view();
+            std::size_t pos = 0;
+            while (pos < sv.size()) {
+                std::size_t eq = sv.find('=', pos);
+                std::size_t end = sv.find(';', eq);
+                out.emplace_back(message.slice(pos, eq - pos), message.slice(eq + 1, end - eq - 1));
+                pos = end + 1;
+            }
+        }
+    });
+
+    auto copy_us = time_us([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            std::vector<std::pair<std::string, std::string>> out;
+            out.reserve(fields);
+            std::string_view sv = payload;
+            std::size_t pos = 0;
+            while (pos < sv.size()) {
+                std::size_t eq = sv.find('=', pos);
+                std::size_t end = sv.find(';', eq);
+                out.emplace_back(std::string(sv.substr(pos, eq - pos)), std::string(sv.substr(eq + 1, end - eq - 1)));
+                pos = end + 1;
+            }
+        }
+    });
+
+    std::cout << "\nshared_buffer parse-and-slice (" << rounds << " x " << fields << " fields, "
+              << payload.size() << " bytes):\n";
+    std::cout << "  buffer_slice (zero-copy): " << slice_us << " μs\n";
+    std::cout << "  copy into std::string: " << copy_us << " μs\n";
+}
+
+void benchmark_map_file() {
+    const std::size_t file_size = std::size_t(64) << 20;
+    const std::string path = "benchmark_map_file.tmp";
+    {
+        std::ofstream out(path, std::ios::binary);
+        std::string block(1 << 20, 'x');
+        for (std::size_t i = 0; i < file_size / block.size(); ++i) out.write(block.data(), block.size());
+    }
+    auto checksum = [](const char *p, std::size_t n) {
+        unsigned long long sum = 0;
+        for (std::size_t i = 0; i < n; i += 4096) sum += static_cast<unsigned char>(p[i]);
+        return sum;
+    };
+
+#if defined(__GLIBC__)
+    malloc_trim(0); // 归还前面基准留下的空闲堆页，否则新缓冲会复用已驻留的内存
+#endif
+    // 读入堆缓冲：就绪前必须完整拷贝一遍
+    long rss_before = current_rss_kb();
+    std::unique_ptr<char[]> heap;
+    auto read_ready_us = time_us([&]() {
+        std::ifstream in(path, std::ios::binary);
+        heap.reset(new char[file_size]);
+        in.read(heap.get(), file_size);
+    });
+    long read_rss = current_rss_kb() - rss_before;
+    unsigned long long s1 = 0;
+    auto read_scan_us = time_us([&]() { s1 = checksum(heap.get(), file_size); });
+    heap.reset();
+
+    // 映射：返回即就绪，页面按需从页缓存映射
+    rss_before = current_rss_kb();
+    my_ptr::buffer_slice mapped;
+    auto map_ready_us = time_us([&]() { mapped = my_ptr::map_file(path, my_ptr::map_sequential); });
+    long map_rss = current_rss_kb() - rss_before;
+    unsigned long long s2 = 0;
+    auto map_scan_us = time_us([&]() { s2 = checksum(mapped.data(), mapped.size()); });
+    mapped = my_ptr::buffer_slice();
+    std::remove(path.c_str());
+
+    std::cout << "\nmap_file benchmark (" << (file_size >> 20) << " MB file, checksums " << (s1 == s2 ? "match" : "DIFFER") << "):\n";
+    std::cout << "  read into buffer: ready in " << read_ready_us << " μs, RSS +" << read_rss
+              << " KB, first scan " << read_scan_us << " μs\n";
+    std::cout << "  map_file: ready in " << map_ready_us << " μs, RSS +" << map_rss
+              << " KB, first scan " << map_scan_us << " μs\n";
+}
+
+void benchmark_chunk_reader() {
+    const std::size_t file_size = std::size_t(256) << 20;
+    const std::string path = "benchmark_chunk_reader.tmp";
+    {
+        std::ofstream out(path, std::ios::binary);
+        std::string block;
+        while (block.size() < (1 << 20)) block += "2024-01-01T00:00:00Z INFO request served in 42ms\n";
+        block.resize(1 << 20);
+        block.back() = '\n';
+        for (std::size_t i = 0; i < file_size / block.size(); ++i) out.write(block.data(), block.size());
+    }
+
+    long long lines1 = 0;
+    auto chunk_us = time_us([&]() {
+        my_ptr::chunk_reader reader(path, std::size_t(1) << 20, 4);
+        my_ptr::buffer_slice chunk;
+        while (reader.next(chunk)) {
+            lines1 += std::count(chunk.begin(), chunk.end(), '\n');
+        }
+    });
+
+    long long lines2 = 0;
+    auto ifstream_us = time_us([&]() {
+        std::ifstream in(path);
+        std::string line;
+        while (std::getline(in, line)) ++lines2;
+    });
+    std::remove(path.c_str());
+
+    std::cout << "\nchunk_reader benchmark (" << (file_size >> 20) << " MB, " << lines1 << " lines"
+              << (lines1 == lines2 ? "" : ", LINE COUNT MISMATCH") << "):\n";
+    std::cout << "  chunk_reader (1 MB pooled chunks, read-ahead 4): " << chunk_us << " μs, "
+              << (file_size >> 20) * 1000000.0 / chunk_us << " MB/s\n";
+    std::cout << "  ifstream getline: " << ifstream_us << " μs, "
+              << (file_size >> 20) * 1000000.0 / ifstream_us << " MB/s\n";
+}
+
+void benchmark_buffer_chain() {
+    const std::size_t total = std::size_t(256) << 20;
+    const std::size_t payload_size = 1024;
+    const int batch = 256; // 每批消息写一次
+    const std::string path = "benchmark_buffer_chain.tmp";
+
+    // 待发送的消息体已在引用计数缓冲中（例如来自缓存或上游）
+    std::vector<my_ptr::shared_buffer> payloads;
+    for (int i = 0; i < 16; ++i) payloads.emplace_back(std::string(payload_size, static_cast<char>('a' + i)));
+    const std::size_t messages = total / payload_size;
+
+    auto chain_us = time_us([&]() {
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        my_ptr::buffer_chain chain;
+        for (std::size_t i = 0; i < messages; ++i) {
+            std::uint32_t len = static_cast<std::uint32_t>(payload_size);
+            chain.append_copy(&len, sizeof(len));
+            chain.append(payloads[i % payloads.size()].slice());
+            if ((i + 1) % batch == 0) {
+                chain.write_to(fd);
+                chain.clear();
+            }
+        }
+        chain.write_to(fd);
+        ::close(fd);
+    });
+
+    auto string_us = time_us([&]() {
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        std::string out;
+        for (std::size_t i = 0; i < messages; ++i) {
+            std::uint32_t len = static_cast<std::uint32_t>(payload_size);
+            out.append(reinterpret_cast<const char*>(&len), sizeof(len));
+            const auto& p = payloads[i % payloads.size()];
+            out.append(p.data(), p.size());
+            if ((i + 1) % batch == 0) {
+                ssize_t rc = ::write(fd, out.data(), out.size());
+                (void)rc;
+                out.clear();
+            }
+        }
+        ssize_t rc = ::write(fd, out.data(), out.size());
+        (void)rc;
+        ::close(fd);
+    });
+    std::remove(path.c_str());
+
+    std::cout << "\nbuffer_chain framed write (" << (total >> 20) << " MB payload, " << messages << " messages):\n";
+    std::cout << "  buffer_chain + writev: " << chain_us << " μs\n";
+    std::cout << "  std::string concat + write: " << string_us << " μs\n";
+}
+
+struct DagNode {
+    std::uint64_t value = 0;
+    my_ptr::shared_ptr<DagNode> next;
+    my_ptr::shared_ptr<DagNode> skip; // 跨越若干节点的共享边，使之成为 DAG 而非链表
+
+    template <typename Archive>
+    void serialize(Archive& ar) {
+        ar(value, next, skip);
+    }
+};
+
+void benchmark_serialization() {
+    const std::size_t nodes = 2000000;
+    const std::size_t skip_distance = 7;
+
+    std::vector<my_ptr::shared_ptr<DagNode>> built(nodes);
+    for (std::size_t i = nodes; i-- > 0;) {
+        auto n = my_ptr::make_shared<DagNode>();
+        n->value = i * 2654435761u;
+        if (i + 1 < nodes) n->next = built[i + 1];
+        if (i + skip_distance < nodes) n->skip = built[i + skip_distance];
+        built[i] = std::move(n);
+    }
+    my_ptr::shared_ptr<DagNode> root = built[0];
+    built.clear();
+    built.shrink_to_fit();
+
+    std::stringstream stream;
+    std::size_t written = 0;
+    auto save_us = time_us([&]() {
+        my_ptr::output_archive out(stream);
+        out(root);
+        out.flush();
+        written = out.objects_written();
+    });
+    std::size_t bytes = stream.str().size();
+
+    my_ptr::shared_ptr<DagNode> loaded;
+    std::size_t read = 0;
+    auto load_us = time_us([&]() {
+        my_ptr::input_archive in(stream);
+        in(loaded);
+        read = in.objects_read();
+    });
+
+    std::cout << "\nserialization benchmark (" << nodes << "-node DAG, " << bytes / 1024 << " KB archive):\n";
+    std::cout << "  serialize: " << save_us << " μs, " << written * 1.0 / save_us << " M nodes/s\n";
+    std::cout << "  deserialize: " << load_us << " μs, " << read * 1.0 / load_us << " M nodes/s\n";
+}
+
+struct SnapIndexNode {
+    std::uint64_t key;
+    std::uint64_t value;
+    my_ptr::offset_ptr<const SnapIndexNode> left;
+    my_ptr::offset_ptr<const SnapIndexNode> right;
+};
+
+struct HeapIndexNode {
+    std::uint64_t key = 0;
+    std::uint64_t value = 0;
+    my_ptr::shared_ptr<HeapIndexNode> left;
+    my_ptr::shared_ptr<HeapIndexNode> right;
+
+    template <typename Archive>
+    void serialize(Archive& ar) {
+        ar(key, value, left, right);
+    }
+};
+
+template <typename Node>
+std::uint64_t index_lookup(const Node *n, std::uint64_t key) {
+    while (n) {
+        if (key == n->key) return n->value;
+        n = key < n->key ? n->left.get() : n->right.get();
+    }
+    return 0;
+}
+
+void benchmark_snapshot() {
+    const std::size_t nodes = 2000000;
+    const std::string snap_path = "benchmark_snapshot.tmp";
+    const std::string archive_path = "benchmark_archive.tmp";
+
+    // 同一棵平衡二叉搜索树，分别写成快照和序列化档案
+    {
+        my_ptr::snapshot_builder builder;
+        auto arr = builder.create_array<SnapIndexNode>(nodes);
+        SnapIndexNode *base = builder[arr];
+        auto link = [&](auto&& self, std::size_t lo, std::size_t hi) -> const SnapIndexNode* {
+            if (lo >= hi) return nullptr;
+            std::size_t mid = lo + (hi - lo) / 2;
+            base[mid].key = mid * 2;
+            base[mid].value = mid + 1;
+            base[mid].left = self(self, lo, mid);
+            base[mid].right = self(self, mid + 1, hi);
+            return &base[mid];
+        };
+        link(link, 0, nodes);
+        builder.add_root(arr.at(nodes / 2));
+        builder.write(snap_path);
+
+        auto build = [&](auto&& self, std::size_t lo, std::size_t hi) -> my_ptr::shared_ptr<HeapIndexNode> {
+            if (lo >= hi) return nullptr;
+            std::size_t mid = lo + (hi - lo) / 2;
+            auto n = my_ptr::make_shared<HeapIndexNode>();
+            n->key = mid * 2;
+            n->value = mid + 1;
+            n->left = self(self, lo, mid);
+            n->right = self(self, mid + 1, hi);
+            return n;
+        };
+        auto root = build(build, 0, nodes);
+        std::ofstream out(archive_path, std::ios::binary);
+        my_ptr::output_archive ar(out);
+        ar(root);
+    }
+
+    const std::uint64_t probe = 2 * 1234567;
+    std::uint64_t v1 = 0, v2 = 0;
+    my_ptr::shared_ptr<HeapIndexNode> heap_root;
+    auto deserialize_us = time_us([&]() {
+        std::ifstream in(archive_path, std::ios::binary);
+        my_ptr::input_archive ar(in);
+        ar(heap_root);
+        v1 = index_lookup(heap_root.get(), probe);
+    });
+
+    my_ptr::shared_ptr<const SnapIndexNode> snap_root;
+    auto snapshot_us = time_us([&]() {
+        auto snap = my_ptr::snapshot::open(snap_path);
+        snap_root = snap.root<SnapIndexNode>(0);
+        v2 = index_lookup(snap_root.get(), probe);
+    });
+    heap_root.reset();
+    snap_root.reset();
+    std::remove(snap_path.c_str());
+    std::remove(archive_path.c_str());
+
+    std::cout << "\nsnapshot time-to-first-query (" << nodes << "-node index, results "
+              << (v1 == v2 && v1 != 0 ? "match" : "DIFFER") << "):\n";
+    std::cout << "  deserialize into heap + query: " << deserialize_us << " μs\n";
+    std::cout << "  mmap snapshot + query: " << snapshot_us << " μs\n";
+}
+
+void benchmark_weighted_fanout() {
+    const int rounds = 200000;
+    const int fanout = 16;
+    std::size_t threads = std::thread::hardware_concurrency();
+    if (threads < 4) threads = 4;
+
+    // 每轮：从本线程的句柄扇出 fanout 个拷贝，随后全部释放
+    auto run = [&](auto root, auto copy) {
+        std::vector<decltype(root)> handles;
+        for (std::size_t t = 0; t < threads; ++t) handles.push_back(copy(root));
+        std::vector<std::thread> workers;
+        root.reset();
+        return time_us([&]() {
+            for (std::size_t t = 0; t < threads; ++t) {
+                workers.emplace_back([&, t]() {
+                    std::vector<decltype(root)> copies;
+                    copies.reserve(fanout);
+                    for (int r = 0; r < rounds; ++r) {
+                        for (int i = 0; i < fanout; ++i) copies.push_back(copy(handles[t]));
+                        copies.clear();
+                    }
+                });
+            }
+            for (auto& w : workers) w.join();
+        });
+    };
+
+    auto shared_us = run(my_ptr::make_shared<int>(1), [](auto& h) { return h; });
+    auto weighted_us = run(my_ptr::make_weighted_shared<int>(1), [](auto& h) { return h.split(); });
+    long long copies = static_cast<long long>(threads) * rounds * fanout;
+    std::cout << "\nweighted_shared_ptr fan-out (" << threads << " threads x " << rounds << " rounds x "
+              << fanout << " copies):\n";
+    std::cout << "  my_ptr::shared_ptr: " << shared_us << " μs, " << copies * 1.0 / shared_us << " M copies/s\n";
+    std::cout << "  weighted_shared_ptr: " << weighted_us << " μs, " << copies * 1.0 / weighted_us << " M copies/s\n";
+}
+
+void benchmark_deferred_graph() {
+    const int nodes = 20000;
+    const int degree = 8;
+    const int hubs = 64;
+    const int passes = 20;
+    std::size_t threads = std::thread::hardware_concurrency();
+    if (threads < 4) threads = 4;
+
+    // 图分析的引用计数模式：每个节点的邻接表指向少数热点节点，
+    // 每一遍遍历把邻居句柄拷进本线程的前沿队列，处理完再整体释放
+    auto run = [&](auto make) {
+        using handle = decltype(make(0));
+        std::vector<handle> vertex;
+        for (int i = 0; i < nodes; ++i) vertex.push_back(make(i));
+        std::vector<std::vector<handle>> adjacency(nodes);
+        for (int i = 0; i < nodes; ++i) {
+            for (int k = 0; k < degree; ++k) adjacency[i].push_back(vertex[(i * 7 + k * 13) % hubs]);
+        }
+        long long sum = 0;
+        std::mutex sum_mutex;
+        auto us = time_us([&]() {
+            std::vector<std::thread> workers;
+            for (std::size_t t = 0; t < threads; ++t) {
+                workers.emplace_back([&, t]() {
+                    std::vector<handle> frontier;
+                    long long local = 0;
+                    for (int p = 0; p < passes; ++p) {
+                        for (std::size_t v = t; v < static_cast<std::size_t>(nodes); v += threads) {
+                            for (auto& n : adjacency[v]) frontier.push_back(n);
+                            if (frontier.size() >= 256) {
+                                for (auto& f : frontier) local += *f;
+                                frontier.clear();
+                            }
+                        }
+                    }
+                    frontier.clear();
+                    std::lock_guard<std::mutex> lock(sum_mutex);
+                    sum += local;
+                });
+            }
+            for (auto& w : workers) w.join();
+        });
+        return std::make_pair(us, sum);
+    };
+
+    auto shared = run([](int i) { return my_ptr::make_shared<int>(i); });
+    auto deferred = run([](int i) { return my_ptr::make_deferred_shared<int>(i); });
+    my_ptr::deferred_rc::collect_all();
+    long long copies = static_cast<long long>(nodes) * degree * passes;
+    std::cout << "\ndeferred_shared_ptr graph traversal (" << threads << " threads, " << nodes << " nodes x "
+              << degree << " edges into " << hubs << " hubs, " << passes << " passes; checksum "
+              << (shared.second == deferred.second ? "match" : "DIFFER") << "):\n";
+    std::cout << "  my_ptr::shared_ptr: " << shared.first << " μs, " << copies * 1.0 / shared.first << " M copies/s\n";
+    std::cout << "  deferred_shared_ptr: " << deferred.first << " μs, " << copies * 1.0 / deferred.first << " M copies/s\n";
+}
+
+// 析构前需要把缓冲刷到磁盘的对象：同步版本在析构函数里刷，异步版本在 async_dispose 里刷
+struct FlushOnClose {
+    int fd;
+    std::vector<char> buffer;
+
+    FlushOnClose(int f) : fd(f), buffer(64 * 1024, 'x') {}
+
+    void flush() {
+        if (::write(fd, buffer.data(), buffer.size()) < 0) std::perror("write");
+        ::fdatasync(fd);
+        buffer.clear();
+    }
+};
+
+struct SyncFlusher : FlushOnClose {
+    using FlushOnClose::FlushOnClose;
+    ~SyncFlusher() { flush(); }
+};
+
+struct AsyncFlusher : FlushOnClose {
+    using FlushOnClose::FlushOnClose;
+    void async_dispose(my_ptr::async_done done) {
+        flush();
+        done();
+    }
+};
+
+void benchmark_async_dispose() {
+    const std::string path = "benchmark_async_dispose.tmp";
+    const int objects = 200;
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::perror("open");
+        return;
+    }
+
+    // 调用者释放最后一个引用所花的时间
+    auto measure = [&](auto make) {
+        std::vector<long long> latency;
+        for (int i = 0; i < objects; ++i) {
+            auto p = make();
+            auto start = std::chrono::high_resolution_clock::now();
+            p.reset();
+            auto end = std::chrono::high_resolution_clock::now();
+            latency.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        }
+        std::sort(latency.begin(), latency.end());
+        long long sum = 0;
+        for (long long l : latency) sum += l;
+        return std::make_pair(sum / objects, latency[objects * 99 / 100]);
+    };
+
+    auto sync = measure([&]() { return my_ptr::make_shared<SyncFlusher>(fd); });
+    auto pool = std::make_unique<my_ptr::thread_pool>(2);
+    auto async = measure([&]() { return my_ptr::make_async_shared<AsyncFlusher>(*pool, fd); });
+    auto drain_us = time_us([&]() { pool.reset(); }); // 线程池析构时执行完所有收尾
+    ::close(fd);
+    std::remove(path.c_str());
+
+    std::cout << "\nasync_dispose caller-side release latency (" << objects << " objects, 64 KB flush + fdatasync each):\n";
+    std::cout << "  my_ptr::shared_ptr (flush in destructor): mean " << sync.first / 1000.0 << " μs, p99 "
+              << sync.second / 1000.0 << " μs\n";
+    std::cout << "  async_shared_ptr (flush on thread pool): mean " << async.first / 1000.0 << " μs, p99 "
+              << async.second / 1000.0 << " μs (all teardowns finished " << drain_us << " μs later)\n";
+}
+
+// 分片内的消息对象池：foreign_ptr 版本只在所属线程上操作，不加锁；
+// 基线版本允许接收方直接归还，必须加锁
+struct ShardMessage {
+    std::uint64_t payload[8];
+};
+
+template <bool Locked>
+struct shard_message_pool {
+    std::vector<ShardMessage*> free_list;
+    std::mutex mutex;
+    long outstanding = 0;
+
+    ~shard_message_pool() {
+        for (ShardMessage *m : free_list) delete m;
+    }
+
+    ShardMessage *acquire() {
+        std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+        if (Locked) lock.lock();
+        ++outstanding;
+        if (free_list.empty()) return new ShardMessage();
+        ShardMessage *m = free_list.back();
+        free_list.pop_back();
+        return m;
+    }
+
+    void recycle(ShardMessage *m) {
+        std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+        if (Locked) lock.lock();
+        --outstanding;
+        free_list.push_back(m);
+    }
+
+    long in_flight() {
+        std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+        if (Locked) lock.lock();
+        return outstanding;
+    }
+};
+
+template <bool Locked>
+struct pool_recycle {
+    shard_message_pool<Locked> *pool;
+    void operator()(ShardMessage *m) const { pool->recycle(m); }
+};
+
+void benchmark_foreign_ptr() {
+    const int shards = 4;
+    const int messages = 200000;
+    const std::size_t batch = 64;
+
+    // 分片环：每个分片从自己的池里取消息发给下一个分片，接收方读完即释放
+    auto run = [&](auto tag, auto wrap) {
+        constexpr bool locked = decltype(tag)::value;
+        using message = decltype(wrap(std::declval<my_ptr::unique_ptr<ShardMessage, pool_recycle<locked>>>()));
+        struct mailbox {
+            std::mutex m;
+            std::vector<message> items;
+        };
+        std::vector<mailbox> boxes(shards);
+        std::vector<std::unique_ptr<shard_message_pool<locked>>> pools;
+        for (int s = 0; s < shards; ++s) pools.push_back(std::make_unique<shard_message_pool<locked>>());
+        std::atomic<std::uint64_t> checksum{0};
+        auto us = time_us([&]() {
+            std::vector<std::thread> threads;
+            for (int s = 0; s < shards; ++s) {
+                threads.emplace_back([&, s]() {
+                    my_ptr::shard self;
+                    auto& pool = *pools[s];
+                    std::vector<message> out, in;
+                    std::uint64_t sum = 0;
+                    int sent = 0, got = 0;
+                    while (sent < messages || got < messages) {
+                        for (std::size_t i = 0; i < batch && sent < messages; ++i, ++sent) {
+                            ShardMessage *m = pool.acquire();
+                            m->payload[0] = static_cast<std::uint64_t>(sent);
+                            out.push_back(wrap(my_ptr::unique_ptr<ShardMessage, pool_recycle<locked>>(
+                                m, pool_recycle<locked>{&pool})));
+                        }
+                        {
+                            std::lock_guard<std::mutex> lock(boxes[(s + 1) % shards].m);
+                            auto& dst = boxes[(s + 1) % shards].items;
+                            for (auto& m : out) dst.push_back(std::move(m));
+                        }
+                        out.clear();
+                        {
+                            std::lock_guard<std::mutex> lock(boxes[s].m);
+                            in.swap(boxes[s].items);
+                        }
+                        for (auto& m : in) sum += m->payload[0];
+                        got += static_cast<int>(in.size());
+                        in.clear();
+                        self.poll();
+                        if (sent == messages) std::this_thread::yield();
+                    }
+                    while (pool.in_flight() != 0) {
+                        self.poll();
+                        std::this_thread::yield();
+                    }
+                    checksum += sum;
+                });
+            }
+            for (auto& t : threads) t.join();
+        });
+        return std::make_pair(us, checksum.load());
+    };
+
+    auto baseline = run(std::true_type{}, [](auto p) { return p; });
+    auto foreign = run(std::false_type{}, [](auto p) { return my_ptr::make_foreign(std::move(p)); });
+    long long total = static_cast<long long>(shards) * messages;
+    std::cout << "\nforeign_ptr cross-shard messages (" << shards << " shards x " << messages
+              << " messages, batches of " << batch << "; checksum "
+              << (baseline.second == foreign.second ? "match" : "DIFFER") << "):\n";
+    std::cout << "  free on receiver, locked pool: " << baseline.first << " μs, "
+              << total * 1.0 / baseline.first << " M msgs/s\n";
+    std::cout << "  foreign_ptr, home-shard release, unlocked pool: " << foreign.first << " μs, "
+              << total * 1.0 / foreign.first << " M msgs/s\n";
+}
+
+void benchmark_slot_map() {
+    const std::size_t entities = 10000000;
+    struct Entity {
+        float x, y, vx, vy;
+    };
+
+    // 随机顺序的查找，模拟系统之间按引用访问实体
+    std::vector<std::uint32_t> order(entities);
+    for (std::size_t i = 0; i < entities; ++i) order[i] = static_cast<std::uint32_t>(i);
+    std::shuffle(order.begin(), order.end(), std::mt19937(42));
+
+    double weak_lookup_us, weak_iterate_us, slot_lookup_us, slot_iterate_us;
+    float weak_sum = 0, slot_sum = 0;
+    {
+        std::vector<my_ptr::shared_ptr<Entity>> owners;
+        std::vector<my_ptr::weak_ptr<Entity>> refs;
+        owners.reserve(entities);
+        refs.reserve(entities);
+        for (std::size_t i = 0; i < entities; ++i) {
+            owners.push_back(my_ptr::make_shared<Entity>(Entity{1.0f * (i % 7), 0, 1, 0}));
+            refs.push_back(owners.back());
+        }
+        weak_lookup_us = time_us([&]() {
+            for (std::uint32_t i : order) {
+                if (auto p = refs[i].lock()) weak_sum += p->x;
+            }
+        });
+        weak_iterate_us = time_us([&]() {
+            for (auto& r : refs) {
+                if (auto p = r.lock()) p->x += p->vx;
+            }
+        });
+    }
+    {
+        my_ptr::slot_map<Entity> map;
+        std::vector<my_ptr::slot_handle64> refs;
+        refs.reserve(entities);
+        for (std::size_t i = 0; i < entities; ++i) {
+            refs.push_back(map.emplace(Entity{1.0f * (i % 7), 0, 1, 0}));
+        }
+        slot_lookup_us = time_us([&]() {
+            for (std::uint32_t i : order) {
+                if (Entity *p = map.get(refs[i])) slot_sum += p->x;
+            }
+        });
+        slot_iterate_us = time_us([&]() {
+            map.for_each([](my_ptr::slot_handle64, Entity& e) { e.x += e.vx; });
+        });
+    }
+
+    std::cout << "\nslot_map vs weak_ptr (" << entities / 1000000 << "M entities; checksum "
+              << (weak_sum == slot_sum ? "match" : "DIFFER") << "):\n";
+    std::cout << "  weak_ptr (" << sizeof(my_ptr::weak_ptr<Entity>) << " B/ref): random lock() " << weak_lookup_us / 1000
+              << " ms, iterate " << weak_iterate_us / 1000 << " ms\n";
+    std::cout << "  slot_map (" << sizeof(my_ptr::slot_handle64) << " B/ref): random get() " << slot_lookup_us / 1000
+              << " ms, iterate " << slot_iterate_us / 1000 << " ms\n";
+}
+
+void benchmark_compacting_arena() {
+    // 模拟 24 小时的负载：每小时对象数在高峰与低谷之间往返，并替换一部分对象；
+    // 另有一批长期存活的对象散布在堆中，阻止分配器归还空闲页
+    const int hours = 24;
+    const std::size_t peak = 600000, trough = 100000, long_lived = 20000;
+    struct Session {
+        long id;
+        char payload[120];
+    };
+
+    auto population = [&](int hour) { return hour % 2 == 0 ? peak : trough; };
+    std::mt19937 rng(7);
+
+#if defined(__GLIBC__)
+    malloc_trim(0); // 先归还前面测试留下的空闲堆，RSS 才能反映本测试的占用
+#endif
+    long heap_base = current_rss_kb();
+    long heap_peak = 0, heap_trough = 0;
+    long heap_sum = 0;
+    {
+        std::vector<my_ptr::shared_ptr<Session>> live;
+        for (int hour = 0; hour < hours; ++hour) {
+            std::size_t target = population(hour);
+            while (live.size() < target) {
+                live.push_back(my_ptr::make_shared<Session>(Session{static_cast<long>(live.size()), {}}));
+            }
+            // 低谷：随机淘汰（长期存活的前 long_lived 个除外）
+            while (live.size() > target) {
+                std::size_t i = long_lived + rng() % (live.size() - long_lived);
+                live[i] = std::move(live.back());
+                live.pop_back();
+            }
+            long rss = current_rss_kb() - heap_base;
+            (hour % 2 == 0 ? heap_peak : heap_trough) = rss;
+            heap_sum += rss;
+        }
+    }
+#if defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+
+    long arena_base = current_rss_kb();
+    long arena_peak = 0, arena_trough = 0;
+    long arena_sum = 0;
+    std::size_t moved = 0;
+    double compact_us = 0;
+    {
+        my_ptr::compacting_arena<Session> arena;
+        std::vector<my_ptr::slot_handle64> live;
+        for (int hour = 0; hour < hours; ++hour) {
+            std::size_t target = population(hour);
+            while (live.size() < target) {
+                live.push_back(arena.create(Session{static_cast<long>(live.size()), {}}));
+            }
+            while (live.size() > target) {
+                std::size_t i = long_lived + rng() % (live.size() - long_lived);
+                arena.destroy(live[i]);
+                live[i] = live.back();
+                live.pop_back();
+            }
+            // 每小时做一次增量整理
+            compact_us += time_us([&]() {
+                for (std::size_t n; (n = arena.compact_step(4096)) != 0;) moved += n;
+            });
+            long rss = current_rss_kb() - arena_base;
+            (hour % 2 == 0 ? arena_peak : arena_trough) = rss;
+            arena_sum += rss;
+        }
+    }
+
+    // 访问开销：pin 与直接解引用 shared_ptr
+    const std::size_t objects = 1000000;
+    long sp_sum = 0, pin_sum = 0;
+    double sp_us, pin_us;
+    {
+        std::vector<my_ptr::shared_ptr<Session>> ptrs;
+        my_ptr::compacting_arena<Session> arena;
+        std::vector<my_ptr::slot_handle64> handles;
+        for (std::size_t i = 0; i < objects; ++i) {
+            ptrs.push_back(my_ptr::make_shared<Session>(Session{static_cast<long>(i), {}}));
+            handles.push_back(arena.create(Session{static_cast<long>(i), {}}));
+        }
+        sp_us = time_us([&]() {
+            for (auto& p : ptrs) sp_sum += p->id;
+        });
+        pin_us = time_us([&]() {
+            for (auto h : handles) {
+                auto p = arena.pin(h);
+                pin_sum += p->id;
+            }
+        });
+    }
+
+    std::cout << "\ncompacting_arena churn (" << hours << " simulated hours, " << peak / 1000 << "k <-> " << trough / 1000
+              << "k objects of " << sizeof(Session) << " B):\n";
+    std::cout << "  make_shared heap: RSS at peak " << heap_peak / 1024 << " MB, at trough " << heap_trough / 1024
+              << " MB, mean " << heap_sum / hours / 1024 << " MB\n";
+    std::cout << "  compacting_arena: RSS at peak " << arena_peak / 1024 << " MB, at trough " << arena_trough / 1024
+              << " MB, mean " << arena_sum / hours / 1024 << " MB (" << moved << " moves, "
+              << compact_us / 1000 << " ms compacting)\n";
+    std::cout << "  access (" << objects / 1000000 << "M objects, checksum " << (sp_sum == pin_sum ? "match" : "DIFFER")
+              << "): shared_ptr deref " << sp_us * 1000 / objects << " ns, arena pin " << pin_us * 1000 / objects
+              << " ns\n";
+}
+
+void benchmark_skiplist_map() {
+    // 混合负载：80% get，各 7.5% put/remove，5% 扫描 16 个键的区间
+    const int key_space = 100000;
+    const int total_ops = 800000;
+    const int thread_counts[] = {1, 4, 16, 64};
+    struct Value {
+        long payload[4];
+    };
+
+    auto run = [&](int threads, auto&& get, auto&& put, auto&& remove, auto&& scan) {
+        return time_us([&]() {
+            std::vector<std::thread> workers;
+            for (int t = 0; t < threads; ++t) {
+                workers.emplace_back([&, t]() {
+                    std::mt19937 rng(t + 1);
+                    long sink = 0;
+                    for (int i = 0; i < total_ops / threads; ++i) {
+                        int k = static_cast<int>(rng() % key_space);
+                        unsigned op = rng() % 40;
+                        if (op < 32) {
+                            sink += get(k);
+                        } else if (op < 35) {
+                            put(k);
+                        } else if (op < 38) {
+                            remove(k);
+                        } else {
+                            sink += scan(k);
+                        }
+                    }
+                    if (sink == -1) std::cout << "";
+                });
+            }
+            for (auto& w : workers) w.join();
+        });
+    };
+
+    std::cout << "\nskiplist_map vs std::map + shared_mutex (" << key_space / 1000 << "k keys, " << total_ops / 1000
+              << "k ops, 80% get / 15% put+remove / 5% scan):\n";
+    for (int threads : thread_counts) {
+        my_ptr::skiplist_map<int, Value> skiplist;
+        std::map<int, my_ptr::shared_ptr<Value>> locked;
+        std::shared_mutex mutex;
+        for (int k = 0; k < key_space; k += 2) {
+            skiplist.put(k, my_ptr::make_shared<Value>());
+            locked.emplace(k, my_ptr::make_shared<Value>());
+        }
+
+        double skip_us = run(
+            threads,
+            [&](int k) { return skiplist.get(k) ? 1L : 0L; },
+            [&](int k) { skiplist.put(k, my_ptr::make_shared<Value>()); },
+            [&](int k) { skiplist.remove(k); },
+            [&](int k) {
+                return static_cast<long>(skiplist.scan(k, k + 16, [](int, const my_ptr::shared_ptr<Value>&) {}));
+            });
+        double lock_us = run(
+            threads,
+            [&](int k) {
+                my_ptr::shared_ptr<Value> v;
+                {
+                    std::shared_lock<std::shared_mutex> lock(mutex);
+                    auto it = locked.find(k);
+                    if (it != locked.end()) v = it->second;
+                }
+                return v ? 1L : 0L;
+            },
+            [&](int k) {
+                auto v = my_ptr::make_shared<Value>();
+                std::unique_lock<std::shared_mutex> lock(mutex);
+                locked[k] = std::move(v);
+            },
+            [&](int k) {
+                my_ptr::shared_ptr<Value> v; // 在锁外释放
+                std::unique_lock<std::shared_mutex> lock(mutex);
+                auto it = locked.find(k);
+                if (it != locked.end()) {
+                    v = std::move(it->second);
+                    locked.erase(it);
+                }
+            },
+            [&](int k) {
+                long n = 0;
+                std::shared_lock<std::shared_mutex> lock(mutex);
+                for (auto it = locked.lower_bound(k); it != locked.end() && it->first < k + 16; ++it) {
+                    my_ptr::shared_ptr<Value> v = it->second;
+                    ++n;
+                }
+                return n;
+            });
+        std::cout << "  " << threads << " threads: skiplist_map " << total_ops / skip_us << " M ops/s, std::map + lock "
+                  << total_ops / lock_us << " M ops/s\n";
+    }
+    my_ptr::detail::epoch_synchronize();
+}
+
+void benchmark_observer_list() {
+    // 10K 个监听者，每轮有 10% 失效、10% 新登记，每轮派发 20 个事件
+    const std::size_t listeners = 10000;
+    const int rounds = 50;
+    const int events_per_round = 20;
+    struct Listener {
+        long hits = 0;
+        void on_event(long e) { hits += e; }
+    };
+
+    auto churn = [&](std::vector<my_ptr::shared_ptr<Listener>>& owners, std::mt19937& rng,
+                     std::vector<my_ptr::shared_ptr<Listener>>& fresh) {
+        fresh.clear();
+        for (std::size_t i = 0; i < listeners / 10; ++i) {
+            std::size_t victim = rng() % owners.size();
+            owners[victim] = my_ptr::make_shared<Listener>();
+            fresh.push_back(owners[victim]);
+        }
+    };
+
+    double weak_us = 0, list_us = 0;
+    long weak_calls = 0, list_calls = 0;
+    std::size_t weak_size, list_size;
+    {
+        std::mt19937 rng(3);
+        std::vector<my_ptr::shared_ptr<Listener>> owners, fresh;
+        std::vector<my_ptr::weak_ptr<Listener>> weak;
+        std::mutex mutex;
+        for (std::size_t i = 0; i < listeners; ++i) {
+            owners.push_back(my_ptr::make_shared<Listener>());
+            weak.push_back(owners.back());
+        }
+        for (int r = 0; r < rounds; ++r) {
+            churn(owners, rng, fresh);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                weak.insert(weak.end(), fresh.begin(), fresh.end());
+            }
+            weak_us += time_us([&]() {
+                for (int e = 0; e < events_per_round; ++e) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    for (auto& w : weak) {
+                        if (auto l = w.lock()) {
+                            l->on_event(e);
+                            ++weak_calls;
+                        }
+                    }
+                }
+            });
+        }
+        weak_size = weak.size();
+    }
+    {
+        std::mt19937 rng(3);
+        std::vector<my_ptr::shared_ptr<Listener>> owners, fresh;
+        my_ptr::observer_list<Listener> list;
+        for (std::size_t i = 0; i < listeners; ++i) {
+            owners.push_back(my_ptr::make_shared<Listener>());
+        }
+        list.add(owners.begin(), owners.end());
+        for (int r = 0; r < rounds; ++r) {
+            churn(owners, rng, fresh);
+            list.add(fresh.begin(), fresh.end());
+            list_us += time_us([&]() {
+                for (int e = 0; e < events_per_round; ++e) {
+                    list_calls += static_cast<long>(list.dispatch([e](Listener& l) { l.on_event(e); }));
+                }
+            });
+        }
+        list_size = list.size();
+    }
+    my_ptr::detail::epoch_synchronize();
+
+    const int events = rounds * events_per_round;
+    std::cout << "\nobserver_list dispatch (" << listeners / 1000 << "K listeners, 10% churn per round, " << events
+              << " events; calls " << (weak_calls == list_calls ? "match" : "DIFFER") << "):\n";
+    std::cout << "  vector<weak_ptr> + lock(): " << weak_us / events << " μs/event, " << weak_size
+              << " entries at the end\n";
+    std::cout << "  my_ptr::observer_list: " << list_us / events << " μs/event, " << list_size
+              << " entries at the end\n";
+}
+
+void benchmark_bulk_weak() {
+    // 10M 个 weak_ptr，顺序打乱，使控制块的访问分散在整个堆上
+    const std::size_t count = 10000000;
+    const int live_percents[] = {100, 50, 10};
+
+    std::vector<my_ptr::shared_ptr<long>> owners;
+    std::vector<my_ptr::weak_ptr<long>> refs;
+    owners.reserve(count);
+    refs.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        owners.push_back(my_ptr::make_shared<long>(static_cast<long>(i)));
+    }
+    std::vector<std::uint32_t> order(count);
+    for (std::size_t i = 0; i < count; ++i) order[i] = static_cast<std::uint32_t>(i);
+    std::shuffle(order.begin(), order.end(), std::mt19937(11));
+    for (std::uint32_t i : order) {
+        refs.push_back(owners[i]);
+    }
+    std::vector<std::uint32_t>().swap(order);
+
+    std::cout << "\nbulk weak_ptr scan (" << count / 1000000 << "M shuffled weak_ptrs, best ISA "
+              << my_ptr::detail::bulk_isa_name(my_ptr::detail::detect_bulk_isa()) << "):\n";
+    int current = 100;
+    for (int percent : live_percents) {
+        // 逐步降低存活比例：按下标释放，与 refs 的打乱顺序无关
+        for (std::size_t i = 0; i < count; ++i) {
+            if (owners[i] && static_cast<int>(i % 100) >= percent && static_cast<int>(i % 100) < current) {
+                owners[i].reset();
+            }
+        }
+        current = percent;
+
+        std::size_t loop_expired = 0;
+        double loop_us = time_us([&]() {
+            for (const auto& r : refs) loop_expired += r.expired() ? 1 : 0;
+        });
+        std::cout << "  " << percent << "% live: expired() loop " << loop_us / 1000 << " ms";
+        for (auto isa : {my_ptr::detail::bulk_isa::scalar, my_ptr::detail::bulk_isa::avx2,
+                         my_ptr::detail::bulk_isa::avx512}) {
+            if (isa != my_ptr::detail::bulk_isa::scalar && isa > my_ptr::detail::detect_bulk_isa()) {
+                continue;
+            }
+            my_ptr::bitmap dead;
+            std::size_t expired = 0;
+            double us = time_us([&]() { expired = my_ptr::bulk_expired(refs, dead, isa); });
+            std::cout << ", bulk_expired/" << my_ptr::detail::bulk_isa_name(isa) << " " << us / 1000 << " ms"
+                      << (expired == loop_expired ? "" : " (MISMATCH)");
+        }
+        std::cout << "\n";
+
+        std::size_t loop_locked = 0, bulk_locked = 0;
+        std::vector<my_ptr::shared_ptr<long>> locked(count);
+        double lock_loop_us = time_us([&]() {
+            for (std::size_t i = 0; i < count; ++i) {
+                locked[i] = refs[i].lock();
+                loop_locked += locked[i] ? 1 : 0;
+            }
+        });
+        for (auto& l : locked) l.reset();
+        double bulk_lock_us = time_us([&]() { bulk_locked = my_ptr::bulk_lock(refs, locked); });
+        std::cout << "           lock() loop " << lock_loop_us / 1000 << " ms, bulk_lock " << bulk_lock_us / 1000
+                  << " ms" << (loop_locked == bulk_locked ? "" : " (MISMATCH)") << "\n";
+    }
+
+    // 控制块已在缓存中的情形：反复扫描 10K 个 weak_ptr（打乱顺序，一半存活）
+    const std::size_t hot = 10000;
+    const int scans = 1000;
+    std::vector<my_ptr::shared_ptr<long>> hot_owners;
+    for (std::size_t i = 0; i < hot; ++i) {
+        hot_owners.push_back(my_ptr::make_shared<long>(static_cast<long>(i)));
+    }
+    std::shuffle(hot_owners.begin(), hot_owners.end(), std::mt19937(12));
+    std::vector<my_ptr::weak_ptr<long>> hot_refs(hot_owners.begin(), hot_owners.end());
+    for (std::size_t i = 0; i < hot; i += 2) {
+        hot_owners[i].reset();
+    }
+    std::size_t sink = 0;
+    double hot_loop_us = time_us([&]() {
+        for (int r = 0; r < scans; ++r) {
+            for (const auto& w : hot_refs) sink += w.expired() ? 1 : 0;
+        }
+    });
+    std::cout << "  hot 10K x " << scans << " scans (50% live): expired() loop " << hot_loop_us / 1000
+              << " ms";
+    for (auto isa : {my_ptr::detail::bulk_isa::scalar, my_ptr::detail::bulk_isa::avx2,
+                     my_ptr::detail::bulk_isa::avx512}) {
+        if (isa != my_ptr::detail::bulk_isa::scalar && isa > my_ptr::detail::detect_bulk_isa()) {
+            continue;
+        }
+        my_ptr::bitmap dead;
+        double us = time_us([&]() {
+            for (int r = 0; r < scans; ++r) sink += my_ptr::bulk_expired(hot_refs, dead, isa);
+        });
+        std::cout << ", bulk_expired/" << my_ptr::detail::bulk_isa_name(isa) << " " << us / 1000 << " ms";
+    }
+    std::cout << (sink == 0 ? " " : "") << "\n";
+}
+
+// 深继承层次：CastLevel<N> 继承 CastLevel<N-1>，叶子类再多继承一个带虚函数的 CastTraced，
+// 使目标子对象与源子对象的偏移不为 0
+struct CastMsg {
+    virtual ~CastMsg() = default;
+    long payload = 0;
+};
+template <int N>
+struct CastLevel : CastLevel<N - 1> {
+    long level_data = N;
+};
+template <>
+struct CastLevel<0> : CastMsg {};
+struct CastTraced {
+    virtual ~CastTraced() = default;
+    long trace_id = 0;
+};
+template <int Kind>
+struct CastLeaf : CastTraced, CastLevel<8> {
+    long kind = Kind;
+};
+
+void benchmark_pointer_cast() {
+    // 路由循环：对每条消息依次尝试转换到 4 种叶子类型，命中即处理
+    const std::size_t count = 4096;
+    const int rounds = 500;
+    std::vector<my_ptr::shared_ptr<CastMsg>> msgs;
+    std::mt19937 rng(13);
+    for (std::size_t i = 0; i < count; ++i) {
+        switch (rng() % 4) {
+        case 0: msgs.push_back(my_ptr::make_shared<CastLeaf<0>>()); break;
+        case 1: msgs.push_back(my_ptr::make_shared<CastLeaf<1>>()); break;
+        case 2: msgs.push_back(my_ptr::make_shared<CastLeaf<2>>()); break;
+        default: msgs.push_back(my_ptr::make_shared<CastLeaf<3>>());
+        }
+    }
+    const double casts = static_cast<double>(count) * rounds;
+
+    long sink = 0;
+    double raw_us = time_us([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            for (const auto& m : msgs) {
+                CastMsg *p = m.get();
+                if (auto *a = dynamic_cast<CastLeaf<0>*>(p)) sink += a->kind;
+                else if (auto *b = dynamic_cast<CastLeaf<1>*>(p)) sink += b->kind;
+                else if (auto *c = dynamic_cast<CastLeaf<2>*>(p)) sink += c->kind;
+                else if (auto *d = dynamic_cast<CastLeaf<3>*>(p)) sink += d->kind;
+            }
+        }
+    });
+    double raw_cached_us = time_us([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            for (const auto& m : msgs) {
+                CastMsg *p = m.get();
+                if (auto *a = my_ptr::cached_dynamic_cast<CastLeaf<0>>(p)) sink += a->kind;
+                else if (auto *b = my_ptr::cached_dynamic_cast<CastLeaf<1>>(p)) sink += b->kind;
+                else if (auto *c = my_ptr::cached_dynamic_cast<CastLeaf<2>>(p)) sink += c->kind;
+                else if (auto *d = my_ptr::cached_dynamic_cast<CastLeaf<3>>(p)) sink += d->kind;
+            }
+        }
+    });
+    double sp_us = time_us([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            for (const auto& m : msgs) {
+                if (auto a = my_ptr::dynamic_pointer_cast<CastLeaf<0>>(m)) sink += a->kind;
+                else if (auto b = my_ptr::dynamic_pointer_cast<CastLeaf<1>>(m)) sink += b->kind;
+                else if (auto c = my_ptr::dynamic_pointer_cast<CastLeaf<2>>(m)) sink += c->kind;
+                else if (auto d = my_ptr::dynamic_pointer_cast<CastLeaf<3>>(m)) sink += d->kind;
+            }
+        }
+    });
+    double sp_cached_us = time_us([&]() {
+        for (int r = 0; r < rounds; ++r) {
+            for (const auto& m : msgs) {
+                if (auto a = my_ptr::cached_dynamic_pointer_cast<CastLeaf<0>>(m)) sink += a->kind;
+                else if (auto b = my_ptr::cached_dynamic_pointer_cast<CastLeaf<1>>(m)) sink += b->kind;
+                else if (auto c = my_ptr::cached_dynamic_pointer_cast<CastLeaf<2>>(m)) sink += c->kind;
+                else if (auto d = my_ptr::cached_dynamic_pointer_cast<CastLeaf<3>>(m)) sink += d->kind;
+            }
+        }
+    });
+    // 右值版本：消息被移交给处理者，转换不产生计数操作；队列预先复制好，不计入时间
+    std::vector<my_ptr::shared_ptr<CastMsg>> queue;
+    queue.reserve(count * rounds);
+    for (int r = 0; r < rounds; ++r) {
+        queue.insert(queue.end(), msgs.begin(), msgs.end());
+    }
+    double sp_move_us = time_us([&]() {
+        for (auto& m : queue) {
+            if (auto a = my_ptr::cached_dynamic_pointer_cast<CastLeaf<0>>(std::move(m))) sink += a->kind;
+            else if (auto b = my_ptr::cached_dynamic_pointer_cast<CastLeaf<1>>(std::move(m))) sink += b->kind;
+            else if (auto c = my_ptr::cached_dynamic_pointer_cast<CastLeaf<2>>(std::move(m))) sink += c->kind;
+            else if (auto d = my_ptr::cached_dynamic_pointer_cast<CastLeaf<3>>(std::move(m))) sink += d->kind;
+        }
+    });
+
+    std::cout << "\npointer cast router (" << count << " msgs, 4 leaf types at depth 9, " << rounds << " rounds):\n";
+    std::cout << "  dynamic_cast " << raw_us * 1000 / casts << " ns/msg, cached_dynamic_cast "
+              << raw_cached_us * 1000 / casts << " ns/msg\n";
+    std::cout << "  dynamic_pointer_cast " << sp_us * 1000 / casts << " ns/msg, cached_dynamic_pointer_cast "
+              << sp_cached_us * 1000 / casts << " ns/msg, rvalue " << sp_move_us * 1000 / casts << " ns/msg"
+              << (sink == 0 ? " " : "") << "\n";
+}
+
 int main() {
     std::cout << "C++ Smart Pointer Performance Benchmark\n";
     std::cout << "=======================================\n";
@@ -121,6 +1877,31 @@ int main() {
     benchmark_unique_ptr();
     benchmark_shared_ptr();
     test_thread_safety();
+    benchmark_ptr_vector();
+    benchmark_teardown();
+    benchmark_parallel_release();
+    benchmark_wait_wakeup();
+    benchmark_immortal_copy();
+    benchmark_ownership_queue();
+    benchmark_spsc_pipeline();
+    benchmark_lru_cache();
+    benchmark_intern_pool();
+    benchmark_shared_buffer();
+    benchmark_map_file();
+    benchmark_chunk_reader();
+    benchmark_buffer_chain();
+    benchmark_serialization();
+    benchmark_snapshot();
+    benchmark_weighted_fanout();
+    benchmark_deferred_graph();
+    benchmark_async_dispose();
+    benchmark_foreign_ptr();
+    benchmark_slot_map();
+    benchmark_compacting_arena();
+    benchmark_skiplist_map();
+    benchmark_observer_list();
+    benchmark_bulk_weak();
+    benchmark_pointer_cast();
     
     // 基本功能测试
     std::cout << "\nBasic functionality tests:\n";
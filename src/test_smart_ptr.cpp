@@ -1,4 +1,11 @@
 #include "../include/memory.hpp"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <deque>
+#include <array>
+#include <random>
 
 // ============================================================================
 // 测试辅助宏
@@ -10,7 +17,7 @@
 // ============================================================================
 struct TestClass {
     int value;
-    static int instance_count;
+    static std::atomic<int> instance_count; // 多线程测试中也会并发构造/析构
 
     explicit TestClass(int v = 0) : value(v) {
         ++instance_count;
@@ -29,7 +36,7 @@ struct TestClass {
     }
 };
 
-int TestClass::instance_count = 0;
+std::atomic<int> TestClass::instance_count{0};
 
 struct CustomDeleter {
     void operator()(TestClass* p) const {
@@ -64,6 +71,58 @@ bool test_weak_ptr_multiple();
 bool test_integration_shared_weak();
 bool test_integration_containers();
 
+bool test_ptr_vector_basics();
+bool test_ptr_vector_arena();
+
+bool test_teardown_shared_chain();
+bool test_teardown_unique_chain();
+bool test_teardown_tree();
+
+bool test_parallel_release_tree();
+bool test_parallel_release_shared_root();
+
+bool test_wait_for_unique();
+bool test_wait_until_expired();
+bool test_wait_timeout();
+bool test_wait_release_race();
+
+bool test_immortal_shared();
+bool test_adopt_static();
+
+bool test_ownership_queue_basics();
+bool test_ownership_queue_mpmc();
+
+bool test_spsc_ring_basics();
+bool test_spsc_ring_pipeline();
+
+bool test_lru_cache_basics();
+bool test_lru_cache_clock_eviction();
+bool test_intern_pool_basics();
+bool test_intern_pool_concurrent();
+bool test_aliasing_constructor();
+bool test_shared_buffer_slices();
+bool test_map_file();
+bool test_chunk_reader();
+bool test_buffer_chain();
+bool test_serialization_graph();
+bool test_serialization_deep_and_errors();
+bool test_serialization_views();
+bool test_offset_ptr();
+bool test_snapshot_roundtrip();
+bool test_weighted_shared_ptr();
+bool test_deferred_shared_ptr();
+bool test_deferred_rc_threads();
+bool test_async_shared_ptr();
+bool test_foreign_ptr();
+bool test_foreign_ptr_shards();
+bool test_slot_map();
+bool test_compacting_arena();
+bool test_skiplist_map();
+bool test_skiplist_map_concurrent();
+bool test_observer_list();
+bool test_bulk_weak();
+bool test_pointer_casts();
+
 // ============================================================================
 // main 函数
 // ============================================================================
@@ -107,6 +166,73 @@ int main() {
     run_test("shared_ptr and weak_ptr interaction", test_integration_shared_weak);
     run_test("smart pointers in containers", test_integration_containers);
 
+    run_test("ptr_vector basics", test_ptr_vector_basics);
+    run_test("ptr_vector arena", test_ptr_vector_arena);
+
+    run_test("iterative teardown of shared_ptr chain", test_teardown_shared_chain);
+    run_test("iterative teardown of unique_ptr chain", test_teardown_unique_chain);
+    run_test("iterative teardown of tree", test_teardown_tree);
+
+    run_test("parallel release of tree", test_parallel_release_tree);
+    run_test("parallel release of shared root", test_parallel_release_shared_root);
+
+    run_test("shared_ptr wait_for_unique", test_wait_for_unique);
+    run_test("weak_ptr wait_until_expired", test_wait_until_expired);
+    run_test("blocking waits with timeout", test_wait_timeout);
+    run_test("waiter drops the block right after waking", test_wait_release_race);
+
+    run_test("make_immortal_shared", test_immortal_shared);
+    run_test("adopt_static", test_adopt_static);
+
+    run_test("ownership_queue basics", test_ownership_queue_basics);
+    run_test("ownership_queue multi-producer multi-consumer", test_ownership_queue_mpmc);
+
+    run_test("spsc_ring basics", test_spsc_ring_basics);
+    run_test("spsc_ring pipeline", test_spsc_ring_pipeline);
+
+    run_test("lru_cache basics", test_lru_cache_basics);
+    run_test("lru_cache CLOCK eviction", test_lru_cache_clock_eviction);
+
+    run_test("intern_pool basics", test_intern_pool_basics);
+    run_test("intern_pool concurrent", test_intern_pool_concurrent);
+
+    run_test("shared_ptr aliasing constructor", test_aliasing_constructor);
+    run_test("shared_buffer slices", test_shared_buffer_slices);
+
+    run_test("map_file", test_map_file);
+    run_test("chunk_reader", test_chunk_reader);
+    run_test("buffer_chain", test_buffer_chain);
+
+    run_test("serialization of a shared graph", test_serialization_graph);
+    run_test("serialization of deep chains and bad input", test_serialization_deep_and_errors);
+    run_test("serialization of aliasing and base-typed views", test_serialization_views);
+
+    run_test("offset_ptr", test_offset_ptr);
+    run_test("snapshot roundtrip", test_snapshot_roundtrip);
+
+    run_test("weighted_shared_ptr", test_weighted_shared_ptr);
+
+    run_test("deferred_shared_ptr", test_deferred_shared_ptr);
+    run_test("deferred reference counting across threads", test_deferred_rc_threads);
+
+    run_test("async_shared_ptr", test_async_shared_ptr);
+
+    run_test("foreign_ptr", test_foreign_ptr);
+    run_test("foreign_ptr across shards", test_foreign_ptr_shards);
+
+    run_test("slot_map", test_slot_map);
+
+    run_test("compacting_arena", test_compacting_arena);
+
+    run_test("skiplist_map", test_skiplist_map);
+    run_test("skiplist_map concurrent", test_skiplist_map_concurrent);
+
+    run_test("observer_list", test_observer_list);
+
+    run_test("bulk weak_ptr ops", test_bulk_weak);
+
+    run_test("pointer casts", test_pointer_casts);
+
     std::cout << "\n\n----------------------------------------------------------------------------\n";
     if (all_tests_passed) {
         std::cout << "All tests passed successfully!\n";
@@ -542,3 +668,2445 @@ bool test_integration_containers() {
     std::cout << "success! smart pointers in containers\n";
     return true;
 }
+
+// ============================================================================
+// ptr_vector 测试
+// ============================================================================
+bool test_ptr_vector_basics() {
+    TEST_SECTION("ptr_vector basics");
+    {
+        my_ptr::ptr_vector<TestClass> vec;
+        for (int i = 0; i < 10; ++i) {
+            vec.push_back(my_ptr::make_unique<TestClass>(i));
+        }
+        vec.emplace_back(10);
+        assert(vec.size() == 11);
+        assert(TestClass::instance_count == 11);
+        assert(vec[3].value == 3);
+        assert(vec.back().value == 10);
+
+        int sum = 0;
+        for (const auto& obj : vec) {
+            sum += obj.value;
+        }
+        assert(sum == 55);
+
+        auto released = vec.release(vec.begin() + 2);
+        assert(released->value == 2);
+        assert(vec.size() == 10);
+        assert(vec[2].value == 3);
+        assert(TestClass::instance_count == 11);
+
+        vec.erase(vec.begin(), vec.begin() + 3);
+        assert(vec.size() == 7);
+        assert(vec.front().value == 4);
+        assert(TestClass::instance_count == 8);
+
+        auto last = vec.pop_back();
+        assert(last->value == 10);
+
+        my_ptr::ptr_vector<TestClass> moved(std::move(vec));
+        assert(vec.empty());
+        assert(moved.size() == 6);
+
+        moved.clear();
+        assert(moved.empty());
+        assert(TestClass::instance_count == 2);
+    }
+    {
+        // 逐个追加时容量按几何级数增长
+        my_ptr::ptr_vector<TestClass> vec;
+        int reallocations = 0;
+        for (int i = 0; i < 100000; ++i) {
+            std::size_t cap = vec.capacity();
+            if (i % 2) {
+                vec.emplace_back(i);
+            } else {
+                vec.push_back(my_ptr::make_unique<TestClass>(i));
+            }
+            reallocations += vec.capacity() != cap ? 1 : 0;
+        }
+        assert(reallocations < 20);
+        assert(vec[99999].value == 99999);
+    }
+    assert(TestClass::instance_count == 0);
+    std::cout << "success! ptr_vector basics\n";
+    return true;
+}
+
+bool test_ptr_vector_arena() {
+    TEST_SECTION("ptr_vector with arena allocation");
+    {
+        my_ptr::ptr_vector<TestClass, my_ptr::arena_delete<TestClass>> vec;
+        for (int i = 0; i < 1000; ++i) {
+            vec.emplace_back(i);
+        }
+        assert(TestClass::instance_count == 1000);
+        assert(vec[999].value == 999);
+
+        vec.erase(vec.begin() + 500);
+        assert(TestClass::instance_count == 999);
+        assert(vec[500].value == 501);
+
+        vec.clear();
+        assert(TestClass::instance_count == 0);
+
+        vec.emplace_back(7);
+        assert(vec[0].value == 7);
+    }
+    assert(TestClass::instance_count == 0);
+    std::cout << "success! ptr_vector arena\n";
+    return true;
+}
+
+// ============================================================================
+// 迭代式析构测试
+// ============================================================================
+struct SharedNode {
+    TestClass payload;
+    my_ptr::shared_ptr<SharedNode> next;
+    explicit SharedNode(int v) : payload(v) {}
+};
+
+struct UniqueNode {
+    TestClass payload;
+    my_ptr::unique_ptr<UniqueNode, my_ptr::iterative_delete<UniqueNode>> next;
+    explicit UniqueNode(int v) : payload(v) {}
+};
+
+struct TreeNode {
+    TestClass payload;
+    my_ptr::shared_ptr<TreeNode> left;
+    my_ptr::shared_ptr<TreeNode> right;
+    explicit TreeNode(int v) : payload(v) {}
+};
+
+// 子节点析构时经裸指针回访父节点；记录自己的析构在何时结束
+struct BackRefParent {
+    struct done_marker {
+        int id;
+        std::vector<int>& log;
+        ~done_marker() { log.push_back(id); }
+    };
+
+    done_marker marker; // 最后析构：记录本节点析构结束
+    int id;
+    BackRefParent *parent = nullptr;
+    my_ptr::shared_ptr<BackRefParent> child;
+
+    BackRefParent(int i, std::vector<int>& log) : marker{i, log}, id(i) {}
+    ~BackRefParent() {
+        if (parent) {
+            assert(parent->id == id - 1); // 父节点仍未析构完成
+        }
+    }
+};
+
+bool test_teardown_shared_chain() {
+    TEST_SECTION("iterative teardown of a long shared_ptr chain");
+    const int length = 1000000;
+    {
+        auto head = my_ptr::make_shared<SharedNode>(0);
+        auto *tail = head.get();
+        for (int i = 1; i < length; ++i) {
+            tail->next = my_ptr::make_shared<SharedNode>(i);
+            tail = tail->next.get();
+        }
+        assert(TestClass::instance_count == length);
+
+        my_ptr::weak_ptr<SharedNode> middle;
+        {
+            auto *p = head.get();
+            for (int i = 0; i < length / 2; ++i) p = p->next.get();
+            middle = p->next;
+        }
+        head.reset();
+        assert(middle.expired());
+        assert(TestClass::instance_count == 0);
+    }
+    assert(TestClass::instance_count == 0);
+    std::cout << "success! shared_ptr chain teardown\n";
+    return true;
+}
+
+bool test_teardown_unique_chain() {
+    TEST_SECTION("iterative teardown of a long unique_ptr chain");
+    const int length = 1000000;
+    {
+        my_ptr::unique_ptr<UniqueNode, my_ptr::iterative_delete<UniqueNode>> head(new UniqueNode(0));
+        auto *tail = head.get();
+        for (int i = 1; i < length; ++i) {
+            tail->next.reset(new UniqueNode(i));
+            tail = tail->next.get();
+        }
+        assert(TestClass::instance_count == length);
+        head.reset();
+        assert(TestClass::instance_count == 0);
+    }
+    assert(TestClass::instance_count == 0);
+    std::cout << "success! unique_ptr chain teardown\n";
+    return true;
+}
+
+bool test_teardown_tree() {
+    TEST_SECTION("iterative teardown of a tree with shared subtrees");
+    {
+        // 左子树深链 + 右子树共享节点，共享节点只能释放一次
+        auto shared_leaf = my_ptr::make_shared<TreeNode>(-1);
+        auto root = my_ptr::make_shared<TreeNode>(0);
+        auto *cur = root.get();
+        for (int i = 1; i < 200000; ++i) {
+            cur->left = my_ptr::make_shared<TreeNode>(i);
+            cur->right = shared_leaf;
+            cur = cur->left.get();
+        }
+        assert(shared_leaf.use_count() == 200000);
+        shared_leaf.reset();
+        root.reset();
+        assert(TestClass::instance_count == 0);
+    }
+    assert(TestClass::instance_count == 0);
+    {
+        // 浅层级联保持普通的析构顺序：子对象在父对象析构期间销毁，可以经裸指针回访父对象
+        std::vector<int> log;
+        {
+            auto top = my_ptr::make_shared<BackRefParent>(0, log);
+            BackRefParent *cur = top.get();
+            for (int i = 1; i < 10; ++i) {
+                cur->child = my_ptr::make_shared<BackRefParent>(i, log);
+                cur->child->parent = cur;
+                cur = cur->child.get();
+            }
+        }
+        // 每个节点的子节点都先于它的析构结束：记录顺序自底向上
+        assert(log.size() == 10);
+        for (int i = 0; i < 10; ++i) {
+            assert(log[i] == 9 - i);
+        }
+    }
+    std::cout << "success! tree teardown\n";
+    return true;
+}
+
+// ============================================================================
+// 并行释放测试
+// ============================================================================
+my_ptr::shared_ptr<TreeNode> build_test_tree(int depth) {
+    auto node = my_ptr::make_shared<TreeNode>(depth);
+    if (depth > 0) {
+        node->left = build_test_tree(depth - 1);
+        node->right = build_test_tree(depth - 1);
+    }
+    return node;
+}
+
+bool test_parallel_release_tree() {
+    TEST_SECTION("parallel_release of a tree");
+    {
+        my_ptr::thread_pool pool(4);
+        auto root = build_test_tree(14);
+        assert(TestClass::instance_count == (1 << 15) - 1);
+
+        my_ptr::weak_ptr<TreeNode> leaf_parent = root->left->left;
+        auto handle = my_ptr::parallel_release(std::move(root), pool, 8);
+        assert(!root);
+        handle.wait();
+        assert(handle.done());
+        assert(leaf_parent.expired());
+        assert(TestClass::instance_count == 0);
+    }
+    assert(TestClass::instance_count == 0);
+    std::cout << "success! parallel_release tree\n";
+    return true;
+}
+
+bool test_parallel_release_shared_root() {
+    TEST_SECTION("parallel_release of a root that is still referenced");
+    {
+        my_ptr::thread_pool pool(2);
+        auto root = build_test_tree(4);
+        auto keep = root;
+        auto handle = my_ptr::parallel_release(std::move(root), pool);
+        handle.wait();
+        assert(keep.use_count() == 1);
+        assert(TestClass::instance_count == (1 << 5) - 1);
+    }
+    assert(TestClass::instance_count == 0);
+    std::cout << "success! parallel_release shared root\n";
+    return true;
+}
+
+// ============================================================================
+// 阻塞等待测试
+// ============================================================================
+bool test_wait_for_unique() {
+    TEST_SECTION("shared_ptr wait_for_unique");
+    {
+        auto owner = my_ptr::make_shared<TestClass>(400);
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 4; ++t) {
+            readers.emplace_back([copy = owner]() mutable {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                copy.reset();
+            });
+        }
+        owner.wait_for_unique();
+        assert(owner.unique());
+        for (auto& t : readers) {
+            t.join();
+        }
+
+        // 已经唯一时立即返回
+        owner.wait_for_unique();
+        assert(owner.use_count() == 1);
+    }
+    assert(TestClass::instance_count == 0);
+    std::cout << "success! wait_for_unique\n";
+    return true;
+}
+
+bool test_wait_until_expired() {
+    TEST_SECTION("weak_ptr wait_until_expired");
+    {
+        std::atomic<bool> destroyed{false};
+        struct Flagged {
+            std::atomic<bool>& flag;
+            explicit Flagged(std::atomic<bool>& f) : flag(f) {}
+            ~Flagged() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                flag.store(true);
+            }
+        };
+
+        auto sp = my_ptr::make_shared<Flagged>(destroyed);
+        my_ptr::weak_ptr<Flagged> wp(sp);
+        std::thread reader([copy = std::move(sp)]() mutable {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            copy.reset();
+        });
+        wp.wait_until_expired();
+        // 返回时析构函数必须已经执行完毕
+        assert(destroyed.load());
+        assert(wp.expired());
+        reader.join();
+
+        // 已经过期时立即返回
+        wp.wait_until_expired();
+    }
+    std::cout << "success! wait_until_expired\n";
+    return true;
+}
+
+bool test_wait_timeout() {
+    TEST_SECTION("blocking waits with timeout");
+    {
+        auto sp = my_ptr::make_shared<TestClass>(410);
+        auto copy = sp;
+        assert(!sp.wait_for_unique_for(std::chrono::milliseconds(2)));
+
+        my_ptr::weak_ptr<TestClass> wp(sp);
+        assert(!wp.wait_until_expired_for(std::chrono::milliseconds(2)));
+
+        copy.reset();
+        assert(sp.wait_for_unique_for(std::chrono::milliseconds(2)));
+        sp.reset();
+        assert(wp.wait_until_expired_for(std::chrono::milliseconds(2)));
+        assert(sp.wait_for_unique_for(std::chrono::seconds(1)));
+    }
+    assert(TestClass::instance_count == 0);
+    std::cout << "success! waits with timeout\n";
+    return true;
+}
+
+// 被唤醒的等待者立刻释放最后的引用，释放者随后的唤醒不能再触及控制块
+bool test_wait_release_race() {
+    TEST_SECTION("waiter drops the block right after waking");
+    for (int i = 0; i < 2000; ++i) {
+        auto owner = my_ptr::make_shared<TestClass>(i);
+        std::thread releaser([copy = owner]() mutable { copy.reset(); });
+        owner.wait_for_unique();
+        owner.reset();
+        releaser.join();
+    }
+    for (int i = 0; i < 2000; ++i) {
+        auto sp = my_ptr::make_shared<TestClass>(i);
+        my_ptr::weak_ptr<TestClass> wp(sp);
+        std::thread releaser([copy = std::move(sp)]() mutable { copy.reset(); });
+        wp.wait_until_expired();
+        wp.reset();
+        releaser.join();
+    }
+    assert(TestClass::instance_count == 0);
+    std::cout << "success! wait release race\n";
+    return true;
+}
+
+// ============================================================================
+// 永生对象测试
+// ============================================================================
+bool test_immortal_shared() {
+    TEST_SECTION("make_immortal_shared");
+    // 永生标记放在计数字里，控制块仍是虚表指针加两个计数字
+    static_assert(sizeof(my_ptr::detail::control_block_base) == sizeof(void*) + 2 * sizeof(std::uint64_t), "");
+    {
+        auto sp = my_ptr::make_immortal_shared<std::string>("constant");
+        long before = sp.use_count();
+        {
+            auto copy1 = sp;
+            auto copy2 = copy1;
+            assert(*copy2 == "constant");
+            assert(sp.use_count() == before);
+        }
+        assert(sp.use_count() == before);
+        assert(!sp.unique());
+
+        my_ptr::weak_ptr<std::string> wp(sp);
+        sp.reset();
+        assert(!wp.expired());
+        auto locked = wp.lock();
+        assert(locked && *locked == "constant");
+        assert(!locked.wait_for_unique_for(std::chrono::milliseconds(1)));
+    }
+    std::cout << "success! make_immortal_shared\n";
+    return true;
+}
+
+bool test_adopt_static() {
+    TEST_SECTION("adopt_static");
+    {
+        static std::string singleton("global");
+        static const int answer = 42;
+
+        auto a = my_ptr::adopt_static(singleton);
+        auto b = my_ptr::adopt_static(answer);
+        assert(*a == "global");
+        assert(*b == 42);
+        {
+            std::vector<my_ptr::shared_ptr<std::string>> copies(100, a);
+            assert(copies.back().get() == &singleton);
+        }
+        my_ptr::weak_ptr<std::string> wp(a);
+        a.reset();
+        assert(!wp.expired());
+        assert(singleton == "global");
+    }
+    std::cout << "success! adopt_static\n";
+    return true;
+}
+
+// ============================================================================
+// ownership_queue 测试
+// ============================================================================
+bool test_ownership_queue_basics() {
+    TEST_SECTION("ownership_queue basics");
+    {
+        my_ptr::ownership_queue<my_ptr::shared_ptr<TestClass>> q(3);
+        assert(q.capacity() == 4);
+
+        auto sp = my_ptr::make_shared<TestClass>(600);
+        auto copy = sp;
+        assert(q.try_push(std::move(copy)));
+        assert(!copy);
+        assert(sp.use_count() == 2);
+
+        for (int i = 0; i < 3; ++i) {
+            assert(q.try_push(my_ptr::make_shared<TestClass>(i)));
+        }
+        auto extra = my_ptr::make_shared<TestClass>(99);
+        assert(!q.try_push(std::move(extra)));
+        assert(extra && extra->value == 99);
+
+        my_ptr::shared_ptr<TestClass> out;
+        assert(q.try_pop(out));
+        assert(out == sp);
+        assert(sp.use_count() == 2);
+
+        my_ptr::ownership_queue<my_ptr::unique_ptr<TestClass>> uq(8);
+        assert(uq.try_push(my_ptr::make_unique<TestClass>(610)));
+        my_ptr::unique_ptr<TestClass> uout;
+        assert(uq.try_pop(uout));
+        assert(uout->value == 610);
+        assert(!uq.try_pop(uout));
+        assert(uout);
+
+        // 队列析构时释放剩余元素
+        assert(uq.try_push(my_ptr::make_unique<TestClass>(611)));
+    }
+    assert(TestClass::instance_count == 0);
+    std::cout << "success! ownership_queue basics\n";
+    return true;
+}
+
+bool test_ownership_queue_mpmc() {
+    TEST_SECTION("ownership_queue multi-producer multi-consumer");
+    {
+        const int producers = 3;
+        const int consumers = 3;
+        const int per_producer = 20000;
+        my_ptr::ownership_queue<my_ptr::unique_ptr<TestClass>> q(64);
+        std::atomic<long long> sum{0};
+        std::atomic<int> consumed{0};
+
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&q, p, per_producer]() {
+                for (int i = 0; i < per_producer; ++i) {
+                    auto item = my_ptr::make_unique<TestClass>(p * per_producer + i);
+                    while (!q.try_push(std::move(item))) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (int c = 0; c < consumers; ++c) {
+            threads.emplace_back([&]() {
+                my_ptr::unique_ptr<TestClass> item;
+                while (consumed.load() < producers * per_producer) {
+                    if (q.try_pop(item)) {
+                        sum += item->value;
+                        item.reset();
+                        ++consumed;
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        long long n = producers * per_producer;
+        assert(sum.load() == n * (n - 1) / 2);
+    }
+    assert(TestClass::instance_count == 0);
+    std::cout << "success! ownership_queue mpmc\n";
+    return true;
+}
+
+// ============================================================================
+// spsc_ring 测试
+// ============================================================================
+bool test_spsc_ring_basics() {
+    TEST_SECTION("spsc_ring basics");
+    {
+        my_ptr::spsc_ring<TestClass> ring(4);
+        assert(ring.capacity() == 4);
+
+        for (int i = 0; i < 4; ++i) {
+            assert(ring.try_push(my_ptr::make_unique<TestClass>(i)));
+        }
+        auto extra = my_ptr::make_unique<TestClass>(4);
+        assert(!ring.try_push(std::move(extra)));
+        assert(extra);
+
+        my_ptr::unique_ptr<TestClass> out;
+        assert(ring.try_pop(out));
+        assert(out->value == 0);
+        assert(ring.try_push(std::move(extra)));
+
+        my_ptr::unique_ptr<TestClass> batch[8];
+        std::size_t n = ring.pop_batch(batch, 8);
+        assert(n == 4);
+        for (std::size_t i = 0; i < n; ++i) {
+            assert(batch[i]->value == static_cast<int>(i) + 1);
+        }
+        assert(!ring.try_pop(out));
+
+        my_ptr::unique_ptr<TestClass> in[6];
+        for (int i = 0; i < 6; ++i) {
+            in[i] = my_ptr::make_unique<TestClass>(10 + i);
+        }
+        assert(ring.push_batch(in, 6) == 4);
+        assert(!in[3] && in[4] && in[5]);
+        // 析构时回收未消费的元素
+    }
+    assert(TestClass::instance_count == 0);
+    std::cout << "success! spsc_ring basics\n";
+    return true;
+}
+
+bool test_spsc_ring_pipeline() {
+    TEST_SECTION("spsc_ring two-stage pipeline");
+    {
+        const int count = 50000;
+        my_ptr::spsc_ring<TestClass, my_ptr::detail::default_delete<TestClass>, my_ptr::futex_wait_strategy> ring(64);
+        long long sum = 0;
+
+        std::thread consumer([&]() {
+            my_ptr::unique_ptr<TestClass> item;
+            while (ring.pop(item)) {
+                sum += item->value;
+            }
+        });
+        for (int i = 0; i < count; ++i) {
+            bool ok = ring.push(my_ptr::make_unique<TestClass>(i));
+            assert(ok);
+            (void)ok;
+        }
+        ring.close();
+        consumer.join();
+        assert(sum == static_cast<long long>(count) * (count - 1) / 2);
+    }
+    assert(TestClass::instance_count == 0);
+    std::cout << "success! spsc_ring pipeline\n";
+    return true;
+}
+
+// ============================================================================
+// lru_cache 测试
+// ============================================================================
+bool test_lru_cache_basics() {
+    TEST_SECTION("lru_cache basics");
+    {
+        my_ptr::lru_cache<int, TestClass> cache(sizeof(TestClass) * 64, 4);
+        assert(cache.shard_count() == 4);
+
+        cache.put(1, my_ptr::make_shared<TestClass>(700));
+        auto hit = cache.get(1);
+        assert(hit && hit->value == 700);
+        assert(!cache.get(2));
+        assert(cache.size() == 1);
+        assert(cache.bytes() == sizeof(TestClass));
+
+        // 替换后旧值仍由调用者持有
+        cache.put(1, my_ptr::make_shared<TestClass>(701), 10);
+        assert(hit->value == 700);
+        assert(cache.get(1)->value == 701);
+        assert(cache.bytes() == 10);
+
+        assert(cache.erase(1));
+        assert(!cache.erase(1));
+        assert(!cache.get(1));
+        assert(cache.bytes() == 0);
+
+        for (int i = 0; i < 10; ++i) {
+            cache.put(i, my_ptr::make_shared<TestClass>(i));
+        }
+        cache.clear();
+        assert(cache.size() == 0);
+        hit.reset();
+    }
+    {
+        // 容量小于分片数：分片数随之减少，分片容量不会被除成 0
+        my_ptr::lru_cache<int, TestClass> tiny(3, 16);
+        assert(tiny.shard_count() == 2);
+        tiny.put(0, my_ptr::make_shared<TestClass>(0), 1);
+        assert(tiny.get(0));
+        for (int i = 1; i < 8; ++i) {
+            tiny.put(i, my_ptr::make_shared<TestClass>(i), 1);
+        }
+        assert(tiny.bytes() <= 3 && tiny.size() >= 2);
+    }
+    assert(TestClass::instance_count == 0);
+    std::cout << "success! lru_cache basics\n";
+    return true;
+}
+
+bool test_lru_cache_clock_eviction() {
+    TEST_SECTION("lru_cache CLOCK eviction");
+    {
+        // 单分片，容量 4 个单位
+        my_ptr::lru_cache<int, TestClass> cache(4, 1);
+        for (int i = 0; i < 4; ++i) {
+            cache.put(i, my_ptr::make_shared<TestClass>(i), 1);
+        }
+        auto held = cache.get(0);   // 设置访问位
+        cache.get(2);
+        cache.put(4, my_ptr::make_shared<TestClass>(4), 1);
+
+        // 0 和 2 被访问过，应淘汰 1
+        assert(cache.get(0));
+        assert(!cache.get(1));
+        assert(cache.get(2));
+        assert(cache.get(3));
+        assert(cache.get(4));
+        assert(cache.bytes() <= 4);
+
+        // 被淘汰的值在外部引用释放前保持有效
+        cache.erase(0);
+        cache.put(5, my_ptr::make_shared<TestClass>(5), 4);
+        assert(cache.bytes() <= 4);
+        assert(!cache.get(0));
+        assert(held && held->value == 0);
+    }
+    assert(TestClass::instance_count == 0);
+    std::cout << "success! lru_cache CLOCK eviction\n";
+    return true;
+}
+
+// ============================================================================
+// intern_pool 测试
+// ============================================================================
+bool test_intern_pool_basics() {
+    TEST_SECTION("intern_pool basics");
+    my_ptr::shared_ptr<const std::string> survivor;
+    {
+        my_ptr::intern_pool<std::string> pool(4);
+        auto a = pool.intern(std::string("alpha"));
+        auto b = pool.intern("alpha");
+        auto c = pool.emplace(3, 'x');
+        assert(a.get() == b.get());
+        assert(a.use_count() == 2);
+        assert(*c == "xxx");
+        assert(pool.size() == 2);
+
+        // 最后一个引用释放时条目自动移除
+        c.reset();
+        assert(pool.size() == 1);
+        b.reset();
+        assert(pool.size() == 1);
+        a.reset();
+        assert(pool.size() == 0);
+
+        // 重新驻留得到新对象
+        auto d = pool.intern("alpha");
+        assert(pool.size() == 1);
+        survivor = pool.intern("beta");
+    }
+    // 池先于驻留值析构
+    assert(*survivor == "beta");
+    survivor.reset();
+    std::cout << "success! intern_pool basics\n";
+    return true;
+}
+
+bool test_intern_pool_concurrent() {
+    TEST_SECTION("intern_pool concurrent");
+    {
+        my_ptr::intern_pool<std::string> pool;
+        const int threads = 4;
+        const int rounds = 20000;
+        std::vector<my_ptr::shared_ptr<const std::string>> kept(threads);
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t]() {
+                for (int i = 0; i < rounds; ++i) {
+                    // 频繁地驻留并立即释放，与其它线程的 dispose 交错
+                    auto tag = pool.intern("tag" + std::to_string(i % 16));
+                    assert(*tag == "tag" + std::to_string(i % 16));
+                    if (i % 16 == 0) {
+                        kept[t] = tag;
+                    }
+                }
+            });
+        }
+        for (auto& w : workers) {
+            w.join();
+        }
+        for (int t = 1; t < threads; ++t) {
+            assert(kept[t].get() == kept[0].get());
+        }
+        assert(pool.size() == 1);
+        kept.clear();
+        assert(pool.size() == 0);
+    }
+    std::cout << "success! intern_pool concurrent\n";
+    return true;
+}
+
+// ============================================================================
+// shared_buffer / 别名构造测试
+// ============================================================================
+bool test_aliasing_constructor() {
+    TEST_SECTION("shared_ptr aliasing constructor");
+    {
+        struct Pair {
+            TestClass first{1};
+            TestClass second{2};
+        };
+        my_ptr::shared_ptr<int> alias;
+        {
+            auto owner = my_ptr::make_shared<Pair>();
+            alias = my_ptr::shared_ptr<int>(owner, &owner->second.value);
+            assert(owner.use_count() == 2);
+            Pair *raw = owner.get();
+            my_ptr::shared_ptr<TestClass> moved(std::move(owner), &raw->first);
+            assert(!owner);
+            assert(moved.use_count() == 2);
+            assert(moved->value == 1);
+        }
+        // 别名指针让整个对象保持存活
+        assert(alias.use_count() == 1);
+        assert(*alias == 2);
+        assert(TestClass::instance_count == 2);
+    }
+    assert(TestClass::instance_count == 0);
+    std::cout << "success! shared_ptr aliasing constructor\n";
+    return true;
+}
+
+bool test_shared_buffer_slices() {
+    TEST_SECTION("shared_buffer slices");
+    my_ptr::buffer_slice tail;
+    {
+        my_ptr::shared_buffer buf(std::string_view("GET /index.html HTTP/1.1"));
+        assert(buf.size() == 24);
+        assert(buf.use_count() == 1);
+
+        auto method = buf.slice(0, 3);
+        auto rest = buf.slice(4);
+        auto path = rest.slice(0, 11);
+        assert(method.view() == "GET");
+        assert(path.view() == "/index.html");
+        assert(buf.use_count() == 4);
+
+        // count 超出时截断，offset 越界时抛异常
+        assert(rest.slice(12, 100).view() == "HTTP/1.1");
+        bool threw = false;
+        try {
+            rest.slice(21);
+        } catch (const std::out_of_range&) {
+            threw = true;
+        }
+        assert(threw);
+
+        // 写入底层缓冲对所有切片可见，说明没有拷贝
+        buf.data()[0] = 'P';
+        assert(method.view() == "PET");
+        std::string_view sv = path;
+        assert(sv.data() == buf.data() + 4);
+
+        tail = std::move(rest).slice(12);
+        assert(!rest.data());
+    }
+    // 缓冲由最后一个切片保持存活
+    assert(tail.use_count() == 1);
+    assert(tail.view() == "HTTP/1.1");
+    std::cout << "success! shared_buffer slices\n";
+    return true;
+}
+
+// ============================================================================
+// map_file 测试
+// ============================================================================
+bool test_map_file() {
+    TEST_SECTION("map_file");
+    const std::string path = "map_file_test.tmp";
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << "header:payload-bytes:trailer";
+    }
+    my_ptr::buffer_slice payload;
+    {
+        auto file = my_ptr::map_file(path, my_ptr::map_sequential | my_ptr::map_willneed);
+        assert(file.size() == 28);
+        assert(file.view() == "header:payload-bytes:trailer");
+        payload = file.slice(7, 13);
+        assert(file.use_count() == 2);
+    }
+    // 子切片让映射在原始切片释放后仍然有效
+    assert(payload.use_count() == 1);
+    assert(payload.view() == "payload-bytes");
+    payload = my_ptr::buffer_slice();
+
+    // 空文件返回空切片
+    { std::ofstream out(path, std::ios::binary | std::ios::trunc); }
+    assert(my_ptr::map_file(path).empty());
+    std::remove(path.c_str());
+
+    bool threw = false;
+    try {
+        my_ptr::map_file("no/such/file.bin");
+    } catch (const std::system_error&) {
+        threw = true;
+    }
+    assert(threw);
+    std::cout << "success! map_file\n";
+    return true;
+}
+
+// ============================================================================
+// chunk_reader 测试
+// ============================================================================
+bool test_chunk_reader() {
+    TEST_SECTION("chunk_reader");
+    const std::string path = "chunk_reader_test.tmp";
+    std::string content;
+    for (int i = 0; i < 1000; ++i) {
+        content += "line " + std::to_string(i) + "\n";
+    }
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << content;
+    }
+
+    my_ptr::buffer_slice kept;
+    {
+        my_ptr::chunk_reader reader(path, 1024, 2);
+        assert(reader.chunk_size() == 1024);
+        std::string joined;
+        my_ptr::buffer_slice chunk;
+        int chunks = 0;
+        while (reader.next(chunk)) {
+            assert(chunk.size() <= 1024);
+            joined.append(chunk.data(), chunk.size());
+            if (chunks == 1) {
+                kept = chunk.slice(0, 4);   // 下游保留一个块的一部分
+            }
+            ++chunks;
+        }
+        assert(joined == content);
+        assert(chunks == static_cast<int>((content.size() + 1023) / 1024));
+        assert(!reader.next(chunk));
+
+        // 已释放的块回到池中等待复用
+        chunk = my_ptr::buffer_slice();
+        assert(reader.pooled_chunks() > 0);
+    }
+    // 读取器析构后，被保留的块依然有效
+    assert(kept.view() == content.substr(1024, 4));
+    kept = my_ptr::buffer_slice();
+    {
+        // read_ahead 为 0 时按 1 处理，池的空闲上限也随之按规整后的值计算
+        my_ptr::chunk_reader reader(path, 1024, 0);
+        std::vector<my_ptr::buffer_slice> held;
+        my_ptr::buffer_slice chunk;
+        std::size_t total = 0;
+        while (reader.next(chunk)) {
+            total += chunk.size();
+            held.push_back(std::move(chunk));
+        }
+        assert(total == content.size() && held.size() > 2);
+        held.clear();
+        assert(reader.pooled_chunks() == 2);
+    }
+    std::remove(path.c_str());
+
+    bool threw = false;
+    try {
+        my_ptr::chunk_reader missing("no/such/file.bin");
+    } catch (const std::system_error&) {
+        threw = true;
+    }
+    assert(threw);
+    std::cout << "success! chunk_reader\n";
+    return true;
+}
+
+// ============================================================================
+// buffer_chain 测试
+// ============================================================================
+static std::string chain_to_string(const my_ptr::buffer_chain& chain) {
+    std::string out;
+    chain.for_each_segment([&](const my_ptr::buffer_slice& s) { out.append(s.data(), s.size()); });
+    return out;
+}
+
+bool test_buffer_chain() {
+    TEST_SECTION("buffer_chain");
+    my_ptr::shared_buffer body(std::string_view("payload-bytes"));
+    {
+        my_ptr::buffer_chain chain;
+        chain.append(body.slice());
+        chain.prepend(my_ptr::shared_buffer(std::string_view("HDR:")).slice());
+        chain.append_copy("\r\n", 2);
+        chain.append_copy("--", 2); // 与上一次拷贝相邻，合并为同一段
+        assert(chain.size() == 21);
+        assert(chain.segment_count() == 3);
+        assert(chain_to_string(chain) == "HDR:payload-bytes\r\n--");
+        assert(body.use_count() == 2); // 段共享 body，没有拷贝
+
+        // 拆分跨越段边界时只切片
+        auto front = chain.split(11);
+        assert(chain_to_string(front) == "HDR:payload");
+        assert(chain_to_string(chain) == "-bytes\r\n--");
+        assert(body.use_count() == 3);
+
+        front.append(std::move(chain));
+        assert(chain.empty() && chain.segment_count() == 0);
+        assert(front.size() == 21);
+
+        auto flat = front.coalesce();
+        assert(front.segment_count() == 1);
+        assert(flat.view() == "HDR:payload-bytes\r\n--");
+        assert(body.use_count() == 1);
+
+        bool threw = false;
+        try {
+            front.split(100);
+        } catch (const std::out_of_range&) {
+            threw = true;
+        }
+        assert(threw);
+    }
+#if defined(MY_PTR_HAS_WRITEV)
+    {
+        const std::string path = "buffer_chain_test.tmp";
+        my_ptr::buffer_chain chain;
+        std::string expected;
+        for (int i = 0; i < 200; ++i) {   // 段数超过单次 writev 的批量
+            std::string piece = "segment-" + std::to_string(i) + ";";
+            chain.append(my_ptr::shared_buffer(piece).slice());
+            expected += piece;
+        }
+        iovec iov[4];
+        assert(chain.fill_iovec(iov, 4, 1) == 4);
+        assert(std::string(static_cast<char*>(iov[0].iov_base), iov[0].iov_len) == "segment-1;");
+
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        assert(fd >= 0);
+        chain.write_to(fd);
+        ::close(fd);
+        std::ifstream in(path, std::ios::binary);
+        std::string written((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        assert(written == expected);
+        std::remove(path.c_str());
+    }
+#endif
+    std::cout << "success! buffer_chain\n";
+    return true;
+}
+
+// ============================================================================
+// 序列化测试
+// ============================================================================
+enum class Color : std::uint8_t { red, green, blue };
+
+struct GraphNode {
+    std::string name;
+    std::int64_t weight = 0;
+    double score = 0.0;
+    Color color = Color::red;
+    std::vector<my_ptr::shared_ptr<GraphNode>> children;
+    my_ptr::weak_ptr<GraphNode> parent;
+    my_ptr::unique_ptr<GraphNode> detail;
+
+    template <typename Archive>
+    void serialize(Archive& ar) {
+        ar(name, weight, score, color, children, parent, detail);
+    }
+};
+
+bool test_serialization_graph() {
+    TEST_SECTION("serialization of a shared graph");
+    std::stringstream stream;
+    {
+        // 菱形：root -> a, b；a 和 b 共享 leaf；所有子节点经 weak_ptr 指回父节点
+        auto root = my_ptr::make_shared<GraphNode>();
+        auto a = my_ptr::make_shared<GraphNode>();
+        auto b = my_ptr::make_shared<GraphNode>();
+        auto leaf = my_ptr::make_shared<GraphNode>();
+        root->name = "root";
+        root->weight = -42;
+        root->score = 2.5;
+        root->color = Color::blue;
+        a->name = "a";
+        b->name = "b";
+        leaf->name = "leaf";
+        root->children = {a, b};
+        a->children = {leaf};
+        b->children = {leaf};
+        a->parent = root;
+        b->parent = root;
+        leaf->parent = a;
+        leaf->detail.reset(new GraphNode());
+        leaf->detail->name = "owned";
+
+        my_ptr::output_archive out(stream);
+        out(root);
+        assert(out.objects_written() == 4);
+        out.flush();
+    }
+
+    my_ptr::shared_ptr<GraphNode> root;
+    {
+        my_ptr::input_archive in(stream);
+        in(root);
+        assert(in.objects_read() == 4);
+    }
+    assert(root->name == "root");
+    assert(root->weight == -42);
+    assert(root->score == 2.5);
+    assert(root->color == Color::blue);
+    auto a = root->children[0];
+    auto b = root->children[1];
+    // 共享节点只有一份
+    assert(a->children[0].get() == b->children[0].get());
+    auto leaf = a->children[0];
+    assert(leaf.use_count() == 3);
+    // weak_ptr 回边恢复
+    assert(a->parent.lock().get() == root.get());
+    assert(leaf->parent.lock().get() == a.get());
+    assert(leaf->detail && leaf->detail->name == "owned");
+    assert(!root->detail);
+
+    // 根释放后整张图（含 weak 回边）正常析构
+    my_ptr::weak_ptr<GraphNode> watch = leaf;
+    a.reset();
+    b.reset();
+    leaf.reset();
+    root.reset();
+    assert(watch.expired());
+    std::cout << "success! serialization of a shared graph\n";
+    return true;
+}
+
+struct ChainNode {
+    std::uint32_t value = 0;
+    my_ptr::shared_ptr<ChainNode> next;
+
+    template <typename Archive>
+    void serialize(Archive& ar) {
+        ar(value, next);
+    }
+};
+
+bool test_serialization_deep_and_errors() {
+    TEST_SECTION("serialization of deep chains and bad input");
+    const std::uint32_t length = 200000;
+    std::stringstream stream;
+    {
+        my_ptr::shared_ptr<ChainNode> head;
+        for (std::uint32_t i = 0; i < length; ++i) {
+            auto n = my_ptr::make_shared<ChainNode>();
+            n->value = length - i;
+            n->next = std::move(head);
+            head = std::move(n);
+        }
+        // 两个根指向同一条链：第二个根只写一个 ID
+        my_ptr::output_archive out(stream);
+        out(head, head);
+    }
+    {
+        my_ptr::shared_ptr<ChainNode> first, second;
+        my_ptr::input_archive in(stream);
+        in(first, second);
+        assert(first.get() == second.get());
+        std::uint32_t count = 0;
+        for (ChainNode *n = first.get(); n; n = n->next.get()) {
+            assert(n->value == ++count);
+        }
+        assert(count == length);
+    }
+
+    bool threw = false;
+    try {
+        std::stringstream bad("not an archive");
+        my_ptr::input_archive in(bad);
+    } catch (const my_ptr::serialization_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    // 截断的档案
+    std::stringstream full;
+    {
+        auto n = my_ptr::make_shared<ChainNode>();
+        n->value = 7;
+        my_ptr::output_archive out(full);
+        out(n);
+    }
+    std::string bytes = full.str();
+    std::stringstream truncated(bytes.substr(0, bytes.size() - 1));
+    threw = false;
+    try {
+        my_ptr::shared_ptr<ChainNode> n;
+        my_ptr::input_archive in(truncated);
+        in(n);
+    } catch (const my_ptr::serialization_error&) {
+        threw = true;
+    }
+    assert(threw);
+    std::cout << "success! serialization of deep chains and bad input\n";
+    return true;
+}
+
+struct ViewBase {
+    std::int32_t id = 0;
+
+    template <typename Archive>
+    void serialize(Archive& ar) { ar(id); }
+};
+
+struct ViewDerived : ViewBase {
+    std::string label;
+    std::int64_t extra = 0;
+
+    template <typename Archive>
+    void serialize(Archive& ar) { ar(id, label, extra); }
+};
+
+struct ViewHolder {
+    my_ptr::shared_ptr<ViewDerived> owner;
+    my_ptr::shared_ptr<ViewBase> as_base;      // 同一对象的基类视图
+    my_ptr::shared_ptr<std::int64_t> member;   // 指向成员的别名
+    my_ptr::weak_ptr<std::string> weak_label;  // 指向另一个成员的弱别名
+
+    template <typename Archive>
+    void serialize(Archive& ar) { ar(owner, as_base, member, weak_label); }
+};
+
+struct PolyBase {
+    std::int32_t id = 0;
+    virtual ~PolyBase() = default;
+
+    template <typename Archive>
+    void serialize(Archive& ar) { ar(id); }
+};
+
+struct PolyDerived : PolyBase {
+    std::string name;
+
+    template <typename Archive>
+    void serialize(Archive& ar) { ar(id, name); }
+};
+
+bool test_serialization_views() {
+    TEST_SECTION("serialization of aliasing and base-typed views");
+    std::stringstream stream;
+    {
+        auto d = my_ptr::make_shared<ViewDerived>();
+        d->id = 12;
+        d->label = "derived";
+        d->extra = -99;
+        ViewHolder h;
+        h.owner = d;
+        h.as_base = my_ptr::static_pointer_cast<ViewBase>(d);
+        h.member = my_ptr::shared_ptr<std::int64_t>(d, &d->extra);
+        h.weak_label = my_ptr::shared_ptr<std::string>(d, &d->label);
+        my_ptr::shared_ptr<ViewBase> outer = d; // 另一个根经基类类型到达同一对象
+        my_ptr::output_archive out(stream);
+        out(h, outer);
+        assert(out.objects_written() == 1);
+    }
+    {
+        ViewHolder h;
+        my_ptr::shared_ptr<ViewBase> outer;
+        my_ptr::input_archive in(stream);
+        in(h, outer);
+        assert(in.objects_read() == 1);
+        assert(h.owner->id == 12 && h.owner->label == "derived" && h.owner->extra == -99);
+        // 各视图恢复为同一对象内的指针，并与它共用控制块
+        assert(h.as_base.get() == static_cast<ViewBase*>(h.owner.get()));
+        assert(outer.get() == h.as_base.get());
+        assert(h.member.get() == &h.owner->extra);
+        auto label = h.weak_label.lock();
+        assert(label.get() == &h.owner->label && *label == "derived");
+        my_ptr::weak_ptr<ViewDerived> watch = h.owner;
+        h = ViewHolder();
+        label.reset();
+        assert(!watch.expired()); // outer 与档案仍持有
+        outer.reset();
+    }
+
+    // 先经成员别名、后经所有者到达同一对象：无法还原，保存时报错
+    bool threw = false;
+    try {
+        auto d = my_ptr::make_shared<ViewDerived>();
+        my_ptr::shared_ptr<std::int64_t> member(d, &d->extra);
+        std::stringstream bad;
+        my_ptr::output_archive out(bad);
+        out(member, d);
+    } catch (const my_ptr::serialization_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    // 经基类指针保存多态对象会被切片：保存时报错
+    threw = false;
+    try {
+        my_ptr::shared_ptr<PolyBase> base = my_ptr::make_shared<PolyDerived>();
+        std::stringstream bad;
+        my_ptr::output_archive out(bad);
+        out(base);
+    } catch (const my_ptr::serialization_error&) {
+        threw = true;
+    }
+    assert(threw);
+    threw = false;
+    try {
+        my_ptr::unique_ptr<PolyBase> base(new PolyDerived());
+        std::stringstream bad;
+        my_ptr::output_archive out(bad);
+        out(base);
+    } catch (const my_ptr::serialization_error&) {
+        threw = true;
+    }
+    assert(threw);
+    {
+        // 先经动态类型保存，基类视图随后作为别名写出；档案之后的数据留在流中
+        std::stringstream poly;
+        {
+            auto d = my_ptr::make_shared<PolyDerived>();
+            d->id = 5;
+            d->name = "poly";
+            my_ptr::shared_ptr<PolyBase> base = d;
+            my_ptr::output_archive out(poly);
+            out(d, base);
+        }
+        poly << "tail";
+        my_ptr::shared_ptr<PolyDerived> d;
+        my_ptr::shared_ptr<PolyBase> base;
+        {
+            my_ptr::input_archive in(poly);
+            in(d, base);
+        }
+        assert(d->name == "poly" && base.get() == d.get() && base->id == 5);
+        std::string rest;
+        poly >> rest;
+        assert(rest == "tail");
+    }
+    std::cout << "success! serialization of aliasing and base-typed views\n";
+    return true;
+}
+
+// ============================================================================
+// 快照测试
+// ============================================================================
+bool test_offset_ptr() {
+    TEST_SECTION("offset_ptr");
+    struct Pair {
+        int value;
+        my_ptr::offset_ptr<int> ref;
+    };
+    std::vector<char> block(sizeof(Pair) * 2);
+    Pair *a = new (block.data()) Pair{7, nullptr};
+    Pair *b = new (block.data() + sizeof(Pair)) Pair{9, nullptr};
+    assert(!a->ref);
+    a->ref = &b->value;
+    b->ref = a->ref; // 拷贝按目标地址重算
+    assert(*a->ref == 9 && *b->ref == 9);
+
+    // 整块内存搬移后偏移依然有效
+    std::vector<char> moved(block);
+    Pair *ma = reinterpret_cast<Pair*>(moved.data());
+    Pair *mb = reinterpret_cast<Pair*>(moved.data() + sizeof(Pair));
+    assert(ma->ref.get() == &mb->value);
+    assert(*ma->ref == 9);
+    std::cout << "success! offset_ptr\n";
+    return true;
+}
+
+struct SnapNode {
+    std::uint32_t key;
+    my_ptr::offset_ptr<const SnapNode> left;
+    my_ptr::offset_ptr<const SnapNode> right;
+    my_ptr::offset_ptr<const char> label;
+};
+
+bool test_snapshot_roundtrip() {
+    TEST_SECTION("snapshot roundtrip");
+    const std::string path = "snapshot_test.tmp";
+    {
+        my_ptr::snapshot_builder builder;
+        auto text = builder.create_array<char>(6);
+        std::memcpy(builder[text], "hello", 6);
+        auto left = builder.create<SnapNode>();
+        auto right = builder.create<SnapNode>();
+        auto root = builder.create<SnapNode>();
+        builder[left]->key = 1;
+        builder[right]->key = 3;
+        // 缓冲可能已扩容：在最后一次 create 之后统一取指针赋值
+        SnapNode *r = builder[root];
+        r->key = 2;
+        r->left = builder[left];
+        r->right = builder[right];
+        r->label = builder[text];
+        assert(builder.add_root(root) == 0);
+        assert(builder.add_root(right) == 1);
+        builder.write(path);
+    }
+
+    my_ptr::shared_ptr<const SnapNode> leaf;
+    {
+        auto snap = my_ptr::snapshot::open(path);
+        assert(snap.root_count() == 2);
+        auto root = snap.root<SnapNode>(0);
+        assert(root->key == 2);
+        assert(root->left->key == 1 && root->right->key == 3);
+        assert(std::string(root->label.get()) == "hello");
+        assert(snap.root<SnapNode>(1).get() == root->right.get());
+
+        // 沿偏移指针到达的节点也能以共享所有权交出
+        leaf = snap.share(root->left.get());
+        assert(leaf.use_count() == 3);
+
+        bool threw = false;
+        try {
+            snap.root<SnapNode>(2);
+        } catch (const std::out_of_range&) {
+            threw = true;
+        }
+        assert(threw);
+        // 比整个快照还大的类型：边界检查不能因减法下溢而放行
+        threw = false;
+        try {
+            snap.root<std::array<char, 1 << 16>>(0);
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw);
+    }
+    // 快照对象析构后映射仍由 leaf 持有
+    assert(leaf->key == 1);
+    assert(leaf.use_count() == 1);
+    leaf.reset();
+
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << "definitely not a snapshot file, but long enough";
+    }
+    bool threw = false;
+    try {
+        my_ptr::snapshot::open(path);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    std::remove(path.c_str());
+    std::cout << "success! snapshot roundtrip\n";
+    return true;
+}
+
+// ============================================================================
+// weighted_shared_ptr 测试
+// ============================================================================
+bool test_weighted_shared_ptr() {
+    TEST_SECTION("weighted_shared_ptr");
+    {
+        auto w = my_ptr::make_weighted_shared<TestClass>(800);
+        std::uint64_t total = w.weight();
+        auto c1 = w.split();
+        auto c2 = c1.split();
+        // split 只在句柄之间拆分权重；分权重会修改源句柄，所以不能拷贝
+        static_assert(!std::is_copy_constructible_v<my_ptr::weighted_shared_ptr<TestClass>>, "");
+        assert(w.weight() + c1.weight() + c2.weight() == total);
+        assert(c2->value == 800 && c2.get() == w.get());
+
+        // 权重耗尽后的 split 经间接块继续进行，对象指针不变
+        std::vector<my_ptr::weighted_shared_ptr<TestClass>> fan;
+        for (int i = 0; i < 200; ++i) {
+            fan.push_back(w.split());
+        }
+        for (auto& f : fan) {
+            assert(f.get() == w.get() && f.weight() >= 1);
+        }
+        assert(TestClass::instance_count == 1);
+
+        // 与 shared_ptr 互转
+        my_ptr::shared_ptr<TestClass> sp = fan.back().to_shared();
+        my_ptr::weighted_shared_ptr<TestClass> back(sp);
+        assert(back->value == 800);
+
+        fan.clear();
+        w.reset();
+        c1.reset();
+        c2.reset();
+        back.reset();
+        assert(TestClass::instance_count == 1);
+        assert(sp.unique());
+        sp.reset();
+        assert(TestClass::instance_count == 0);
+    }
+    {
+        // 多线程各自拷贝自己的句柄
+        auto w = my_ptr::make_weighted_shared<TestClass>(1);
+        std::vector<my_ptr::weighted_shared_ptr<TestClass>> roots;
+        for (int t = 0; t < 4; ++t) {
+            roots.push_back(w.split());
+        }
+        std::vector<std::thread> workers;
+        for (int t = 0; t < 4; ++t) {
+            workers.emplace_back([&roots, t]() {
+                for (int i = 0; i < 10000; ++i) {
+                    auto copy = roots[t].split();
+                    assert(copy->value == 1);
+                }
+            });
+        }
+        for (auto& th : workers) {
+            th.join();
+        }
+        roots.clear();
+        my_ptr::weak_ptr<TestClass> watch = w.to_shared();
+        w.reset();
+        assert(watch.expired());
+    }
+    {
+        // 经间接块持有的句柄转出的 shared_ptr 引用原控制块：weak_ptr 跟随对象而不是间接路径
+        auto root = my_ptr::make_weighted_shared<TestClass>(9);
+        auto side = root.split();
+        std::vector<my_ptr::weighted_shared_ptr<TestClass>> chain;
+        for (int i = 0; i < 40; ++i) {
+            chain.push_back(side.split());
+        }
+        my_ptr::weak_ptr<TestClass> watch = side.to_shared();
+        chain.clear();
+        side.reset();
+        assert(!watch.expired() && watch.lock()->value == 9);
+        root.reset();
+        assert(watch.expired() && TestClass::instance_count == 0);
+    }
+    {
+        // 同一个 shared_ptr 换取大量句柄：超过直接发放的上限后经间接块持有，计数不会溢出
+        my_ptr::shared_ptr<TestClass> sp = my_ptr::make_shared<TestClass>(5);
+        my_ptr::weak_ptr<TestClass> watch = sp;
+        std::vector<my_ptr::weighted_shared_ptr<TestClass>> hs;
+        const std::size_t n = 70000;
+        hs.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            hs.emplace_back(sp);
+        }
+        assert(static_cast<std::size_t>(sp.use_count()) < (std::size_t(1) << 41));
+        assert(!sp.unique());
+        sp.reset();
+        assert(!watch.expired() && TestClass::instance_count == 1);
+        for (const auto& h : hs) {
+            assert(h->value == 5);
+        }
+        hs.clear();
+        assert(watch.expired());
+    }
+    assert(TestClass::instance_count == 0);
+    std::cout << "success! weighted_shared_ptr\n";
+    return true;
+}
+
+// ============================================================================
+// deferred_shared_ptr 测试
+// ============================================================================
+bool test_deferred_shared_ptr() {
+    TEST_SECTION("deferred_shared_ptr");
+    my_ptr::deferred_rc::collect_all();
+    {
+        auto d = my_ptr::make_deferred_shared<TestClass>(900);
+        my_ptr::shared_ptr<TestClass> sp = d.to_shared();
+        assert(sp.use_count() == 2);
+
+        // 拷贝只写日志，控制块计数不变
+        std::vector<my_ptr::deferred_shared_ptr<TestClass>> copies(100, d);
+        assert(sp.use_count() == 2);
+        assert(copies.back()->value == 900);
+        my_ptr::deferred_rc::collect();
+        assert(sp.use_count() == 102);
+
+        // 减量推迟一轮才生效
+        copies.clear();
+        d.reset();
+        my_ptr::deferred_rc::collect();
+        assert(sp.use_count() == 102);
+        my_ptr::deferred_rc::collect();
+        assert(sp.use_count() == 1);
+        assert(my_ptr::deferred_rc::pending() == 0);
+
+        // 最后的释放只在日志处理后才销毁对象
+        my_ptr::deferred_shared_ptr<TestClass> back(sp);
+        my_ptr::weak_ptr<TestClass> watch = sp;
+        sp.reset();
+        back.reset();
+        assert(!watch.expired() && TestClass::instance_count == 1);
+        my_ptr::deferred_rc::collect_all();
+        assert(watch.expired() && TestClass::instance_count == 0);
+    }
+    {
+        // 同一轮内拷贝又释放的句柄互相抵消
+        auto d = my_ptr::make_deferred_shared<TestClass>(1);
+        my_ptr::weak_ptr<TestClass> watch = d.to_shared();
+        for (int i = 0; i < 1000; ++i) {
+            auto copy = d;
+            assert(copy->value == 1);
+        }
+        my_ptr::deferred_rc::collect_all();
+        assert(!watch.expired());
+        d.reset();
+        my_ptr::deferred_rc::collect_all();
+        assert(watch.expired());
+    }
+    assert(TestClass::instance_count == 0);
+    std::cout << "success! deferred_shared_ptr\n";
+    return true;
+}
+
+bool test_deferred_rc_threads() {
+    TEST_SECTION("deferred reference counting across threads");
+    struct node {
+        my_ptr::deferred_shared_ptr<node> next;
+        TestClass payload{0};
+    };
+    my_ptr::deferred_rc::set_threshold(256); // 让日志频繁触发自动收集
+    {
+        // 链表的级联释放：销毁节点时产生的减量进入下一轮
+        auto head = my_ptr::make_deferred_shared<node>();
+        for (int i = 0; i < 100; ++i) {
+            auto n = my_ptr::make_deferred_shared<node>();
+            n->next = std::move(head);
+            head = std::move(n);
+        }
+        assert(TestClass::instance_count == 101);
+
+        // 多个线程互相转交拷贝，释放发生在与拷贝不同的线程
+        std::mutex m;
+        std::deque<my_ptr::deferred_shared_ptr<node>> handoff;
+        std::thread producer([&]() {
+            for (int i = 0; i < 20000; ++i) {
+                my_ptr::deferred_shared_ptr<node> copy = head;
+                std::lock_guard<std::mutex> lock(m);
+                handoff.push_back(std::move(copy));
+            }
+        });
+        std::thread consumer([&]() {
+            for (int i = 0; i < 20000;) {
+                my_ptr::deferred_shared_ptr<node> got;
+                {
+                    std::lock_guard<std::mutex> lock(m);
+                    if (handoff.empty()) {
+                        continue;
+                    }
+                    got = std::move(handoff.front());
+                    handoff.pop_front();
+                }
+                assert(got->next);
+                ++i;
+            }
+        });
+        producer.join();
+        consumer.join();
+        // 退出线程遗留的日志由后续收集处理
+        assert(TestClass::instance_count == 101);
+        head.reset();
+        while (TestClass::instance_count != 0) {
+            my_ptr::deferred_rc::collect();
+        }
+    }
+    my_ptr::deferred_rc::set_threshold(4096);
+    std::cout << "success! deferred reference counting across threads\n";
+    return true;
+}
+
+// ============================================================================
+// async_shared_ptr 测试
+// ============================================================================
+struct AsyncFlusher {
+    std::vector<int> pending;
+    std::atomic<int> *flushed;
+    std::thread::id *dispose_thread;
+
+    AsyncFlusher(std::atomic<int> *f, std::thread::id *t) : pending(100, 1), flushed(f), dispose_thread(t) {}
+    ~AsyncFlusher() { assert(pending.empty()); }
+
+    void async_dispose(my_ptr::async_done done) {
+        *dispose_thread = std::this_thread::get_id();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20)); // 模拟刷盘
+        for (int v : pending) {
+            flushed->fetch_add(v);
+        }
+        pending.clear();
+        done();
+    }
+};
+
+bool test_async_shared_ptr() {
+    TEST_SECTION("async_shared_ptr");
+    my_ptr::thread_pool pool(2);
+    std::atomic<int> flushed{0};
+    std::thread::id dispose_thread;
+    {
+        auto p = my_ptr::make_async_shared<AsyncFlusher>(pool, &flushed, &dispose_thread);
+        auto copy = p;
+        my_ptr::weak_ptr<AsyncFlusher> watch = p.shared();
+        assert(p.use_count() == 2);
+
+        // 非最后一个引用：句柄等到所有引用都释放
+        my_ptr::teardown_handle h1 = p.release_async();
+        assert(!h1.wait_for(std::chrono::milliseconds(5)));
+        assert(flushed == 0);
+
+        // 最后一个引用：释放立即返回，收尾在线程池上进行
+        auto start = std::chrono::steady_clock::now();
+        my_ptr::teardown_handle h2 = copy.release_async();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        assert(elapsed < std::chrono::milliseconds(20));
+        assert(watch.expired());
+        h2.wait();
+        assert(h1.done() && h2.done());
+        assert(flushed == 100);
+        assert(dispose_thread != std::this_thread::get_id());
+    }
+    {
+        // wait_until_expired 等到异步收尾完成、对象析构之后才返回
+        auto p = my_ptr::make_async_shared<AsyncFlusher>(pool, &flushed, &dispose_thread);
+        my_ptr::weak_ptr<AsyncFlusher> watch = p.shared();
+        p.reset();
+        assert(watch.expired()); // 已不能再 lock
+        watch.wait_until_expired();
+        assert(flushed == 200);
+        assert(watch.wait_until_expired_for(std::chrono::milliseconds(1)));
+    }
+    {
+        // 收尾完成回调在另一个线程上调用
+        struct Relay {
+            my_ptr::thread_pool *pool;
+            std::atomic<bool> *destroyed;
+            Relay(my_ptr::thread_pool *p, std::atomic<bool> *d) : pool(p), destroyed(d) {}
+            ~Relay() { *destroyed = true; }
+            void async_dispose(my_ptr::async_done done) {
+                pool->post([d = my_ptr::make_shared<my_ptr::async_done>(std::move(done))]() { (*d)(); });
+            }
+        };
+        std::atomic<bool> destroyed{false};
+        auto p = my_ptr::make_async_shared<Relay>(pool, &pool, &destroyed);
+        my_ptr::teardown_handle h = p.teardown();
+        assert(!h.done());
+        p.reset();
+        assert(h.wait_for(std::chrono::seconds(5)));
+        assert(destroyed);
+    }
+    {
+        // 未调用 done() 就丢弃回调，同样视为完成
+        struct Forgetful {
+            TestClass payload{7};
+            void async_dispose(my_ptr::async_done) {}
+        };
+        auto p = my_ptr::make_async_shared<Forgetful>(pool);
+        assert(TestClass::instance_count == 1);
+        p.release_async().wait();
+        assert(TestClass::instance_count == 0);
+    }
+    std::cout << "success! async_shared_ptr\n";
+    return true;
+}
+
+// ============================================================================
+// foreign_ptr 测试
+// ============================================================================
+struct HomeChecked {
+    std::thread::id home = std::this_thread::get_id();
+    int value;
+    explicit HomeChecked(int v) : value(v) { ++instances; }
+    ~HomeChecked() {
+        assert(std::this_thread::get_id() == home); // 只在所属线程上释放
+        --instances;
+    }
+    static std::atomic<int> instances;
+};
+std::atomic<int> HomeChecked::instances{0};
+
+bool test_foreign_ptr() {
+    TEST_SECTION("foreign_ptr");
+    {
+        // 没有分片的线程不能创建 foreign_ptr
+        bool thrown = false;
+        std::thread([&]() {
+            try {
+                my_ptr::make_foreign(my_ptr::make_unique<HomeChecked>(1));
+            } catch (const std::logic_error&) {
+                thrown = true;
+            }
+        }).join();
+        assert(thrown);
+    }
+    my_ptr::shard home;
+    assert(my_ptr::shard::current() == &home);
+    {
+        // 在所属分片上释放：就地执行
+        auto f = my_ptr::make_foreign(my_ptr::make_unique<HomeChecked>(2));
+        assert(f->value == 2 && f.home() == &home);
+        f.reset();
+        assert(HomeChecked::instances == 0);
+    }
+    {
+        // 在其它线程释放：进入收件箱，由所属线程 poll 时执行
+        auto f = my_ptr::make_foreign(my_ptr::make_unique<HomeChecked>(3));
+        auto g = my_ptr::make_foreign(my_ptr::make_shared<HomeChecked>(4));
+        std::thread([f = std::move(f), g = std::move(g)]() mutable {
+            assert(f->value == 3 && g->value == 4);
+            f.reset();
+            bool thrown = false;
+            try {
+                g.release();
+            } catch (const std::logic_error&) {
+                thrown = true;
+            }
+            assert(thrown);
+        }).join(); // g 随 lambda 在另一线程销毁
+        assert(HomeChecked::instances == 2);
+        assert(!home.inbox_empty());
+        assert(home.poll() == 2);
+        assert(HomeChecked::instances == 0);
+        assert(home.poll() == 0);
+    }
+    {
+        // 在所属分片上取回原指针
+        auto f = my_ptr::make_foreign(my_ptr::make_unique<HomeChecked>(5));
+        my_ptr::unique_ptr<HomeChecked> back = f.release();
+        assert(!f && back->value == 5);
+    }
+    assert(HomeChecked::instances == 0);
+    std::cout << "success! foreign_ptr\n";
+    return true;
+}
+
+bool test_foreign_ptr_shards() {
+    TEST_SECTION("foreign_ptr across shards");
+    const int shards = 3;
+    const int messages = 2000;
+    struct mailbox {
+        std::mutex m;
+        std::vector<my_ptr::foreign_ptr<my_ptr::unique_ptr<HomeChecked>>> items;
+    };
+    std::vector<mailbox> boxes(shards);
+    std::atomic<int> received{0};
+    std::vector<std::thread> threads;
+    for (int s = 0; s < shards; ++s) {
+        threads.emplace_back([&, s]() {
+            my_ptr::shard self;
+            int got = 0;
+            for (int i = 0; i < messages || got < messages; ++i) {
+                if (i < messages) {
+                    auto msg = my_ptr::make_foreign(my_ptr::make_unique<HomeChecked>(s));
+                    std::lock_guard<std::mutex> lock(boxes[(s + 1) % shards].m);
+                    boxes[(s + 1) % shards].items.push_back(std::move(msg));
+                }
+                std::vector<my_ptr::foreign_ptr<my_ptr::unique_ptr<HomeChecked>>> batch;
+                {
+                    std::lock_guard<std::mutex> lock(boxes[s].m);
+                    batch.swap(boxes[s].items);
+                }
+                for (auto& m : batch) {
+                    assert(m->value == (s + shards - 1) % shards);
+                }
+                got += static_cast<int>(batch.size());
+                batch.clear(); // 释放回发送方分片
+                self.poll();
+                if (i >= messages) {
+                    std::this_thread::yield();
+                }
+            }
+            received += got;
+            // 等待自己发出的消息全部被释放回来
+            while (HomeChecked::instances != 0) {
+                self.poll();
+                std::this_thread::yield();
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    assert(received == shards * messages);
+    assert(HomeChecked::instances == 0);
+    {
+        // 释放项还攒在其它分片的发件箱里时，所属分片的析构要等它送达
+        std::atomic<int> stage{0};
+        my_ptr::foreign_ptr<my_ptr::unique_ptr<HomeChecked>> handoff;
+        std::thread home_thread([&]() {
+            {
+                my_ptr::shard home;
+                handoff = my_ptr::make_foreign(my_ptr::make_unique<HomeChecked>(7));
+                stage = 1;
+                while (stage != 2) {
+                    std::this_thread::yield();
+                }
+                assert(home.outstanding() == 1);
+            } // ~shard 等待 other 分片投递
+            stage = 3;
+        });
+        std::thread other_thread([&]() {
+            my_ptr::shard other;
+            while (stage != 1) {
+                std::this_thread::yield();
+            }
+            handoff.reset(); // 只进入本分片的发件箱
+            stage = 2;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            assert(HomeChecked::instances == 1 && stage == 2);
+            other.flush();
+        });
+        home_thread.join();
+        other_thread.join();
+        assert(HomeChecked::instances == 0);
+    }
+    std::cout << "success! foreign_ptr across shards\n";
+    return true;
+}
+
+// ============================================================================
+// slot_map 测试
+// ============================================================================
+bool test_slot_map() {
+    TEST_SECTION("slot_map");
+    {
+        my_ptr::slot_map<TestClass> map;
+        auto a = map.emplace(1);
+        auto b = map.insert(TestClass(2));
+        assert(map.size() == 2 && TestClass::instance_count == 2);
+        assert(map.get(a)->value == 1 && map.get(b)->value == 2);
+        assert(!map.get(my_ptr::slot_handle64{}));
+
+        // 删除后旧句柄失效，槽被复用时代数不同
+        TestClass *addr = map.get(a);
+        assert(map.erase(a));
+        assert(!map.erase(a));
+        assert(!map.contains(a) && TestClass::instance_count == 1);
+        auto c = map.emplace(3);
+        assert(c.index() == a.index() && c != a);
+        assert(!map.get(a) && map.get(c) == addr);
+
+        // 遍历只经过存活对象
+        for (int i = 10; i < 10000; ++i) {
+            map.emplace(i);
+        }
+        int live = 0;
+        long long sum = 0;
+        map.for_each([&](my_ptr::slot_handle64 h, TestClass& v) {
+            assert(map.get(h) == &v);
+            ++live;
+            sum += v.value;
+        });
+        assert(live == static_cast<int>(map.size()) && sum == 2 + 3 + (10 + 9999) * 9990LL / 2);
+
+        // 元素地址在扩容时保持不变
+        assert(map.get(b)->value == 2);
+        map.clear();
+        assert(map.empty() && TestClass::instance_count == 0);
+        assert(!map.get(b));
+    }
+    {
+        // 32 位句柄
+        my_ptr::slot_map<int, std::uint32_t> map;
+        static_assert(sizeof(my_ptr::slot_handle32) == 4, "32-bit handle");
+        std::vector<my_ptr::slot_handle32> handles;
+        for (int i = 0; i < 100; ++i) {
+            handles.push_back(map.insert(i));
+        }
+        for (int i = 0; i < 100; i += 2) {
+            map.erase(handles[i]);
+        }
+        for (int i = 0; i < 100; ++i) {
+            assert((map.get(handles[i]) != nullptr) == (i % 2 == 1));
+        }
+    }
+    {
+        // 转换为 shared_ptr：持有者让 map 的存储活得比 map 的其它引用更久
+        auto map = my_ptr::make_shared<my_ptr::slot_map<TestClass>>();
+        auto h = map->emplace(42);
+        my_ptr::shared_ptr<TestClass> sp = my_ptr::share_slot(map, h);
+        assert(sp->value == 42 && map.use_count() == 2);
+        map.reset();
+        assert(sp->value == 42 && TestClass::instance_count == 1);
+        sp.reset();
+        assert(TestClass::instance_count == 0);
+    }
+    {
+        // erase 立即使句柄失效，但对象活到最后一个 share_slot 持有者释放；之后槽被复用
+        auto map = my_ptr::make_shared<my_ptr::slot_map<TestClass>>();
+        auto h = map->emplace(43);
+        auto sp1 = my_ptr::share_slot(map, h);
+        auto sp2 = my_ptr::share_slot(map, h);
+        assert(map->erase(h));
+        assert(!map->contains(h) && map->empty());
+        assert(!my_ptr::share_slot(map, h));
+        assert(sp1->value == 43 && TestClass::instance_count == 1);
+        auto other = map->emplace(44); // 待回收的槽尚不能复用
+        assert(other.index() != h.index());
+        sp1.reset();
+        assert(sp2->value == 43 && TestClass::instance_count == 2);
+        sp2.reset();
+        assert(TestClass::instance_count == 1);
+        assert(map->erase(other));
+        auto reused = map->emplace(45);
+        auto reused2 = map->emplace(46);
+        assert(reused.index() == h.index() || reused2.index() == h.index());
+        map.reset();
+        assert(TestClass::instance_count == 0);
+    }
+    {
+        // get 与写者并发：读者只检查句柄是否有效，写者不断删除、插入并扩容
+        my_ptr::slot_map<int> map;
+        std::vector<my_ptr::slot_handle64> handles;
+        for (int i = 0; i < 1000; ++i) {
+            handles.push_back(map.emplace(i));
+        }
+        std::atomic<bool> stop{false};
+        std::thread reader([&]() {
+            while (!stop.load()) {
+                for (int i = 0; i < 1000; ++i) {
+                    if (const int *p = map.get(handles[i])) {
+                        assert(*p == i);
+                    }
+                }
+            }
+        });
+        for (int i = 0; i < 1000; i += 2) {
+            map.erase(handles[i]);
+        }
+        for (int i = 0; i < 50000; ++i) {
+            map.emplace(-1);
+        }
+        stop = true;
+        reader.join();
+        for (int i = 0; i < 1000; ++i) {
+            assert(map.contains(handles[i]) == (i % 2 == 1));
+        }
+    }
+    std::cout << "success! slot_map\n";
+    return true;
+}
+
+// ============================================================================
+// compacting_arena 测试
+// ============================================================================
+// 记录自身地址的对象：搬移后由 after_relocate() 修正
+struct SelfTracking {
+    int value;
+    SelfTracking *self;
+    int relocations;
+
+    explicit SelfTracking(int v) noexcept : value(v), self(this), relocations(0) {}
+    SelfTracking(SelfTracking&& other) noexcept : value(other.value), self(nullptr), relocations(other.relocations) {}
+    void after_relocate() noexcept {
+        self = this;
+        ++relocations;
+    }
+};
+
+bool test_compacting_arena() {
+    TEST_SECTION("compacting_arena");
+    {
+        // 创建、访问、销毁与失效句柄
+        my_ptr::compacting_arena<int> arena(4096);
+        auto a = arena.create(1);
+        auto b = arena.create(2);
+        assert(arena.size() == 2 && *arena.pin(a) == 1 && *arena.pin(b) == 2);
+        assert(arena.destroy(a) && !arena.destroy(a));
+        assert(!arena.pin(a) && !arena.pin(my_ptr::slot_handle64{}));
+        auto c = arena.create(3);
+        assert(c.index() == a.index() && c != a && !arena.pin(a) && *arena.pin(c) == 3);
+    }
+    {
+        // 稀疏的块被整理腾空并归还，对象值与句柄保持有效，搬移钩子被调用
+        my_ptr::compacting_arena<SelfTracking> arena(4096);
+        std::vector<my_ptr::slot_handle64> handles;
+        for (int i = 0; i < 5000; ++i) {
+            handles.push_back(arena.create(i));
+        }
+        std::size_t full_chunks = arena.chunk_count();
+        for (int i = 0; i < 5000; ++i) {
+            if (i % 10 != 0) {
+                arena.destroy(handles[i]);
+            }
+        }
+        assert(arena.size() == 500 && arena.chunk_count() == full_chunks && arena.occupancy() < 0.2);
+
+        // 被钉住的对象不会搬移
+        auto pinned = arena.pin(handles[0]);
+        SelfTracking *pinned_addr = pinned.get();
+        // 增量：每一步只搬移有限个对象
+        assert(arena.compact_step(7) == 7);
+        std::size_t moved = 7 + arena.compact();
+        assert(moved > 0 && arena.compact() == 0);
+        assert(arena.chunk_count() < full_chunks / 4 && arena.occupancy() > 0.5);
+        assert(pinned.get() == pinned_addr && pinned->relocations == 0);
+        pinned = my_ptr::arena_pin<SelfTracking>();
+
+        int relocated = 0;
+        for (int i = 0; i < 5000; i += 10) {
+            auto p = arena.pin(handles[i]);
+            assert(p && p->value == i && p->self == p.get());
+            relocated += p->relocations;
+        }
+        assert(relocated == static_cast<int>(moved));
+        for (int i = 1; i < 5000; i += 10) {
+            assert(!arena.pin(handles[i]));
+        }
+    }
+    {
+        // 可平凡拷贝的类型按字节搬移；析构释放剩余对象
+        my_ptr::compacting_arena<std::array<long, 8>> arena(4096);
+        std::vector<my_ptr::slot_handle64> handles;
+        for (long i = 0; i < 2000; ++i) {
+            handles.push_back(arena.create(std::array<long, 8>{i, i * 2}));
+        }
+        for (std::size_t i = 0; i < handles.size(); i += 2) {
+            arena.destroy(handles[i]);
+        }
+        arena.compact();
+        for (std::size_t i = 1; i < handles.size(); i += 2) {
+            auto p = arena.pin(handles[i]);
+            assert((*p)[0] == static_cast<long>(i) && (*p)[1] == static_cast<long>(i) * 2);
+        }
+    }
+    {
+        // 整理与访问并发：读线程持续钉住对象读取，值始终一致
+        my_ptr::compacting_arena<SelfTracking> arena(4096);
+        std::vector<my_ptr::slot_handle64> handles;
+        for (int i = 0; i < 20000; ++i) {
+            handles.push_back(arena.create(i));
+        }
+        for (int i = 0; i < 20000; ++i) {
+            if (i % 4 != 0) arena.destroy(handles[i]);
+        }
+        std::atomic<bool> stop{false};
+        std::atomic<long> reads{0};
+        std::thread reader([&]() {
+            while (!stop.load()) {
+                for (int i = 0; i < 20000; i += 4) {
+                    auto p = arena.pin(handles[i]);
+                    assert(p && p->value == i && p->self == p.get());
+                }
+                ++reads;
+            }
+        });
+        while (arena.compact_step(64) != 0) {
+            std::this_thread::yield();
+        }
+        while (reads.load() < 2) {
+            std::this_thread::yield();
+        }
+        stop = true;
+        reader.join();
+        assert(arena.occupancy() > 0.5);
+    }
+    std::cout << "success! compacting_arena\n";
+    return true;
+}
+
+// ============================================================================
+// skiplist_map 测试
+// ============================================================================
+bool test_skiplist_map() {
+    TEST_SECTION("skiplist_map");
+    {
+        my_ptr::skiplist_map<int, TestClass> map;
+        assert(map.put(5, my_ptr::make_shared<TestClass>(50)));
+        assert(map.emplace(1, 10) && map.emplace(3, 30));
+        assert(map.size() == 3 && map.get(3)->value == 30 && !map.get(2) && !map.contains(4));
+
+        // 替换：旧值在读者手中仍然有效
+        auto old = map.get(5);
+        assert(!map.put(5, my_ptr::make_shared<TestClass>(55)));
+        assert(old->value == 50 && map.get(5)->value == 55 && map.size() == 3);
+
+        // 删除返回被删的值，之后查不到
+        auto removed = map.remove(1);
+        assert(removed && removed->value == 10 && !map.get(1) && !map.remove(1) && map.size() == 2);
+
+        for (int k = 100; k > 10; --k) {
+            map.emplace(k, k);
+        }
+        // 范围遍历按键序，区间左闭右开
+        std::vector<int> keys;
+        std::size_t n = map.scan(20, 25, [&](int k, const my_ptr::shared_ptr<TestClass>& v) {
+            assert(v->value == k);
+            keys.push_back(k);
+        });
+        assert(n == 5 && keys == std::vector<int>({20, 21, 22, 23, 24}));
+        int prev = -1, count = 0;
+        map.for_each([&](int k, const my_ptr::shared_ptr<TestClass>&) {
+            assert(k > prev);
+            prev = k;
+            ++count;
+        });
+        assert(count == 92 && static_cast<std::size_t>(count) == map.size());
+    }
+    // 摘下的节点与值经纪元回收释放
+    my_ptr::detail::epoch_synchronize();
+    assert(TestClass::instance_count == 0);
+    {
+        // 自定义比较器
+        my_ptr::skiplist_map<std::string, int, std::greater<std::string>> map;
+        map.emplace("a", 1);
+        map.emplace("c", 3);
+        map.emplace("b", 2);
+        std::string order;
+        map.for_each([&](const std::string& k, const my_ptr::shared_ptr<int>&) { order += k; });
+        assert(order == "cba");
+    }
+    std::cout << "success! skiplist_map\n";
+    return true;
+}
+
+bool test_skiplist_map_concurrent() {
+    TEST_SECTION("skiplist_map concurrent");
+    {
+        const int threads = 4;
+        const int keys = 2000;
+        const int ops = 40000;
+        my_ptr::skiplist_map<int, TestClass> map;
+        std::atomic<bool> stop{false};
+
+        // 扫描线程：并发修改期间看到的键始终严格递增，值与键一致
+        std::thread scanner([&]() {
+            while (!stop.load()) {
+                int prev = -1;
+                map.scan(0, keys, [&](int k, const my_ptr::shared_ptr<TestClass>& v) {
+                    assert(k > prev && v->value % keys == k);
+                    prev = k;
+                });
+            }
+        });
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t]() {
+                std::mt19937 rng(t);
+                for (int i = 0; i < ops; ++i) {
+                    int k = static_cast<int>(rng() % keys);
+                    switch (rng() % 3) {
+                    case 0:
+                        map.emplace(k, k + keys * (t + 1));
+                        break;
+                    case 1:
+                        if (auto v = map.remove(k)) assert(v->value % keys == k);
+                        break;
+                    default:
+                        if (auto v = map.get(k)) assert(v->value % keys == k);
+                    }
+                }
+            });
+        }
+        for (auto& w : workers) w.join();
+        stop = true;
+        scanner.join();
+
+        // 静止后 size 精确，与遍历结果一致
+        std::size_t counted = map.for_each([](int, const my_ptr::shared_ptr<TestClass>&) {});
+        assert(counted == map.size());
+        for (int k = 0; k < keys; ++k) {
+            assert(map.contains(k) == (map.scan(k, k + 1, [](int, const my_ptr::shared_ptr<TestClass>&) {}) == 1));
+        }
+    }
+    {
+        // 同一个键上的并发 put 与 remove：单个写者依次写入 0..puts-1，
+        // 每个值恰好有一个去处——被 remove 取走、被下一次 put 覆盖（返回 false），或最后仍在表中
+        const int puts = 100000;
+        my_ptr::skiplist_map<int, int> map;
+        std::vector<char> overwritten(puts, 0);
+        std::vector<int> hits(puts, 0);
+        std::atomic<bool> done{false};
+        std::vector<std::vector<int>> removed(2);
+        std::vector<std::thread> removers;
+        for (auto& out : removed) {
+            removers.emplace_back([&map, &done, &out]() {
+                while (!done.load()) {
+                    if (auto v = map.remove(0)) out.push_back(*v);
+                }
+            });
+        }
+        for (int i = 0; i < puts; ++i) {
+            overwritten[i] = !map.put(0, my_ptr::make_shared<int>(i));
+        }
+        done = true;
+        for (auto& r : removers) r.join();
+        for (auto& out : removed) {
+            for (int v : out) ++hits[v];
+        }
+        if (auto v = map.get(0)) ++hits[*v];
+        for (int i = 0; i + 1 < puts; ++i) {
+            hits[i] += overwritten[i + 1];
+        }
+        for (int i = 0; i < puts; ++i) {
+            assert(hits[i] == 1);
+        }
+    }
+    my_ptr::detail::epoch_synchronize();
+    assert(TestClass::instance_count == 0);
+    std::cout << "success! skiplist_map concurrent\n";
+    return true;
+}
+
+// ============================================================================
+// observer_list 测试
+// ============================================================================
+bool test_observer_list() {
+    TEST_SECTION("observer_list");
+    {
+        my_ptr::observer_list<TestClass> list;
+        std::vector<my_ptr::shared_ptr<TestClass>> owners;
+        for (int i = 0; i < 100; ++i) {
+            owners.push_back(my_ptr::make_shared<TestClass>(i));
+        }
+        list.add(owners.begin(), owners.end());
+        auto extra = my_ptr::make_shared<TestClass>(1000);
+        list.add(extra);
+        assert(list.size() == 101);
+
+        long sum = 0;
+        assert(list.dispatch([&](TestClass& t) { sum += t.value; }) == 101 && sum == 99 * 100 / 2 + 1000);
+
+        // 注销
+        assert(list.remove(extra) && !list.remove(extra) && list.size() == 100);
+
+        // 失效项被跳过；数量未达阈值时不整理
+        for (int i = 0; i < 10; ++i) owners[i].reset();
+        assert(list.dispatch([](TestClass&) {}) == 90 && list.expired_hint() == 10 && list.size() == 100);
+        assert(list.compact() == 10 && list.size() == 90);
+
+        // 达到阈值（至少 1/8 且至少 16 项）后 dispatch 自动整理
+        for (int i = 10; i < 40; ++i) owners[i].reset();
+        assert(list.dispatch([](TestClass&) {}) == 60 && list.size() == 60);
+
+        // 监听者在回调中释放自身、登记新监听者都是安全的
+        auto late = my_ptr::make_shared<TestClass>(-1);
+        int calls = 0;
+        list.dispatch([&](TestClass& t) {
+            ++calls;
+            if (t.value == 40) {
+                owners[40].reset();
+                list.add(late);
+            }
+        });
+        assert(calls == 60 && list.size() == 61); // 40 号在回调期间被本批的强引用保活
+        assert(list.dispatch([](TestClass&) {}) == 60);
+
+        // 回调抛出时已加的强引用全部归还
+        bool thrown = false;
+        try {
+            list.dispatch([](TestClass& t) {
+                if (t.value == 50) throw std::runtime_error("listener failed");
+            });
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown && owners[50].use_count() == 1);
+    }
+    my_ptr::detail::epoch_synchronize();
+    assert(TestClass::instance_count == 0);
+    {
+        // 并发：一个线程持续 dispatch，另一个线程增删监听者
+        my_ptr::observer_list<TestClass> list;
+        std::atomic<bool> stop{false};
+        std::atomic<long> dispatched{0};
+        std::thread dispatcher([&]() {
+            while (!stop.load()) {
+                dispatched += static_cast<long>(list.dispatch([](TestClass& t) { assert(t.value >= 0); }));
+            }
+        });
+        std::vector<my_ptr::shared_ptr<TestClass>> owners;
+        for (int round = 0; round < 200; ++round) {
+            owners.push_back(my_ptr::make_shared<TestClass>(round));
+            list.add(owners.back());
+            if (round % 3 == 0) owners[round / 2].reset();
+            if (round % 7 == 0) list.remove(owners[round / 3]);
+        }
+        stop = true;
+        dispatcher.join();
+        owners.clear();
+        assert(list.dispatch([](TestClass&) {}) == 0);
+    }
+    my_ptr::detail::epoch_synchronize();
+    assert(TestClass::instance_count == 0);
+    std::cout << "success! observer_list\n";
+    return true;
+}
+
+// ============================================================================
+// 批量 weak_ptr 操作测试
+// ============================================================================
+bool test_bulk_weak() {
+    TEST_SECTION("bulk weak_ptr ops");
+    std::vector<my_ptr::shared_ptr<TestClass>> owners;
+    std::vector<my_ptr::weak_ptr<TestClass>> refs;
+    for (int i = 0; i < 1000; ++i) {
+        owners.push_back(my_ptr::make_shared<TestClass>(i));
+        refs.push_back(owners.back());
+        if (i % 7 == 0) refs.emplace_back(); // 空的 weak_ptr 视为失效
+    }
+    for (int i = 0; i < 1000; i += 3) {
+        owners[i].reset();
+    }
+
+    // 每种实现（CPU 不支持时自动退回标量）都与逐个 expired() 一致，包括不足 64 的尾部
+    for (auto isa : {my_ptr::detail::bulk_isa::scalar, my_ptr::detail::bulk_isa::avx2,
+                     my_ptr::detail::bulk_isa::avx512}) {
+        for (std::size_t n : {std::size_t(0), std::size_t(5), std::size_t(64), refs.size()}) {
+            my_ptr::bitmap dead;
+            std::size_t expired = my_ptr::bulk_expired(refs.data(), n, dead, isa);
+            assert(dead.size() == n && dead.count() == expired);
+            for (std::size_t i = 0; i < n; ++i) {
+                assert(dead.test(i) == refs[i].expired());
+            }
+        }
+    }
+
+    std::vector<my_ptr::shared_ptr<TestClass>> locked;
+    std::size_t n = my_ptr::bulk_lock(refs, locked);
+    assert(locked.size() == refs.size());
+    std::size_t live = 0;
+    for (std::size_t i = 0; i < refs.size(); ++i) {
+        assert(static_cast<bool>(locked[i]) == !refs[i].expired());
+        if (locked[i]) {
+            assert(locked[i].get() == refs[i].lock().get());
+            ++live;
+        }
+    }
+    assert(n == live && n == 1000 - 334);
+    assert(owners[1].use_count() == 2);
+    locked.clear();
+    assert(owners[1].use_count() == 1);
+    std::cout << "success! bulk weak_ptr ops (" << my_ptr::detail::bulk_isa_name(my_ptr::detail::detect_bulk_isa())
+              << ")\n";
+    return true;
+}
+
+// ============================================================================
+// 指针转换测试
+// ============================================================================
+struct CastBase {
+    int tag = 0;
+    virtual ~CastBase() = default;
+};
+struct CastLeft : virtual CastBase {
+    int left = 1;
+};
+struct CastRight : virtual CastBase {
+    int right = 2;
+};
+struct CastDiamond : CastLeft, CastRight {
+    int diamond = 3;
+};
+struct CastOther : CastBase {
+    int other = 4;
+};
+
+bool test_pointer_casts() {
+    TEST_SECTION("pointer casts");
+    {
+        // static/const/dynamic_pointer_cast 共享控制块
+        my_ptr::shared_ptr<CastOther> other = my_ptr::make_shared<CastOther>();
+        my_ptr::shared_ptr<CastBase> base = my_ptr::static_pointer_cast<CastBase>(other);
+        assert(base.get() == other.get() && other.use_count() == 2);
+        auto back = my_ptr::static_pointer_cast<CastOther>(base);
+        assert(back->other == 4 && other.use_count() == 3);
+        my_ptr::shared_ptr<const CastOther> c = back;
+        assert(my_ptr::const_pointer_cast<CastOther>(c) == other);
+        assert(my_ptr::dynamic_pointer_cast<CastOther>(base) == other);
+        assert(!my_ptr::dynamic_pointer_cast<CastDiamond>(base) && other.use_count() == 4);
+    }
+    {
+        // 带缓存的转换在各种动态类型、各个子对象上的结果与 dynamic_cast 一致
+        std::vector<my_ptr::shared_ptr<CastBase>> objects;
+        for (int i = 0; i < 30; ++i) {
+            switch (i % 3) {
+            case 0: objects.push_back(my_ptr::make_shared<CastDiamond>()); break;
+            case 1: objects.push_back(my_ptr::make_shared<CastOther>()); break;
+            default: objects.push_back(my_ptr::make_shared<CastLeft>());
+            }
+        }
+        for (int round = 0; round < 3; ++round) { // 第一轮填充缓存，之后命中
+            for (auto& o : objects) {
+                assert(my_ptr::cached_dynamic_pointer_cast<CastDiamond>(o).get() == dynamic_cast<CastDiamond*>(o.get()));
+                assert(my_ptr::cached_dynamic_pointer_cast<CastRight>(o).get() == dynamic_cast<CastRight*>(o.get()));
+                assert(my_ptr::cached_dynamic_pointer_cast<CastOther>(o).get() == dynamic_cast<CastOther*>(o.get()));
+                // 从非首个基类子对象出发（交叉转换）
+                if (auto left = my_ptr::dynamic_pointer_cast<CastLeft>(o)) {
+                    assert(my_ptr::cached_dynamic_cast<CastRight>(left.get()) == dynamic_cast<CastRight*>(left.get()));
+                }
+            }
+        }
+        const CastBase *cb = objects[0].get();
+        assert(my_ptr::cached_dynamic_cast<const CastDiamond>(cb)->diamond == 3);
+        assert(!my_ptr::cached_dynamic_cast<CastDiamond>(static_cast<CastBase*>(nullptr)));
+
+        // 右值版本接管引用：计数不变，源被置空；失败时源保持不变
+        my_ptr::shared_ptr<CastBase> src = objects[0];
+        assert(objects[0].use_count() == 2);
+        auto miss = my_ptr::cached_dynamic_pointer_cast<CastOther>(std::move(src));
+        assert(!miss && src && objects[0].use_count() == 2);
+        auto hit = my_ptr::cached_dynamic_pointer_cast<CastDiamond>(std::move(src));
+        assert(hit && !src && hit->diamond == 3 && objects[0].use_count() == 2);
+        auto plain = my_ptr::dynamic_pointer_cast<CastLeft>(std::move(hit));
+        assert(plain && !hit && plain->left == 1 && objects[0].use_count() == 2);
+    }
+    std::cout << "success! pointer casts\n";
+    return true;
+}